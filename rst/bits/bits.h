@@ -0,0 +1,74 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef RST_BITS_BITS_H_
+#define RST_BITS_BITS_H_
+
+#include <cstdint>
+
+#include "rst/check/check.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace rst {
+
+// Returns the index of the lowest set bit of non-zero |value|.
+inline int CountTrailingZeros(const uint32_t value) {
+  RST_DCHECK(value != 0);
+#if defined(_MSC_VER)
+  unsigned long index = 0;  // NOLINT(runtime/int)
+  _BitScanForward(&index, value);
+  return static_cast<int>(index);
+#else
+  return __builtin_ctz(value);
+#endif
+}
+
+// Returns the number of zero bits above the highest set bit of non-zero
+// |value|.
+inline int CountLeadingZeros(const uint64_t value) {
+  RST_DCHECK(value != 0);
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+  unsigned long index = 0;  // NOLINT(runtime/int)
+  _BitScanReverse64(&index, value);
+  return 63 - static_cast<int>(index);
+#elif defined(_MSC_VER)
+  unsigned long index = 0;  // NOLINT(runtime/int)
+  if (_BitScanReverse(&index, static_cast<uint32_t>(value >> 32)))
+    return 31 - static_cast<int>(index);
+  _BitScanReverse(&index, static_cast<uint32_t>(value));
+  return 63 - static_cast<int>(index);
+#else
+  return __builtin_clzll(value);
+#endif
+}
+
+}  // namespace rst
+
+#endif  // RST_BITS_BITS_H_
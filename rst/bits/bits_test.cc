@@ -0,0 +1,51 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/bits/bits.h"
+
+#include <cstdint>
+
+#include <gtest/gtest.h>
+
+namespace rst {
+
+TEST(Bits, CountTrailingZeros) {
+  EXPECT_EQ(CountTrailingZeros(uint32_t{1}), 0);
+  EXPECT_EQ(CountTrailingZeros(uint32_t{0x18}), 3);
+  EXPECT_EQ(CountTrailingZeros(uint32_t{0x80000000}), 31);
+  EXPECT_EQ(CountTrailingZeros(uint32_t{0xffffffff}), 0);
+}
+
+TEST(Bits, CountLeadingZeros) {
+  EXPECT_EQ(CountLeadingZeros(uint64_t{1}), 63);
+  EXPECT_EQ(CountLeadingZeros(uint64_t{0x18}), 59);
+  EXPECT_EQ(CountLeadingZeros(uint64_t{0x100000000}), 31);
+  EXPECT_EQ(CountLeadingZeros(uint64_t{1} << 63), 0);
+  EXPECT_EQ(CountLeadingZeros(~uint64_t{0}), 0);
+}
+
+}  // namespace rst
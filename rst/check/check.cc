@@ -0,0 +1,177 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/check/check.h"
+
+#include <atomic>
+#include <cctype>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+
+namespace rst {
+namespace {
+
+// Set and read on different threads.
+std::atomic<CheckFailureHook> g_check_failure_hook = nullptr;
+
+// Set while the hook is running, so that a check failure inside the hook
+// doesn't recurse.
+thread_local bool t_is_running_hook = false;
+
+// Fixed size message buffer not to allocate memory on the failure path.
+class Message {
+ public:
+  Message() = default;
+  ~Message() = default;
+
+#if defined(__GNUC__) || defined(__clang__)
+  __attribute__((format(printf, 2, 3)))
+#endif
+  void Append(const char* format, ...) {
+    if (size_ >= kMaxSize)
+      return;
+
+    va_list args;
+    va_start(args, format);
+    const auto bytes_written =
+        std::vsnprintf(buffer_ + size_, kMaxSize - size_, format, args);
+    va_end(args);
+
+    if (bytes_written < 0)
+      return;
+
+    size_ += static_cast<size_t>(bytes_written);
+    if (size_ >= kMaxSize)
+      size_ = kMaxSize - 1;
+  }
+
+  void AppendValue(const internal::CheckOpValue& value) {
+    using Kind = internal::CheckOpValue::Kind;
+    switch (value.kind()) {
+      case Kind::kBool: {
+        Append("%s", value.unsigned_value() != 0 ? "true" : "false");
+        break;
+      }
+      case Kind::kChar: {
+        const auto c = static_cast<unsigned char>(value.signed_value());
+        if (std::isprint(c) != 0)
+          Append("'%c'", c);
+        else
+          Append("%lld", value.signed_value());
+        break;
+      }
+      case Kind::kSigned: {
+        Append("%lld", value.signed_value());
+        break;
+      }
+      case Kind::kUnsigned: {
+        Append("%llu", value.unsigned_value());
+        break;
+      }
+      case Kind::kFloat: {
+        Append("%Lg", value.float_value());
+        break;
+      }
+      case Kind::kString: {
+        const auto str = value.string_value();
+        const auto size = str.size() < std::numeric_limits<int>::max()
+                              ? static_cast<int>(str.size())
+                              : std::numeric_limits<int>::max();
+        Append("%.*s", size, str.data());
+        break;
+      }
+      case Kind::kPointer: {
+        const auto pointer = const_cast<const void*>(value.pointer_value());
+        if (pointer == nullptr)
+          Append("nullptr");
+        else
+          Append("%p", pointer);
+        break;
+      }
+      case Kind::kUnprintable: {
+        Append("(unprintable)");
+        break;
+      }
+    }
+  }
+
+  std::string_view view() const { return std::string_view(buffer_, size_); }
+
+ private:
+  static constexpr size_t kMaxSize = 1024;
+
+  char buffer_[kMaxSize];
+  size_t size_ = 0;
+};
+
+[[noreturn]] void Report(const Message& message) {
+  const auto view = message.view();
+  const auto hook = g_check_failure_hook.load(std::memory_order_acquire);
+  auto is_handled = false;
+  if (hook != nullptr && !t_is_running_hook) {
+    t_is_running_hook = true;
+    is_handled = hook(view);
+  }
+
+  if (!is_handled) {
+    (void)std::fprintf(stderr, "%.*s\n", static_cast<int>(view.size()),
+                       view.data());
+    (void)std::fflush(stderr);
+  }
+
+  std::abort();
+}
+
+}  // namespace
+
+void SetCheckFailureHook(const CheckFailureHook hook) {
+  g_check_failure_hook.store(hook, std::memory_order_release);
+}
+
+namespace internal {
+
+void CheckFailed(const char* file, const int line, const char* expression) {
+  Message message;
+  message.Append("[FATAL:%s(%d)] Check failed: %s", file, line, expression);
+  Report(message);
+}
+
+void CheckOpFailed(const char* file, const int line, const char* expression,
+                   const CheckOpValue& val1, const CheckOpValue& val2) {
+  Message message;
+  message.Append("[FATAL:%s(%d)] Check failed: %s (", file, line, expression);
+  message.AppendValue(val1);
+  message.Append(" vs. ");
+  message.AppendValue(val2);
+  message.Append(")");
+  Report(message);
+}
+
+}  // namespace internal
+}  // namespace rst
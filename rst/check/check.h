@@ -28,8 +28,10 @@
 #ifndef RST_CHECK_CHECK_H_
 #define RST_CHECK_CHECK_H_
 
-#include <cassert>
-#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
 
 #include "rst/macros/optimization.h"
 
@@ -64,6 +66,19 @@
 // Use RST_CHECK() if the consequence of a failed assertion would be a security
 // vulnerability or a contract violation, where crashing is preferable.
 //
+// RST_CHECK_EQ(), RST_CHECK_NE(), RST_CHECK_LT(), RST_CHECK_LE(),
+// RST_CHECK_GT() and RST_CHECK_GE() compare two values and print both of them
+// on failure. Each operand is evaluated exactly once. The RST_DCHECK_*()
+// versions are only compiled in debug build:
+//
+//   RST_CHECK_EQ(bytes_written, data.size());
+//   // Check failed: bytes_written == data.size() (3 vs. 5)
+//
+// The failure path is a call to a single out-of-line cold function, so a check
+// costs just a compare and a not taken branch in the hot code. The failure
+// message is written to stderr or, if it's set, to the check failure hook (see
+// SetCheckFailureHook()) right before the program aborts.
+//
 // If you want to do more complex logic in a debug build write the following:
 //
 //   #include "rst/macros/macros.h"
@@ -87,19 +102,217 @@
     false ? static_cast<void>(condition) : static_cast<void>(0); \
   } while (false)
 
+#define RST_INTERNAL_DCHECK_OP(op, val1, val2)                              \
+  do {                                                                      \
+    false ? static_cast<void>(                                              \
+                ::rst::internal::CheckOp<::rst::internal::CheckOpType::op>( \
+                    (val1), (val2)))                                        \
+          : static_cast<void>(0);                                           \
+  } while (false)
+
 #else  // defined(NDEBUG)
 
 #define RST_BUILDFLAG_DCHECK_IS_ON() (true)
-#define RST_DCHECK(condition) assert(condition)
+#define RST_DCHECK(condition) RST_CHECK(condition)
+#define RST_INTERNAL_DCHECK_OP(op, val1, val2) \
+  RST_INTERNAL_CHECK_OP(op, val1, val2)
 
 #endif  // defined(NDEBUG)
 
 #define RST_NOTREACHED() RST_DCHECK(false)
 
-#define RST_CHECK(condition)        \
-  do {                              \
-    if (RST_UNLIKELY(!(condition))) \
-      std::abort();                 \
+#define RST_CHECK(condition)                                        \
+  do {                                                              \
+    if (RST_UNLIKELY(!(condition)))                                 \
+      ::rst::internal::CheckFailed(__FILE__, __LINE__, #condition); \
+  } while (false)
+
+// Stores the operands in locals so that each of them is evaluated only once
+// and can be printed on failure.
+#define RST_INTERNAL_CHECK_OP(op, val1, val2)                            \
+  do {                                                                   \
+    const auto& rst_internal_check_val1 = (val1);                        \
+    const auto& rst_internal_check_val2 = (val2);                        \
+    if (RST_UNLIKELY(                                                    \
+            !::rst::internal::CheckOp<::rst::internal::CheckOpType::op>( \
+                rst_internal_check_val1, rst_internal_check_val2))) {    \
+      ::rst::internal::CheckOpFailed(                                    \
+          __FILE__, __LINE__,                                            \
+          #val1 " " RST_INTERNAL_CHECK_OP_STR_##op " " #val2,            \
+          rst_internal_check_val1, rst_internal_check_val2);             \
+    }                                                                    \
   } while (false)
 
+#define RST_INTERNAL_CHECK_OP_STR_kEq "=="
+#define RST_INTERNAL_CHECK_OP_STR_kNe "!="
+#define RST_INTERNAL_CHECK_OP_STR_kLt "<"
+#define RST_INTERNAL_CHECK_OP_STR_kLe "<="
+#define RST_INTERNAL_CHECK_OP_STR_kGt ">"
+#define RST_INTERNAL_CHECK_OP_STR_kGe ">="
+
+#define RST_CHECK_EQ(val1, val2) RST_INTERNAL_CHECK_OP(kEq, val1, val2)
+#define RST_CHECK_NE(val1, val2) RST_INTERNAL_CHECK_OP(kNe, val1, val2)
+#define RST_CHECK_LT(val1, val2) RST_INTERNAL_CHECK_OP(kLt, val1, val2)
+#define RST_CHECK_LE(val1, val2) RST_INTERNAL_CHECK_OP(kLe, val1, val2)
+#define RST_CHECK_GT(val1, val2) RST_INTERNAL_CHECK_OP(kGt, val1, val2)
+#define RST_CHECK_GE(val1, val2) RST_INTERNAL_CHECK_OP(kGe, val1, val2)
+
+#define RST_DCHECK_EQ(val1, val2) RST_INTERNAL_DCHECK_OP(kEq, val1, val2)
+#define RST_DCHECK_NE(val1, val2) RST_INTERNAL_DCHECK_OP(kNe, val1, val2)
+#define RST_DCHECK_LT(val1, val2) RST_INTERNAL_DCHECK_OP(kLt, val1, val2)
+#define RST_DCHECK_LE(val1, val2) RST_INTERNAL_DCHECK_OP(kLe, val1, val2)
+#define RST_DCHECK_GT(val1, val2) RST_INTERNAL_DCHECK_OP(kGt, val1, val2)
+#define RST_DCHECK_GE(val1, val2) RST_INTERNAL_DCHECK_OP(kGe, val1, val2)
+
+namespace rst {
+
+// Called with the failure |message| of a check right before the program
+// aborts. Returns true if the |message| has been handled, otherwise it's
+// written to stderr. The logger uses it to put the message into its sink and
+// flush it.
+using CheckFailureHook = bool (*)(std::string_view message);
+
+// Sets the |hook| to be called on a check failure. nullptr resets the hook.
+void SetCheckFailureHook(CheckFailureHook hook);
+
+namespace internal {
+
+enum class CheckOpType : int8_t { kEq, kNe, kLt, kLe, kGt, kGe };
+
+template <CheckOpType type, class T1, class T2>
+constexpr bool CheckOp(const T1& val1, const T2& val2) {
+  if constexpr (std::is_integral<T1>::value && std::is_integral<T2>::value &&
+                std::is_signed<T1>::value != std::is_signed<T2>::value) {
+    // Compares integers of different signedness by value, so -1 < 0u holds.
+    if constexpr (std::is_signed<T1>::value) {
+      if (val1 < 0) {
+        return type == CheckOpType::kNe || type == CheckOpType::kLt ||
+               type == CheckOpType::kLe;
+      }
+      return CheckOp<type>(
+          static_cast<typename std::make_unsigned<T1>::type>(val1), val2);
+    } else {
+      if (val2 < 0) {
+        return type == CheckOpType::kNe || type == CheckOpType::kGt ||
+               type == CheckOpType::kGe;
+      }
+      return CheckOp<type>(
+          val1, static_cast<typename std::make_unsigned<T2>::type>(val2));
+    }
+  } else if constexpr (type == CheckOpType::kEq) {
+    return val1 == val2;
+  } else if constexpr (type == CheckOpType::kNe) {
+    return val1 != val2;
+  } else if constexpr (type == CheckOpType::kLt) {
+    return val1 < val2;
+  } else if constexpr (type == CheckOpType::kLe) {
+    return val1 <= val2;
+  } else if constexpr (type == CheckOpType::kGt) {
+    return val1 > val2;
+  } else {
+    return val1 >= val2;
+  }
+}
+
+// Type-erased printable representation of a RST_CHECK_EQ()-like operand. It's
+// only constructed on the failure path.
+class CheckOpValue {
+ public:
+  enum class Kind : int8_t {
+    kBool,
+    kChar,
+    kSigned,
+    kUnsigned,
+    kFloat,
+    kString,
+    kPointer,
+    kUnprintable,
+  };
+
+  template <class T>
+  CheckOpValue(const T& value) {  // NOLINT(runtime/explicit)
+    if constexpr (std::is_convertible<const T&, const char*>::value) {
+      const char* str = value;
+      if (str == nullptr) {
+        kind_ = Kind::kPointer;
+        pointer_ = nullptr;
+      } else {
+        SetString(str);
+      }
+    } else if constexpr (std::is_convertible<const T&,
+                                             std::string_view>::value) {
+      SetString(value);
+    } else if constexpr (std::is_same<T, std::nullptr_t>::value) {
+      kind_ = Kind::kPointer;
+      pointer_ = nullptr;
+    } else if constexpr (std::is_pointer<T>::value) {
+      kind_ = Kind::kPointer;
+      pointer_ = static_cast<const volatile void*>(value);
+    } else if constexpr (std::is_enum<T>::value) {
+      *this = CheckOpValue(
+          static_cast<typename std::underlying_type<T>::type>(value));
+    } else if constexpr (std::is_same<T, bool>::value) {
+      kind_ = Kind::kBool;
+      unsigned_ = value;
+    } else if constexpr (std::is_same<T, char>::value) {
+      kind_ = Kind::kChar;
+      signed_ = value;
+    } else if constexpr (std::is_integral<T>::value &&
+                         std::is_signed<T>::value) {
+      kind_ = Kind::kSigned;
+      signed_ = value;
+    } else if constexpr (std::is_integral<T>::value) {
+      kind_ = Kind::kUnsigned;
+      unsigned_ = value;
+    } else if constexpr (std::is_floating_point<T>::value) {
+      kind_ = Kind::kFloat;
+      float_ = value;
+    } else {
+      kind_ = Kind::kUnprintable;
+      unsigned_ = 0;
+    }
+  }
+
+  Kind kind() const { return kind_; }
+  long long signed_value() const { return signed_; }  // NOLINT(runtime/int)
+  // NOLINTNEXTLINE(runtime/int)
+  unsigned long long unsigned_value() const { return unsigned_; }
+  long double float_value() const { return float_; }
+  std::string_view string_value() const { return {string_.data, string_.size}; }
+  const volatile void* pointer_value() const { return pointer_; }
+
+ private:
+  void SetString(const std::string_view str) {
+    kind_ = Kind::kString;
+    string_.data = str.data();
+    string_.size = str.size();
+  }
+
+  struct String {
+    const char* data;
+    size_t size;
+  };
+
+  Kind kind_;
+  union {
+    long long signed_;             // NOLINT(runtime/int)
+    unsigned long long unsigned_;  // NOLINT(runtime/int)
+    long double float_;
+    String string_;
+    const volatile void* pointer_;
+  };
+};
+
+// Writes the failure message and aborts the program. File, line and
+// expression are string literals, so the call site only passes pointers.
+[[noreturn]] RST_ATTRIBUTE_COLD RST_ATTRIBUTE_NOINLINE void CheckFailed(
+    const char* file, int line, const char* expression);
+
+[[noreturn]] RST_ATTRIBUTE_COLD RST_ATTRIBUTE_NOINLINE void CheckOpFailed(
+    const char* file, int line, const char* expression,
+    const CheckOpValue& val1, const CheckOpValue& val2);
+
+}  // namespace internal
+}  // namespace rst
+
 #endif  // RST_CHECK_CHECK_H_
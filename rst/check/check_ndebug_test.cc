@@ -62,6 +62,23 @@ TEST_F(NDebugCheck, DCheck) {
   EXPECT_NO_FATAL_FAILURE(RST_DCHECK(false));
 }
 
+TEST_F(NDebugCheck, CheckOp) {
+  EXPECT_NO_FATAL_FAILURE(RST_CHECK_EQ(1, 1));
+  EXPECT_DEATH(RST_CHECK_EQ(1, 2), "Check failed: 1 == 2 \\(1 vs. 2\\)");
+}
+
+TEST_F(NDebugCheck, DCheckOp) {
+  EXPECT_NO_FATAL_FAILURE(RST_DCHECK_EQ(1, 1));
+  EXPECT_NO_FATAL_FAILURE(RST_DCHECK_EQ(1, 2));
+  EXPECT_NO_FATAL_FAILURE(RST_DCHECK_LT(2, 1));
+}
+
+TEST_F(NDebugCheck, DCheckOpEvaluation) {
+  EXPECT_EQ(int_, 0);
+  RST_DCHECK_EQ(IncrementIntAndReturnTrue(), true);
+  EXPECT_EQ(int_, 0);
+}
+
 TEST_F(NDebugCheck, Notreached) { EXPECT_NO_FATAL_FAILURE(RST_NOTREACHED()); }
 
 TEST_F(NDebugCheck, DCheckInConstexpr) {
@@ -27,6 +27,10 @@
 
 #include "rst/check/check.h"
 
+#include <cstdio>
+#include <string>
+#include <string_view>
+
 #include <gtest/gtest.h>
 
 namespace rst {
@@ -48,6 +52,27 @@ constexpr double Divide(const double a, const double b) {
   return a / b;
 }
 
+constexpr int Subtract(const int a, const int b) {
+  RST_DCHECK_GE(a, b);
+  RST_CHECK_GE(a, b);
+  return a - b;
+}
+
+enum class Color { kRed, kGreen };
+
+bool HookToStdout(const std::string_view message) {
+  std::printf("Hook: %.*s\n", static_cast<int>(message.size()),
+              message.data());
+  std::fflush(stdout);
+  return false;
+}
+
+bool HandlingHook(const std::string_view message) {
+  std::fprintf(stderr, "Handled: %.*s\n", static_cast<int>(message.size()),
+               message.data());
+  return true;
+}
+
 }  // namespace
 
 TEST_F(Check, Check) {
@@ -60,6 +85,89 @@ TEST_F(Check, DCheck) {
   EXPECT_DEATH(RST_DCHECK(false), "");
 }
 
+TEST_F(Check, Message) {
+  EXPECT_DEATH(RST_CHECK(1 + 1 == 3),
+               "\\[FATAL:.*check_test\\.cc\\([0-9]+\\)\\] "
+               "Check failed: 1 \\+ 1 == 3");
+}
+
+TEST_F(Check, CheckOp) {
+  EXPECT_NO_FATAL_FAILURE(RST_CHECK_EQ(1, 1));
+  EXPECT_NO_FATAL_FAILURE(RST_CHECK_NE(1, 2));
+  EXPECT_NO_FATAL_FAILURE(RST_CHECK_LT(1, 2));
+  EXPECT_NO_FATAL_FAILURE(RST_CHECK_LE(1, 1));
+  EXPECT_NO_FATAL_FAILURE(RST_CHECK_GT(2, 1));
+  EXPECT_NO_FATAL_FAILURE(RST_CHECK_GE(1, 1));
+
+  EXPECT_DEATH(RST_CHECK_EQ(1, 2), "Check failed: 1 == 2 \\(1 vs. 2\\)");
+  EXPECT_DEATH(RST_CHECK_NE(1, 1), "Check failed: 1 != 1 \\(1 vs. 1\\)");
+  EXPECT_DEATH(RST_CHECK_LT(2, 1), "Check failed: 2 < 1 \\(2 vs. 1\\)");
+  EXPECT_DEATH(RST_CHECK_LE(2, 1), "Check failed: 2 <= 1 \\(2 vs. 1\\)");
+  EXPECT_DEATH(RST_CHECK_GT(1, 2), "Check failed: 1 > 2 \\(1 vs. 2\\)");
+  EXPECT_DEATH(RST_CHECK_GE(1, 2), "Check failed: 1 >= 2 \\(1 vs. 2\\)");
+}
+
+TEST_F(Check, CheckOpValues) {
+  const std::string str = "abc";
+  const char* null_str = nullptr;
+  int i = 0;
+  const auto ptr = &i;
+
+  EXPECT_DEATH(RST_CHECK_EQ(str, "abd"), "\\(abc vs. abd\\)");
+  EXPECT_DEATH(RST_CHECK_EQ(std::string_view(str), "abd"),
+               "\\(abc vs. abd\\)");
+  EXPECT_DEATH(RST_CHECK_EQ(null_str, str.c_str()), "\\(nullptr vs. abc\\)");
+  EXPECT_DEATH(RST_CHECK_EQ(ptr, nullptr), "\\(0x[0-9a-f]+ vs. nullptr\\)");
+  EXPECT_DEATH(RST_CHECK_EQ(true, false), "\\(true vs. false\\)");
+  EXPECT_DEATH(RST_CHECK_EQ('a', 'b'), "\\('a' vs. 'b'\\)");
+  EXPECT_DEATH(RST_CHECK_EQ(-1LL, 1LL), "\\(-1 vs. 1\\)");
+  EXPECT_DEATH(RST_CHECK_EQ(2ULL, 1ULL), "\\(2 vs. 1\\)");
+  EXPECT_DEATH(RST_CHECK_LT(1.5, 0.5), "\\(1.5 vs. 0.5\\)");
+  EXPECT_DEATH(RST_CHECK_EQ(Color::kRed, Color::kGreen), "\\(0 vs. 1\\)");
+}
+
+TEST_F(Check, CheckOpEvaluatesOnce) {
+  auto i = 0;
+  RST_CHECK_EQ(++i, 1);
+  EXPECT_EQ(i, 1);
+  RST_DCHECK_EQ(++i, 2);
+  EXPECT_EQ(i, 2);
+}
+
+TEST_F(Check, CheckOpMixedSign) {
+  EXPECT_NO_FATAL_FAILURE(RST_CHECK_LT(-1, 0u));
+  EXPECT_NO_FATAL_FAILURE(RST_CHECK_GT(0u, -1));
+  EXPECT_NO_FATAL_FAILURE(RST_CHECK_NE(-1, 0xffffffffu));
+  EXPECT_NO_FATAL_FAILURE(RST_CHECK_EQ(size_t{1}, 1));
+  EXPECT_DEATH(RST_CHECK_GE(-1, 0u), "\\(-1 vs. 0\\)");
+}
+
+TEST_F(Check, DCheckOp) {
+  EXPECT_NO_FATAL_FAILURE(RST_DCHECK_EQ(1, 1));
+  EXPECT_DEATH(RST_DCHECK_EQ(1, 2), "Check failed: 1 == 2 \\(1 vs. 2\\)");
+}
+
+TEST_F(Check, CheckOpInConstexpr) {
+  static constexpr auto result = Subtract(2, 1);
+  EXPECT_EQ(result, 1);
+}
+
+TEST_F(Check, FailureHook) {
+  EXPECT_DEATH(
+      {
+        SetCheckFailureHook(&HookToStdout);
+        RST_CHECK(false);
+      },
+      "Check failed: false");
+
+  EXPECT_DEATH(
+      {
+        SetCheckFailureHook(&HandlingHook);
+        RST_CHECK(false);
+      },
+      "Handled: \\[FATAL:.*\\] Check failed: false");
+}
+
 TEST_F(Check, Notreached) { EXPECT_DEATH(RST_NOTREACHED(), ""); }
 
 TEST_F(Check, DCheckInConstexpr) {
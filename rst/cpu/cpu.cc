@@ -0,0 +1,163 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/cpu/cpu.h"
+
+#include <atomic>
+
+#include "rst/macros/arch.h"
+#include "rst/macros/os.h"
+
+#if RST_BUILDFLAG(ARCH_CPU_X86_FAMILY)
+#if RST_BUILDFLAG(OS_WIN)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif  // RST_BUILDFLAG(OS_WIN)
+#endif  // RST_BUILDFLAG(ARCH_CPU_X86_FAMILY)
+
+namespace rst {
+namespace {
+
+std::atomic<CpuLevel> g_level_limit(CpuLevel::kAvx512);
+
+#if RST_BUILDFLAG(ARCH_CPU_X86_FAMILY)
+struct CpuidResult {
+  uint32_t eax = 0;
+  uint32_t ebx = 0;
+  uint32_t ecx = 0;
+  uint32_t edx = 0;
+};
+
+CpuidResult Cpuid(const uint32_t leaf, const uint32_t subleaf = 0) {
+  CpuidResult result;
+#if RST_BUILDFLAG(OS_WIN)
+  int regs[4] = {};
+  __cpuidex(regs, static_cast<int>(leaf), static_cast<int>(subleaf));
+  result.eax = static_cast<uint32_t>(regs[0]);
+  result.ebx = static_cast<uint32_t>(regs[1]);
+  result.ecx = static_cast<uint32_t>(regs[2]);
+  result.edx = static_cast<uint32_t>(regs[3]);
+#else
+  __cpuid_count(leaf, subleaf, result.eax, result.ebx, result.ecx, result.edx);
+#endif  // RST_BUILDFLAG(OS_WIN)
+  return result;
+}
+
+// Returns the mask of the register states the OS saves on context switches.
+uint64_t GetXcr0() {
+#if RST_BUILDFLAG(OS_WIN)
+  return _xgetbv(0);
+#else
+  uint32_t eax = 0;
+  uint32_t edx = 0;
+  // xgetbv is emitted as bytes to support assemblers that don't know it.
+  __asm__(".byte 0x0f, 0x01, 0xd0" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif  // RST_BUILDFLAG(OS_WIN)
+}
+
+constexpr bool HasBit(const uint32_t reg, const int bit) {
+  return (reg & (uint32_t{1} << bit)) != 0;
+}
+#endif  // RST_BUILDFLAG(ARCH_CPU_X86_FAMILY)
+
+}  // namespace
+
+Cpu::Cpu() {
+#if RST_BUILDFLAG(ARCH_CPU_X86_FAMILY)
+  const auto max_leaf = Cpuid(0).eax;
+  if (max_leaf < 1)
+    return;
+
+  const auto leaf1 = Cpuid(1);
+  has_sse2_ = HasBit(leaf1.edx, 26);
+  has_sse3_ = HasBit(leaf1.ecx, 0);
+  has_ssse3_ = HasBit(leaf1.ecx, 9);
+  has_sse41_ = HasBit(leaf1.ecx, 19);
+  has_sse42_ = HasBit(leaf1.ecx, 20);
+  has_popcnt_ = HasBit(leaf1.ecx, 23);
+
+  // XMM and YMM states.
+  constexpr uint64_t kYmmStateMask = 0x6;
+  // XMM, YMM, opmask and ZMM states.
+  constexpr uint64_t kZmmStateMask = 0xe6;
+  const auto has_osxsave = HasBit(leaf1.ecx, 27);
+  const auto xcr0 = has_osxsave ? GetXcr0() : 0;
+  const auto has_ymm_state = (xcr0 & kYmmStateMask) == kYmmStateMask;
+  const auto has_zmm_state = (xcr0 & kZmmStateMask) == kZmmStateMask;
+
+  has_avx_ = has_ymm_state && HasBit(leaf1.ecx, 28);
+  has_fma_ = has_ymm_state && HasBit(leaf1.ecx, 12);
+
+  if (max_leaf >= 7) {
+    const auto leaf7 = Cpuid(7);
+    has_bmi1_ = HasBit(leaf7.ebx, 3);
+    has_bmi2_ = HasBit(leaf7.ebx, 8);
+    has_avx2_ = has_ymm_state && HasBit(leaf7.ebx, 5);
+    has_avx512f_ = has_zmm_state && HasBit(leaf7.ebx, 16);
+    has_avx512dq_ = has_zmm_state && HasBit(leaf7.ebx, 17);
+    has_avx512cd_ = has_zmm_state && HasBit(leaf7.ebx, 28);
+    has_avx512bw_ = has_zmm_state && HasBit(leaf7.ebx, 30);
+    has_avx512vl_ = has_zmm_state && HasBit(leaf7.ebx, 31);
+  }
+
+  if (!(has_ssse3_ && has_sse41_ && has_sse42_ && has_popcnt_))
+    return;
+  level_ = CpuLevel::kSse42;
+
+  if (!(has_avx_ && has_avx2_ && has_bmi1_ && has_bmi2_ && has_fma_))
+    return;
+  level_ = CpuLevel::kAvx2;
+
+  if (!(has_avx512f_ && has_avx512cd_ && has_avx512bw_ && has_avx512dq_ &&
+        has_avx512vl_)) {
+    return;
+  }
+  level_ = CpuLevel::kAvx512;
+#elif RST_BUILDFLAG(ARCH_CPU_ARM64)
+  // NEON is mandatory on ARMv8-A.
+  has_neon_ = true;
+#endif  // RST_BUILDFLAG(ARCH_CPU_X86_FAMILY)
+}
+
+const Cpu& GetCpu() {
+  static const Cpu cpu;
+  return cpu;
+}
+
+CpuLevel GetCpuLevel() {
+  const auto level = GetCpu().level();
+  const auto limit = g_level_limit.load(std::memory_order_relaxed);
+  return level < limit ? level : limit;
+}
+
+void SetCpuLevelLimit(const CpuLevel level) {
+  g_level_limit.store(level, std::memory_order_relaxed);
+}
+
+}  // namespace rst
@@ -0,0 +1,123 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef RST_CPU_CPU_H_
+#define RST_CPU_CPU_H_
+
+#include <cstdint>
+
+#include "rst/macros/macros.h"
+
+namespace rst {
+
+// Instruction set levels to select kernel implementations for (see
+// CpuDispatcher). Each level includes all the previous ones.
+enum class CpuLevel : int8_t {
+  // SSE2 on x86-64, NEON on ARM64, no extensions on other architectures.
+  kBaseline = 0,
+  // SSSE3, SSE4.1, SSE4.2 and POPCNT (Nehalem and later).
+  kSse42,
+  // AVX, AVX2, BMI1, BMI2 and FMA (Haswell and later).
+  kAvx2,
+  // AVX-512 F, CD, BW, DQ and VL (Skylake-SP and later).
+  kAvx512,
+};
+
+// Features of the current CPU.
+//
+// Example:
+//
+//   if (GetCpu().has_avx2())
+//     ...
+//
+class Cpu {
+ public:
+  bool has_sse2() const { return has_sse2_; }
+  bool has_sse3() const { return has_sse3_; }
+  bool has_ssse3() const { return has_ssse3_; }
+  bool has_sse41() const { return has_sse41_; }
+  bool has_sse42() const { return has_sse42_; }
+  bool has_popcnt() const { return has_popcnt_; }
+  // AVX and later are reported only if the OS saves the extended registers.
+  bool has_avx() const { return has_avx_; }
+  bool has_avx2() const { return has_avx2_; }
+  bool has_bmi1() const { return has_bmi1_; }
+  bool has_bmi2() const { return has_bmi2_; }
+  bool has_fma() const { return has_fma_; }
+  bool has_avx512f() const { return has_avx512f_; }
+  bool has_avx512cd() const { return has_avx512cd_; }
+  bool has_avx512bw() const { return has_avx512bw_; }
+  bool has_avx512dq() const { return has_avx512dq_; }
+  bool has_avx512vl() const { return has_avx512vl_; }
+  bool has_neon() const { return has_neon_; }
+
+  // The highest level all the features of which are supported.
+  CpuLevel level() const { return level_; }
+
+ private:
+  friend const Cpu& GetCpu();
+
+  // Detects the features of the current CPU.
+  Cpu();
+
+  bool has_sse2_ = false;
+  bool has_sse3_ = false;
+  bool has_ssse3_ = false;
+  bool has_sse41_ = false;
+  bool has_sse42_ = false;
+  bool has_popcnt_ = false;
+  bool has_avx_ = false;
+  bool has_avx2_ = false;
+  bool has_bmi1_ = false;
+  bool has_bmi2_ = false;
+  bool has_fma_ = false;
+  bool has_avx512f_ = false;
+  bool has_avx512cd_ = false;
+  bool has_avx512bw_ = false;
+  bool has_avx512dq_ = false;
+  bool has_avx512vl_ = false;
+  bool has_neon_ = false;
+
+  CpuLevel level_ = CpuLevel::kBaseline;
+
+  RST_DISALLOW_COPY_AND_ASSIGN(Cpu);
+};
+
+// Returns the features of the current CPU detected on the first call.
+const Cpu& GetCpu();
+
+// Returns GetCpu().level() unless it's limited by SetCpuLevelLimit().
+CpuLevel GetCpuLevel();
+
+// Limits the level returned by GetCpuLevel() to |level|. Lets tests and
+// benchmarks exercise lower tier kernels on a modern machine. Dispatchers cache
+// their selection, so it should be called before the first dispatch.
+void SetCpuLevelLimit(CpuLevel level);
+
+}  // namespace rst
+
+#endif  // RST_CPU_CPU_H_
@@ -0,0 +1,84 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/cpu/cpu.h"
+
+#include <gtest/gtest.h>
+
+#include "rst/macros/arch.h"
+#include "rst/macros/macros.h"
+
+namespace rst {
+
+TEST(Cpu, Unique) { EXPECT_EQ(&GetCpu(), &GetCpu()); }
+
+TEST(Cpu, Level) {
+  const auto& cpu = GetCpu();
+  if (cpu.level() >= CpuLevel::kSse42) {
+    EXPECT_TRUE(cpu.has_ssse3());
+    EXPECT_TRUE(cpu.has_sse41());
+    EXPECT_TRUE(cpu.has_sse42());
+    EXPECT_TRUE(cpu.has_popcnt());
+  }
+  if (cpu.level() >= CpuLevel::kAvx2) {
+    EXPECT_TRUE(cpu.has_avx());
+    EXPECT_TRUE(cpu.has_avx2());
+    EXPECT_TRUE(cpu.has_bmi1());
+    EXPECT_TRUE(cpu.has_bmi2());
+    EXPECT_TRUE(cpu.has_fma());
+  }
+  if (cpu.level() == CpuLevel::kAvx512) {
+    EXPECT_TRUE(cpu.has_avx512f());
+    EXPECT_TRUE(cpu.has_avx512cd());
+    EXPECT_TRUE(cpu.has_avx512bw());
+    EXPECT_TRUE(cpu.has_avx512dq());
+    EXPECT_TRUE(cpu.has_avx512vl());
+  }
+}
+
+#if RST_BUILDFLAG(ARCH_CPU_X86_64)
+TEST(Cpu, X86_64) { EXPECT_TRUE(GetCpu().has_sse2()); }
+#endif  // RST_BUILDFLAG(ARCH_CPU_X86_64)
+
+#if RST_BUILDFLAG(ARCH_CPU_ARM64)
+TEST(Cpu, Arm64) {
+  EXPECT_TRUE(GetCpu().has_neon());
+  EXPECT_EQ(GetCpu().level(), CpuLevel::kBaseline);
+}
+#endif  // RST_BUILDFLAG(ARCH_CPU_ARM64)
+
+TEST(Cpu, LevelLimit) {
+  EXPECT_EQ(GetCpuLevel(), GetCpu().level());
+
+  SetCpuLevelLimit(CpuLevel::kBaseline);
+  EXPECT_EQ(GetCpuLevel(), CpuLevel::kBaseline);
+
+  SetCpuLevelLimit(CpuLevel::kAvx512);
+  EXPECT_EQ(GetCpuLevel(), GetCpu().level());
+}
+
+}  // namespace rst
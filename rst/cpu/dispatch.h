@@ -0,0 +1,128 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef RST_CPU_DISPATCH_H_
+#define RST_CPU_DISPATCH_H_
+
+#include <atomic>
+#include <initializer_list>
+#include <utility>
+
+#include "rst/check/check.h"
+#include "rst/cpu/cpu.h"
+#include "rst/macros/macros.h"
+#include "rst/macros/optimization.h"
+
+// Compiles a function for the instruction set |arch| regardless of the flags
+// of the translation unit, so that several implementations of a kernel can
+// live in one file and be picked by CpuDispatcher.
+//
+// Example:
+//
+//   RST_ATTRIBUTE_TARGET("avx2,bmi2") int CountAvx2(const char* s, size_t n);
+//
+#if defined(__GNUC__) || defined(__clang__)
+#define RST_ATTRIBUTE_TARGET(arch) __attribute__((target(arch)))
+#else
+#define RST_ATTRIBUTE_TARGET(arch)
+#endif
+
+namespace rst {
+
+template <class Signature>
+class CpuDispatcher;
+
+// Calls the implementation of a function for the highest CpuLevel supported by
+// the current CPU. The implementation is selected on the first call and cached,
+// so subsequent calls cost one relaxed atomic load and an indirect call. A
+// function pointer is used instead of ifuncs since those are ELF-only.
+//
+// Example:
+//
+//   size_t CountBaseline(const char* s, size_t n);
+//   RST_ATTRIBUTE_TARGET("avx2") size_t CountAvx2(const char* s, size_t n);
+//
+//   size_t Count(const char* s, size_t n) {
+//     static CpuDispatcher<size_t(const char*, size_t)> dispatcher = {
+//         {CpuLevel::kBaseline, &CountBaseline},
+//         {CpuLevel::kAvx2, &CountAvx2}};
+//     return dispatcher(s, n);
+//   }
+//
+template <class R, class... Args>
+class CpuDispatcher<R(Args...)> {
+ public:
+  using Function = R (*)(Args...);
+
+  struct Implementation {
+    CpuLevel level;
+    Function function;
+  };
+
+  // |implementations| must include a CpuLevel::kBaseline one.
+  constexpr CpuDispatcher(
+      const std::initializer_list<Implementation> implementations) {
+    for (const auto& implementation : implementations) {
+      const auto index = static_cast<int>(implementation.level);
+      RST_DCHECK(index >= 0 && index < kLevelCount);
+      RST_DCHECK(implementation.function != nullptr);
+      functions_[index] = implementation.function;
+    }
+    RST_DCHECK(functions_[static_cast<int>(CpuLevel::kBaseline)] != nullptr);
+  }
+
+  // Returns the implementation for the highest level not above |level|.
+  constexpr Function Select(const CpuLevel level) const {
+    for (auto index = static_cast<int>(level); index >= 0; index--) {
+      if (functions_[index] != nullptr)
+        return functions_[index];
+    }
+    return nullptr;
+  }
+
+  R operator()(Args... args) const {
+    auto function = selected_.load(std::memory_order_relaxed);
+    if (RST_UNLIKELY(function == nullptr)) {
+      // Racing threads select the same function, so the store is benign.
+      function = Select(GetCpuLevel());
+      selected_.store(function, std::memory_order_relaxed);
+    }
+    return function(std::forward<Args>(args)...);
+  }
+
+ private:
+  static constexpr int kLevelCount = static_cast<int>(CpuLevel::kAvx512) + 1;
+
+  Function functions_[kLevelCount] = {};
+  mutable std::atomic<Function> selected_{nullptr};
+
+  RST_DISALLOW_COPY_AND_ASSIGN(CpuDispatcher);
+};
+
+}  // namespace rst
+
+#endif  // RST_CPU_DISPATCH_H_
@@ -0,0 +1,109 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/cpu/dispatch.h"
+
+#include <memory>
+
+#include <gtest/gtest.h>
+
+#include "rst/macros/macros.h"
+
+namespace rst {
+namespace {
+
+int Baseline(int x) { return x; }
+int Sse42(int x) { return x + 1; }
+int Avx2(int x) { return x + 2; }
+int Avx512(int x) { return x + 3; }
+
+int Move(std::unique_ptr<int> x) { return *x; }
+
+}  // namespace
+
+TEST(CpuDispatcher, Select) {
+  const CpuDispatcher<int(int)> dispatcher = {
+      {CpuLevel::kBaseline, &Baseline},
+      {CpuLevel::kSse42, &Sse42},
+      {CpuLevel::kAvx2, &Avx2},
+      {CpuLevel::kAvx512, &Avx512}};
+
+  EXPECT_EQ(dispatcher.Select(CpuLevel::kBaseline), &Baseline);
+  EXPECT_EQ(dispatcher.Select(CpuLevel::kSse42), &Sse42);
+  EXPECT_EQ(dispatcher.Select(CpuLevel::kAvx2), &Avx2);
+  EXPECT_EQ(dispatcher.Select(CpuLevel::kAvx512), &Avx512);
+}
+
+TEST(CpuDispatcher, SelectFallback) {
+  const CpuDispatcher<int(int)> dispatcher = {{CpuLevel::kBaseline, &Baseline},
+                                              {CpuLevel::kAvx2, &Avx2}};
+
+  EXPECT_EQ(dispatcher.Select(CpuLevel::kBaseline), &Baseline);
+  EXPECT_EQ(dispatcher.Select(CpuLevel::kSse42), &Baseline);
+  EXPECT_EQ(dispatcher.Select(CpuLevel::kAvx2), &Avx2);
+  EXPECT_EQ(dispatcher.Select(CpuLevel::kAvx512), &Avx2);
+}
+
+TEST(CpuDispatcher, Call) {
+  const CpuDispatcher<int(int)> dispatcher = {
+      {CpuLevel::kBaseline, &Baseline},
+      {CpuLevel::kSse42, &Sse42},
+      {CpuLevel::kAvx2, &Avx2},
+      {CpuLevel::kAvx512, &Avx512}};
+
+  const auto expected = static_cast<int>(GetCpuLevel());
+  EXPECT_EQ(dispatcher(0), expected);
+  EXPECT_EQ(dispatcher(10), 10 + expected);
+}
+
+TEST(CpuDispatcher, CallWithLevelLimit) {
+  SetCpuLevelLimit(CpuLevel::kBaseline);
+  const CpuDispatcher<int(int)> dispatcher = {
+      {CpuLevel::kBaseline, &Baseline},
+      {CpuLevel::kSse42, &Sse42},
+      {CpuLevel::kAvx2, &Avx2},
+      {CpuLevel::kAvx512, &Avx512}};
+  EXPECT_EQ(dispatcher(10), 10);
+
+  // The selection is cached.
+  SetCpuLevelLimit(CpuLevel::kAvx512);
+  EXPECT_EQ(dispatcher(10), 10);
+}
+
+TEST(CpuDispatcher, MoveOnlyArgument) {
+  const CpuDispatcher<int(std::unique_ptr<int>)> dispatcher = {
+      {CpuLevel::kBaseline, &Move}};
+  EXPECT_EQ(dispatcher(std::make_unique<int>(42)), 42);
+}
+
+#if RST_BUILDFLAG(DCHECK_IS_ON)
+TEST(CpuDispatcher, NoBaseline) {
+  EXPECT_DEATH((CpuDispatcher<int(int)>{{CpuLevel::kAvx2, &Avx2}}), "");
+}
+#endif  // RST_BUILDFLAG(DCHECK_IS_ON)
+
+}  // namespace rst
@@ -28,6 +28,7 @@
 #ifndef RST_DEFER_DEFER_H_
 #define RST_DEFER_DEFER_H_
 
+#include <type_traits>
 #include <utility>
 
 #include "rst/macros/macros.h"
@@ -51,22 +52,22 @@ namespace internal {
 template <class F>
 class DeferredAction {
  public:
-  explicit DeferredAction(F&& action) : action_(std::forward<F>(action)) {}
-
-  DeferredAction(DeferredAction&&) noexcept = default;
-  DeferredAction& operator=(DeferredAction&&) noexcept = delete;
+  explicit DeferredAction(F&& action) : action_(std::move(action)) {}
+  explicit DeferredAction(const F& action) : action_(action) {}
 
   ~DeferredAction() { action_(); }
 
  private:
-  const F action_;
+  F action_;
 
   RST_DISALLOW_COPY_AND_ASSIGN(DeferredAction);
 };
 
+// Relies on guaranteed copy elision, so DeferredAction doesn't need a move
+// constructor and an "is active" flag.
 template <class F>
-inline DeferredAction<F> Defer(F&& f) {
-  return DeferredAction<F>(std::forward<F>(f));
+inline DeferredAction<std::decay_t<F>> Defer(F&& f) {
+  return DeferredAction<std::decay_t<F>>(std::forward<F>(f));
 }
 
 }  // namespace internal
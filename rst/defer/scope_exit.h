@@ -0,0 +1,169 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef RST_DEFER_SCOPE_EXIT_H_
+#define RST_DEFER_SCOPE_EXIT_H_
+
+#include <utility>
+
+#include "rst/macros/macros.h"
+#include "rst/not_null/not_null.h"
+#include "rst/status/status.h"
+
+namespace rst {
+
+// Executes |f| on scope exit unless Dismiss() is called. Unlike RST_DEFER(),
+// can be moved, e.g. returned from a function, and cancelled. It costs an extra
+// bool over the stored functor.
+//
+// Example:
+//
+//   Status Foo() {
+//     RST_TRY(CreateTempFile());
+//     auto remove_temp_file = ScopeExit([]() { RemoveTempFile(); });
+//
+//     RST_TRY(WriteTempFile());
+//     RST_TRY(RenameTempFile());
+//
+//     remove_temp_file.Dismiss();
+//     return Status::OK();
+//   }
+//
+template <class F>
+class [[nodiscard]] ScopeExit {
+ public:
+  explicit ScopeExit(F&& action) : action_(std::move(action)) {}
+  explicit ScopeExit(const F& action) : action_(action) {}
+
+  ScopeExit(ScopeExit&& other) noexcept
+      : action_(std::move(other.action_)),
+        is_active_(std::exchange(other.is_active_, false)) {}
+
+  ~ScopeExit() {
+    if (is_active_)
+      action_();
+  }
+
+  // Cancels the action.
+  void Dismiss() { is_active_ = false; }
+
+ private:
+  F action_;
+  bool is_active_ = true;
+
+  RST_DISALLOW_COPY_AND_ASSIGN(ScopeExit);
+};
+
+template <class F>
+ScopeExit(F) -> ScopeExit<F>;
+
+// Executes |f| on scope exit if |status| is OK at that moment, unless Dismiss()
+// is called. Doesn't mark |status| as checked. |status| must outlive the guard
+// and must not be moved from while the guard is alive.
+//
+// Example:
+//
+//   Status Save() {
+//     Status status = WriteHeader();
+//     {
+//       ScopeSuccess notify(&status, []() { NotifySaved(); });
+//       ScopeFailure rollback(&status, []() { Rollback(); });
+//
+//       if (!status.err())
+//         status = WriteBody();
+//     }
+//     return status;
+//   }
+//
+template <class F>
+class [[nodiscard]] ScopeSuccess {
+ public:
+  ScopeSuccess(const NotNull<const Status*> status, F&& action)
+      : status_(status), action_(std::move(action)) {}
+  ScopeSuccess(const NotNull<const Status*> status, const F& action)
+      : status_(status), action_(action) {}
+
+  ~ScopeSuccess() {
+    if (is_active_ && status_->error_ == nullptr)
+      action_();
+  }
+
+  // Cancels the action.
+  void Dismiss() { is_active_ = false; }
+
+ private:
+  const NotNull<const Status*> status_;
+  F action_;
+  bool is_active_ = true;
+
+  RST_DISALLOW_COPY_AND_ASSIGN(ScopeSuccess);
+};
+
+template <class F>
+ScopeSuccess(NotNull<const Status*>, F) -> ScopeSuccess<F>;
+template <class F>
+ScopeSuccess(const Status*, F) -> ScopeSuccess<F>;
+template <class F>
+ScopeSuccess(Status*, F) -> ScopeSuccess<F>;
+
+// Executes |f| on scope exit if |status| is an error at that moment, unless
+// Dismiss() is called. Doesn't mark |status| as checked. See ScopeSuccess for
+// the example.
+template <class F>
+class [[nodiscard]] ScopeFailure {
+ public:
+  ScopeFailure(const NotNull<const Status*> status, F&& action)
+      : status_(status), action_(std::move(action)) {}
+  ScopeFailure(const NotNull<const Status*> status, const F& action)
+      : status_(status), action_(action) {}
+
+  ~ScopeFailure() {
+    if (is_active_ && status_->error_ != nullptr)
+      action_();
+  }
+
+  // Cancels the action.
+  void Dismiss() { is_active_ = false; }
+
+ private:
+  const NotNull<const Status*> status_;
+  F action_;
+  bool is_active_ = true;
+
+  RST_DISALLOW_COPY_AND_ASSIGN(ScopeFailure);
+};
+
+template <class F>
+ScopeFailure(NotNull<const Status*>, F) -> ScopeFailure<F>;
+template <class F>
+ScopeFailure(const Status*, F) -> ScopeFailure<F>;
+template <class F>
+ScopeFailure(Status*, F) -> ScopeFailure<F>;
+
+}  // namespace rst
+
+#endif  // RST_DEFER_SCOPE_EXIT_H_
@@ -0,0 +1,190 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/defer/scope_exit.h"
+
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <gtest/gtest.h>
+
+#include "rst/defer/defer.h"
+#include "rst/macros/macros.h"
+#include "rst/status/status.h"
+
+namespace rst {
+namespace {
+
+class Error : public ErrorInfo<Error> {
+ public:
+  Error() = default;
+
+  const std::string& AsString() const override { return message_; }
+
+  static char id_;
+
+ private:
+  const std::string message_ = "Error";
+
+  RST_DISALLOW_COPY_AND_ASSIGN(Error);
+};
+
+char Error::id_ = '\0';
+
+auto g_int = 0;
+
+void Foo() { g_int++; }
+
+ScopeExit<void (*)()> MakeFooScopeExit() { return ScopeExit(&Foo); }
+
+// What a hand-written dismissable cleanup has to keep.
+template <class F>
+struct HandWrittenCleanup {
+  F action;
+  bool is_active;
+};
+
+}  // namespace
+
+TEST(ScopeExit, Lambda) {
+  auto i = 0;
+  {
+    auto guard = ScopeExit([&i]() { i++; });
+    EXPECT_EQ(i, 0);
+  }
+  EXPECT_EQ(i, 1);
+}
+
+TEST(ScopeExit, Function) {
+  g_int = 0;
+  { auto guard = ScopeExit(Foo); }
+  EXPECT_EQ(g_int, 1);
+}
+
+TEST(ScopeExit, Dismiss) {
+  auto i = 0;
+  {
+    auto guard = ScopeExit([&i]() { i++; });
+    guard.Dismiss();
+  }
+  EXPECT_EQ(i, 0);
+}
+
+TEST(ScopeExit, Move) {
+  g_int = 0;
+  {
+    auto guard = MakeFooScopeExit();
+    auto moved = std::move(guard);
+    EXPECT_EQ(g_int, 0);
+  }
+  EXPECT_EQ(g_int, 1);
+}
+
+TEST(ScopeExit, MutableMoveOnlyLambda) {
+  auto i = 0;
+  {
+    auto guard = ScopeExit(
+        [&i, ptr = std::make_unique<int>(1)]() mutable { i += *ptr; });
+  }
+  EXPECT_EQ(i, 1);
+}
+
+TEST(ScopeExit, ZeroOverhead) {
+  auto i = 0;
+  auto f = [&i]() { i++; };
+  using F = decltype(f);
+
+  // RST_DEFER() stores just the functor, ScopeExit() adds an "is active" flag.
+  static_assert(sizeof(internal::DeferredAction<F>) == sizeof(F));
+  static_assert(sizeof(ScopeExit<F>) == sizeof(F) + alignof(F));
+  static_assert(sizeof(ScopeExit<void (*)()>) == 2 * sizeof(void (*)()));
+  static_assert(sizeof(ScopeExit<F>) == sizeof(HandWrittenCleanup<F>));
+  static_assert(sizeof(ScopeSuccess<F>) ==
+                sizeof(HandWrittenCleanup<F>) + sizeof(void*));
+  static_assert(std::is_nothrow_move_constructible<ScopeExit<F>>::value);
+  static_assert(!std::is_copy_constructible<ScopeExit<F>>::value);
+}
+
+TEST(ScopeSuccess, Ok) {
+  auto success = 0;
+  auto failure = 0;
+  auto status = Status::OK();
+  {
+    ScopeSuccess on_success(&status, [&success]() { success++; });
+    ScopeFailure on_failure(&status, [&failure]() { failure++; });
+  }
+  EXPECT_EQ(success, 1);
+  EXPECT_EQ(failure, 0);
+  EXPECT_FALSE(status.err());
+}
+
+TEST(ScopeSuccess, Error) {
+  auto success = 0;
+  auto failure = 0;
+  auto status = Status::OK();
+  {
+    ScopeSuccess on_success(&status, [&success]() { success++; });
+    ScopeFailure on_failure(&status, [&failure]() { failure++; });
+    ASSERT_FALSE(status.err());
+    status = MakeStatus<Error>();
+  }
+  EXPECT_EQ(success, 0);
+  EXPECT_EQ(failure, 1);
+  EXPECT_TRUE(status.err());
+}
+
+TEST(ScopeSuccess, Dismiss) {
+  auto success = 0;
+  auto failure = 0;
+  auto ok = Status::OK();
+  auto error = MakeStatus<Error>();
+  {
+    ScopeSuccess on_success(&ok, [&success]() { success++; });
+    ScopeFailure on_failure(&error, [&failure]() { failure++; });
+    on_success.Dismiss();
+    on_failure.Dismiss();
+  }
+  EXPECT_EQ(success, 0);
+  EXPECT_EQ(failure, 0);
+  EXPECT_FALSE(ok.err());
+  EXPECT_TRUE(error.err());
+}
+
+#if RST_BUILDFLAG(DCHECK_IS_ON)
+TEST(ScopeSuccess, DoesNotCheckStatus) {
+  EXPECT_DEATH(
+      {
+        auto status = Status::OK();
+        ScopeSuccess on_success(&status, []() {});
+      },
+      "");
+}
+#endif  // RST_BUILDFLAG(DCHECK_IS_ON)
+
+}  // namespace rst
@@ -0,0 +1,270 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/fiber/fiber.h"
+
+#if RST_BUILDFLAG(FIBER)
+
+#include <atomic>
+#include <utility>
+
+#include "rst/check/check.h"
+#include "rst/macros/optimization.h"
+
+namespace chrono = std::chrono;
+
+namespace rst {
+namespace internal {
+
+struct Fiber {
+  Fiber(std::function<void()>&& task, FiberStack&& stack,
+        const NotNull<FiberScheduler*> scheduler)
+      : task(std::move(task)), stack(std::move(stack)), scheduler(scheduler) {}
+
+  // What the thread does after the fiber is switched out.
+  enum class State {
+    kRunning,
+    kYielded,
+    kSleeping,
+    kBlocked,
+    kFinished,
+  };
+
+  std::function<void()> task;
+  FiberStack stack;
+  const NotNull<FiberScheduler*> scheduler;
+
+  FiberContext context;
+  // The context of the thread that runs the fiber.
+  FiberContext thread_context;
+
+  State state = State::kRunning;
+  // With State::kSleeping.
+  chrono::milliseconds delay = chrono::milliseconds::zero();
+  // With State::kBlocked. Set by both the thread switching the fiber out and
+  // WakeUpFiber(), the second of them schedules the fiber.
+  std::atomic<bool> wake_up_latch = false;
+
+  // Link of FiberQueue.
+  Fiber* next = nullptr;
+
+  RST_DISALLOW_COPY_AND_ASSIGN(Fiber);
+};
+
+namespace {
+
+thread_local Fiber* t_current_fiber RST_ATTRIBUTE_TLS_INITIAL_EXEC = nullptr;
+
+// A fiber may be resumed on another thread, so the compiler must not reuse the
+// thread local address computed before a switch. The accessors aren't inlined
+// to compute it again.
+RST_ATTRIBUTE_NOINLINE Fiber* GetCurrentFiber() { return t_current_fiber; }
+
+RST_ATTRIBUTE_NOINLINE void SetCurrentFiber(Fiber* fiber) {
+  t_current_fiber = fiber;
+}
+
+// Switches from the current fiber to its thread after setting |state|.
+void SwitchToThread(const Fiber::State state) {
+  auto* fiber = GetCurrentFiber();
+  RST_DCHECK(fiber != nullptr);
+  fiber->state = state;
+  SwitchFiberContext(&fiber->context, &fiber->thread_context);
+}
+
+void RunFiber(void* arg) {
+  auto* fiber = static_cast<Fiber*>(arg);
+  fiber->task();
+  fiber->task = nullptr;
+  fiber->state = Fiber::State::kFinished;
+  ExitFiberContext(&fiber->context, &fiber->thread_context);
+}
+
+}  // namespace
+
+FiberQueue::FiberQueue() = default;
+
+FiberQueue::~FiberQueue() { RST_DCHECK(empty()); }
+
+void FiberQueue::Push(const NotNull<Fiber*> fiber) {
+  fiber->next = nullptr;
+  if (tail_ == nullptr)
+    head_ = fiber.get();
+  else
+    tail_->next = fiber.get();
+  tail_ = fiber.get();
+}
+
+Nullable<Fiber*> FiberQueue::Pop() {
+  auto* fiber = head_;
+  if (fiber == nullptr)
+    return nullptr;
+
+  head_ = fiber->next;
+  if (head_ == nullptr)
+    tail_ = nullptr;
+  fiber->next = nullptr;
+  return fiber;
+}
+
+void SuspendFiber(const NotNull<FiberQueue*> waiters,
+                  std::unique_lock<std::mutex>& lock) {  // NOLINT
+  RST_DCHECK(lock.owns_lock());
+  auto* fiber = GetCurrentFiber();
+  RST_DCHECK(fiber != nullptr);
+  fiber->wake_up_latch = false;
+  waiters->Push(fiber);
+  lock.unlock();
+  SwitchToThread(Fiber::State::kBlocked);
+}
+
+void WakeUpFiber(const NotNull<Fiber*> fiber) {
+  if (fiber->wake_up_latch.exchange(true))
+    fiber->scheduler->Schedule(fiber, chrono::milliseconds::zero());
+}
+
+}  // namespace internal
+
+FiberScheduler::FiberScheduler(const NotNull<TaskRunner*> task_runner,
+                               const size_t stack_size)
+    : task_runner_(task_runner), stack_size_(stack_size) {
+  RST_DCHECK(stack_size_ > 0);
+}
+
+FiberScheduler::~FiberScheduler() {
+  RST_DCHECK(!this_fiber::IsInFiber());
+  std::unique_lock lock(mutex_);
+  while (fibers_num_ != 0)
+    fibers_cv_.wait(lock);
+}
+
+void FiberScheduler::Spawn(std::function<void()>&& task) {
+  RST_DCHECK(task != nullptr);
+
+  {
+    std::lock_guard lock(mutex_);
+    fibers_num_++;
+  }
+
+  // Deleted when finished.
+  auto* fiber = new internal::Fiber(std::move(task), TakeStack(), this);
+  internal::MakeFiberContext(fiber->stack, &internal::RunFiber, fiber,
+                             &fiber->context);
+  Schedule(fiber, chrono::milliseconds::zero());
+}
+
+size_t FiberScheduler::fibers_num() const {
+  std::lock_guard lock(mutex_);
+  return fibers_num_;
+}
+
+void FiberScheduler::Schedule(const NotNull<internal::Fiber*> fiber,
+                              const chrono::milliseconds delay) {
+  // A resume posted under back-pressure must neither be dropped nor run
+  // nested in the fiber waking this one up.
+  task_runner_->PostDelayedTaskOverCapacity(
+      [this, fiber]() { Resume(fiber); }, delay);
+}
+
+void FiberScheduler::Resume(const NotNull<internal::Fiber*> fiber) {
+  using State = internal::Fiber::State;
+
+  // Set if a task runner runs the task posted by Schedule() right away on the
+  // calling fiber.
+  auto* previous_fiber = internal::GetCurrentFiber();
+  internal::SetCurrentFiber(fiber.get());
+  fiber->state = State::kRunning;
+  internal::SwitchFiberContext(&fiber->thread_context, &fiber->context);
+  internal::SetCurrentFiber(previous_fiber);
+
+  switch (fiber->state) {
+    case State::kRunning: {
+      RST_NOTREACHED();
+      return;
+    }
+    case State::kYielded: {
+      Schedule(fiber, chrono::milliseconds::zero());
+      return;
+    }
+    case State::kSleeping: {
+      Schedule(fiber, fiber->delay);
+      return;
+    }
+    case State::kBlocked: {
+      // Otherwise the fiber may be already resumed on another thread.
+      if (fiber->wake_up_latch.exchange(true))
+        Schedule(fiber, chrono::milliseconds::zero());
+      return;
+    }
+    case State::kFinished: {
+      auto stack = std::move(fiber->stack);
+      delete fiber.get();
+
+      // Limits the memory kept by the finished fibers of a burst.
+      static constexpr size_t kMaxFreeStacksNum = 64;
+      std::lock_guard lock(mutex_);
+      if (free_stacks_.size() < kMaxFreeStacksNum)
+        free_stacks_.emplace_back(std::move(stack));
+      fibers_num_--;
+      // The destructor may return right after the lock is released.
+      fibers_cv_.notify_all();
+      return;
+    }
+  }
+}
+
+internal::FiberStack FiberScheduler::TakeStack() {
+  {
+    std::lock_guard lock(mutex_);
+    if (!free_stacks_.empty()) {
+      auto stack = std::move(free_stacks_.back());
+      free_stacks_.pop_back();
+      return stack;
+    }
+  }
+
+  return internal::FiberStack(stack_size_);
+}
+
+namespace this_fiber {
+
+bool IsInFiber() { return internal::GetCurrentFiber() != nullptr; }
+
+void Yield() { internal::SwitchToThread(internal::Fiber::State::kYielded); }
+
+void SleepFor(const chrono::milliseconds delay) {
+  RST_DCHECK(delay.count() >= 0);
+  auto* fiber = internal::GetCurrentFiber();
+  RST_DCHECK(fiber != nullptr);
+  fiber->delay = delay;
+  internal::SwitchToThread(internal::Fiber::State::kSleeping);
+}
+
+}  // namespace this_fiber
+}  // namespace rst
+
+#endif  // RST_BUILDFLAG(FIBER)
@@ -0,0 +1,169 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef RST_FIBER_FIBER_H_
+#define RST_FIBER_FIBER_H_
+
+#include "rst/fiber/fiber_context.h"
+
+#if RST_BUILDFLAG(FIBER)
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "rst/macros/macros.h"
+#include "rst/not_null/not_null.h"
+#include "rst/task_runner/task_runner.h"
+
+namespace rst {
+
+class FiberScheduler;
+
+namespace internal {
+
+struct Fiber;
+
+// Intrusive FIFO of suspended fibers.
+class FiberQueue {
+ public:
+  FiberQueue();
+  ~FiberQueue();
+
+  void Push(NotNull<Fiber*> fiber);
+  // Returns null if the queue is empty.
+  Nullable<Fiber*> Pop();
+
+  bool empty() const { return head_ == nullptr; }
+
+ private:
+  Fiber* head_ = nullptr;
+  Fiber* tail_ = nullptr;
+
+  RST_DISALLOW_COPY_AND_ASSIGN(FiberQueue);
+};
+
+// Pushes the current fiber to |waiters|, unlocks |lock| guarding |waiters| and
+// suspends the fiber. The fiber is resumed only when it's both switched out
+// and woken up, so it can be woken up right after the unlock.
+void SuspendFiber(NotNull<FiberQueue*> waiters,
+                  std::unique_lock<std::mutex>& lock);  // NOLINT
+
+// Schedules the fiber suspended by SuspendFiber() to run.
+void WakeUpFiber(NotNull<Fiber*> fiber);
+
+}  // namespace internal
+
+// Runs fibers, user-mode threads with their own stacks, on a task runner. A
+// fiber blocked on FiberMutex, FiberConditionVariable or this_fiber::SleepFor()
+// gives its thread to other fibers, so a lot of fibers running blocking code
+// are multiplexed onto a few threads of ThreadPoolTaskRunner.
+//
+// A blocked fiber may be resumed on another thread, so it must not hold
+// std::mutex or addresses of thread_local variables over the blocking calls.
+//
+// Example:
+//
+//   FiberMutex mutex;
+//   ThreadPoolTaskRunner task_runner(4, ...);
+//   FiberScheduler scheduler(&task_runner);
+//   for (auto i = 0; i < 100000; i++) {
+//     scheduler.Spawn([&mutex]() {
+//       std::lock_guard lock(mutex);
+//       this_fiber::SleepFor(std::chrono::milliseconds(10));
+//     });
+//   }
+//
+// The fibers are resumed with TaskRunner::PostDelayedTaskOverCapacity(), so
+// a capacity of the task runner doesn't block, drop or nest them.
+//
+// The stacks are mapped lazily and reused. Every stack takes two memory
+// mappings, the limit of which is vm.max_map_count on Linux.
+class FiberScheduler {
+ public:
+  static constexpr size_t kDefaultStackSize = 64 * 1024;
+
+  // Runs fibers on |task_runner| with stacks of at least |stack_size| bytes.
+  explicit FiberScheduler(NotNull<TaskRunner*> task_runner,
+                          size_t stack_size = kDefaultStackSize);
+  // Blocks until all fibers have finished, so it must not be called on a
+  // thread of the task runner.
+  ~FiberScheduler();
+
+  // Starts a fiber running |task|.
+  void Spawn(std::function<void()>&& task);
+
+  // Returns the number of unfinished fibers.
+  size_t fibers_num() const;
+
+ private:
+  friend void internal::WakeUpFiber(NotNull<internal::Fiber*> fiber);
+
+  // Posts |fiber| to be resumed after |delay|.
+  void Schedule(NotNull<internal::Fiber*> fiber,
+                std::chrono::milliseconds delay);
+
+  // Runs |fiber| until it's suspended or finished.
+  void Resume(NotNull<internal::Fiber*> fiber);
+
+  // Returns a reused stack or a new one.
+  internal::FiberStack TakeStack();
+
+  const NotNull<TaskRunner*> task_runner_;
+  const size_t stack_size_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable fibers_cv_;
+  size_t fibers_num_ = 0;
+  // Stacks of the finished fibers.
+  std::vector<internal::FiberStack> free_stacks_;
+
+  RST_DISALLOW_COPY_AND_ASSIGN(FiberScheduler);
+};
+
+namespace this_fiber {
+
+// Returns true if called from a fiber.
+bool IsInFiber();
+
+// Lets the other fibers and tasks of the task runner run. Must be called from
+// a fiber.
+void Yield();
+
+// Suspends the current fiber for |delay| without blocking its thread. Must be
+// called from a fiber.
+void SleepFor(std::chrono::milliseconds delay);
+
+}  // namespace this_fiber
+}  // namespace rst
+
+#endif  // RST_BUILDFLAG(FIBER)
+
+#endif  // RST_FIBER_FIBER_H_
@@ -0,0 +1,337 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/fiber/fiber_context.h"
+
+#if RST_BUILDFLAG(FIBER)
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#include "rst/check/check.h"
+#include "rst/macros/optimization.h"
+
+#if RST_BUILDFLAG(FIBER_ASAN)
+#include <sanitizer/asan_interface.h>
+#include <sanitizer/common_interface_defs.h>
+#endif  // RST_BUILDFLAG(FIBER_ASAN)
+
+#if RST_BUILDFLAG(FIBER_TSAN)
+#include <sanitizer/tsan_interface.h>
+#endif  // RST_BUILDFLAG(FIBER_TSAN)
+
+#if defined(__APPLE__)
+#define RST_FIBER_ASM_SYMBOL(name) "_" #name
+#define RST_FIBER_ASM_TYPE(name) ""
+#else
+#define RST_FIBER_ASM_SYMBOL(name) #name
+#define RST_FIBER_ASM_TYPE(name) ".type " #name ", %function\n"
+#endif
+
+#define RST_FIBER_ASM_FUNCTION(name)        \
+  ".globl " RST_FIBER_ASM_SYMBOL(name) "\n" \
+  RST_FIBER_ASM_TYPE(name)                  \
+  ".p2align 4\n"                            \
+  RST_FIBER_ASM_SYMBOL(name) ":\n"
+
+extern "C" {
+void rst_switch_fiber_context(void** from, void* to);
+void rst_start_fiber();
+}
+
+#if RST_BUILDFLAG(ARCH_CPU_X86_64)
+// System V AMD64 ABI: rbx, rbp, r12-r15, the MXCSR control bits and the x87
+// control word are callee-saved. The saved frame, from the stack pointer up:
+// MXCSR and x87 control word, r15, r14, r13, r12, rbx, rbp, return address.
+asm(".text\n"
+    RST_FIBER_ASM_FUNCTION(rst_switch_fiber_context)
+    "  pushq %rbp\n"
+    "  pushq %rbx\n"
+    "  pushq %r12\n"
+    "  pushq %r13\n"
+    "  pushq %r14\n"
+    "  pushq %r15\n"
+    "  subq $8, %rsp\n"
+    "  stmxcsr (%rsp)\n"
+    "  fnstcw 4(%rsp)\n"
+    "  movq %rsp, (%rdi)\n"
+    "  movq %rsi, %rsp\n"
+    "  ldmxcsr (%rsp)\n"
+    "  fldcw 4(%rsp)\n"
+    "  addq $8, %rsp\n"
+    "  popq %r15\n"
+    "  popq %r14\n"
+    "  popq %r13\n"
+    "  popq %r12\n"
+    "  popq %rbx\n"
+    "  popq %rbp\n"
+    "  ret\n"
+    // The first switch to a fiber returns here with the entry in r12 and its
+    // argument in r13.
+    RST_FIBER_ASM_FUNCTION(rst_start_fiber)
+    "  movq %r13, %rdi\n"
+    "  callq *%r12\n"
+    "  ud2\n");
+#elif RST_BUILDFLAG(ARCH_CPU_ARM64)
+// AAPCS64: x19-x28, the frame pointer x29, the link register x30 and the low
+// halves of v8-v15 are callee-saved. The saved frame, from the stack pointer
+// up: x19-x30, d8-d15 and 16 bytes of padding to keep the stack aligned.
+asm(".text\n"
+    RST_FIBER_ASM_FUNCTION(rst_switch_fiber_context)
+    "  sub sp, sp, #176\n"
+    "  stp x19, x20, [sp, #0]\n"
+    "  stp x21, x22, [sp, #16]\n"
+    "  stp x23, x24, [sp, #32]\n"
+    "  stp x25, x26, [sp, #48]\n"
+    "  stp x27, x28, [sp, #64]\n"
+    "  stp x29, x30, [sp, #80]\n"
+    "  stp d8, d9, [sp, #96]\n"
+    "  stp d10, d11, [sp, #112]\n"
+    "  stp d12, d13, [sp, #128]\n"
+    "  stp d14, d15, [sp, #144]\n"
+    "  mov x9, sp\n"
+    "  str x9, [x0]\n"
+    "  mov sp, x1\n"
+    "  ldp x19, x20, [sp, #0]\n"
+    "  ldp x21, x22, [sp, #16]\n"
+    "  ldp x23, x24, [sp, #32]\n"
+    "  ldp x25, x26, [sp, #48]\n"
+    "  ldp x27, x28, [sp, #64]\n"
+    "  ldp x29, x30, [sp, #80]\n"
+    "  ldp d8, d9, [sp, #96]\n"
+    "  ldp d10, d11, [sp, #112]\n"
+    "  ldp d12, d13, [sp, #128]\n"
+    "  ldp d14, d15, [sp, #144]\n"
+    "  add sp, sp, #176\n"
+    "  ret\n"
+    // The first switch to a fiber returns here with the entry in x19 and its
+    // argument in x20.
+    RST_FIBER_ASM_FUNCTION(rst_start_fiber)
+    "  mov x0, x20\n"
+    "  blr x19\n"
+    "  brk #0\n");
+#endif  // RST_BUILDFLAG(ARCH_CPU_X86_64)
+
+namespace rst {
+namespace internal {
+namespace {
+
+#if RST_BUILDFLAG(FIBER_ASAN)
+// The context switched from on this thread. AddressSanitizer reports its stack
+// when the switch is finished.
+thread_local FiberContext* t_switched_from_context
+    RST_ATTRIBUTE_TLS_INITIAL_EXEC = nullptr;
+
+// A context may continue on another thread, so the compiler must not reuse the
+// thread local address computed before a switch. The accessors aren't inlined
+// to compute it again.
+RST_ATTRIBUTE_NOINLINE FiberContext* GetSwitchedFromContext() {
+  return t_switched_from_context;
+}
+
+RST_ATTRIBUTE_NOINLINE void SetSwitchedFromContext(FiberContext* context) {
+  t_switched_from_context = context;
+}
+#endif  // RST_BUILDFLAG(FIBER_ASAN)
+
+// Tells the sanitizers that the calling context switches from |from| to |to|.
+void StartSwitch(FiberContext* from, FiberContext* to, const bool is_exiting) {
+#if RST_BUILDFLAG(FIBER_ASAN)
+  SetSwitchedFromContext(from);
+  // The fake stack of an exiting context is freed.
+  __sanitizer_start_switch_fiber(is_exiting ? nullptr : &from->fake_stack,
+                                 to->stack_bottom, to->stack_size);
+#else
+  static_cast<void>(is_exiting);
+#endif  // RST_BUILDFLAG(FIBER_ASAN)
+
+#if RST_BUILDFLAG(FIBER_TSAN)
+  // A thread context may be resumed by several threads.
+  if (!from->owns_tsan_fiber)
+    from->tsan_fiber = __tsan_get_current_fiber();
+  __tsan_switch_to_fiber(to->tsan_fiber, 0);
+#endif  // RST_BUILDFLAG(FIBER_TSAN)
+
+  static_cast<void>(from);
+  static_cast<void>(to);
+}
+
+// Tells the sanitizers that the switch to |context| is finished.
+void FinishSwitch(FiberContext* context) {
+#if RST_BUILDFLAG(FIBER_ASAN)
+  auto* from = GetSwitchedFromContext();
+  __sanitizer_finish_switch_fiber(context->fake_stack, &from->stack_bottom,
+                                  &from->stack_size);
+#endif  // RST_BUILDFLAG(FIBER_ASAN)
+
+  static_cast<void>(context);
+}
+
+// Called by rst_start_fiber on the first switch to |arg|.
+void StartFiber(void* arg) {
+  auto* context = static_cast<FiberContext*>(arg);
+  FinishSwitch(context);
+  context->entry(context->arg);
+  // The entry must not return.
+  std::abort();
+}
+
+}  // namespace
+
+FiberStack::FiberStack(const size_t size)
+    : page_size_(static_cast<size_t>(::sysconf(_SC_PAGESIZE))) {
+  RST_DCHECK(size > 0);
+  size_ = (size + page_size_ - 1) / page_size_ * page_size_ + page_size_;
+
+  auto flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#if defined(MAP_NORESERVE)
+  flags |= MAP_NORESERVE;
+#endif
+#if defined(MAP_STACK)
+  flags |= MAP_STACK;
+#endif
+  memory_ = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, flags, -1, 0);
+  RST_CHECK(memory_ != MAP_FAILED);
+  RST_CHECK(::mprotect(memory_, page_size_, PROT_NONE) == 0);
+}
+
+FiberStack::FiberStack(FiberStack&& other) noexcept
+    : memory_(std::exchange(other.memory_, nullptr)),
+      size_(std::exchange(other.size_, 0)),
+      page_size_(other.page_size_) {}
+
+FiberStack& FiberStack::operator=(FiberStack&& other) noexcept {
+  if (this == &other)
+    return *this;
+
+  Unmap();
+  memory_ = std::exchange(other.memory_, nullptr);
+  size_ = std::exchange(other.size_, 0);
+  page_size_ = other.page_size_;
+  return *this;
+}
+
+FiberStack::~FiberStack() { Unmap(); }
+
+void* FiberStack::top() const {
+  RST_DCHECK(memory_ != nullptr);
+  return static_cast<char*>(memory_) + size_;
+}
+
+void FiberStack::Unmap() {
+  if (memory_ != nullptr)
+    RST_CHECK(::munmap(memory_, size_) == 0);
+}
+
+FiberContext::FiberContext() = default;
+
+FiberContext::~FiberContext() {
+#if RST_BUILDFLAG(FIBER_TSAN)
+  if (owns_tsan_fiber)
+    __tsan_destroy_fiber(tsan_fiber);
+#endif  // RST_BUILDFLAG(FIBER_TSAN)
+}
+
+void MakeFiberContext(const FiberStack& stack, void (*entry)(void*),
+                      void* arg, const NotNull<FiberContext*> context) {
+  RST_DCHECK(entry != nullptr);
+  RST_DCHECK(context->stack_pointer == nullptr);
+  context->entry = entry;
+  context->arg = arg;
+
+#if RST_BUILDFLAG(FIBER_ASAN)
+  context->stack_bottom = static_cast<char*>(stack.top()) - stack.size();
+  context->stack_size = stack.size();
+  // A reused stack may keep the poisoned redzones of the previous fiber.
+  ASAN_UNPOISON_MEMORY_REGION(context->stack_bottom, context->stack_size);
+#endif  // RST_BUILDFLAG(FIBER_ASAN)
+
+  const auto top = reinterpret_cast<uintptr_t>(stack.top());
+  const auto entry_address = reinterpret_cast<uintptr_t>(&StartFiber);
+  const auto arg_address = reinterpret_cast<uintptr_t>(context.get());
+  const auto start_address = reinterpret_cast<uintptr_t>(&rst_start_fiber);
+
+#if RST_BUILDFLAG(ARCH_CPU_X86_64)
+  // The stack is 16 bytes aligned after the return to rst_start_fiber, as
+  // required at a call instruction.
+  static constexpr size_t kFrameSize = 80;
+  auto* const frame = reinterpret_cast<uint64_t*>(top - kFrameSize);
+  std::memset(frame, 0, kFrameSize);
+  // Default MXCSR and x87 control word.
+  const uint32_t mxcsr = 0x1f80;
+  const uint16_t x87_control_word = 0x037f;
+  std::memcpy(frame, &mxcsr, sizeof(mxcsr));
+  std::memcpy(reinterpret_cast<char*>(frame) + 4, &x87_control_word,
+              sizeof(x87_control_word));
+  frame[3] = arg_address;    // r13
+  frame[4] = entry_address;  // r12
+  frame[7] = start_address;  // Return address.
+#elif RST_BUILDFLAG(ARCH_CPU_ARM64)
+  static constexpr size_t kFrameSize = 176;
+  auto* const frame = reinterpret_cast<uint64_t*>(top - kFrameSize);
+  std::memset(frame, 0, kFrameSize);
+  frame[0] = entry_address;   // x19
+  frame[1] = arg_address;     // x20
+  frame[11] = start_address;  // x30
+#endif  // RST_BUILDFLAG(ARCH_CPU_X86_64)
+
+  context->stack_pointer = frame;
+
+#if RST_BUILDFLAG(FIBER_TSAN)
+  context->tsan_fiber = __tsan_create_fiber(0);
+  context->owns_tsan_fiber = true;
+#endif  // RST_BUILDFLAG(FIBER_TSAN)
+}
+
+void SwitchFiberContext(const NotNull<FiberContext*> from,
+                        const NotNull<FiberContext*> to) {
+  StartSwitch(from.get(), to.get(), /*is_exiting=*/false);
+  rst_switch_fiber_context(&from->stack_pointer, to->stack_pointer);
+  FinishSwitch(from.get());
+}
+
+void ExitFiberContext(const NotNull<FiberContext*> from,
+                      const NotNull<FiberContext*> to) {
+  // AddressSanitizer frees the fake stack frames of the exiting context, which
+  // may hold the arguments, when the switch starts.
+  void** const from_stack_pointer = &from->stack_pointer;
+  void* const to_stack_pointer = to->stack_pointer;
+  StartSwitch(from.get(), to.get(), /*is_exiting=*/true);
+  rst_switch_fiber_context(from_stack_pointer, to_stack_pointer);
+  // A finished context is never switched back to.
+  std::abort();
+}
+
+}  // namespace internal
+}  // namespace rst
+
+#endif  // RST_BUILDFLAG(FIBER)
@@ -0,0 +1,164 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef RST_FIBER_FIBER_CONTEXT_H_
+#define RST_FIBER_FIBER_CONTEXT_H_
+
+#include <cstddef>
+
+#include "rst/macros/arch.h"
+#include "rst/macros/macros.h"
+#include "rst/macros/os.h"
+#include "rst/not_null/not_null.h"
+
+// Fibers are supported on x86-64 and ARM64 POSIX systems with GCC or Clang,
+// the context switch is written in assembly for their calling conventions.
+//
+// Example:
+//
+//   #include "rst/fiber/fiber_context.h"
+//
+//   #if RST_BUILDFLAG(FIBER)
+//   Code using fibers.
+//   #endif
+//
+#if (RST_BUILDFLAG(ARCH_CPU_X86_64) || RST_BUILDFLAG(ARCH_CPU_ARM64)) && \
+    !RST_BUILDFLAG(OS_WIN) && (defined(__GNUC__) || defined(__clang__))
+#define RST_BUILDFLAG_FIBER() (true)
+#else
+#define RST_BUILDFLAG_FIBER() (false)
+#endif
+
+// AddressSanitizer and ThreadSanitizer are told about the fiber switches,
+// otherwise they lose track of the stack.
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define RST_BUILDFLAG_FIBER_ASAN() (true)
+#endif
+#if __has_feature(thread_sanitizer)
+#define RST_BUILDFLAG_FIBER_TSAN() (true)
+#endif
+#endif  // defined(__has_feature)
+
+#if !defined(RST_BUILDFLAG_FIBER_ASAN)
+#if defined(__SANITIZE_ADDRESS__)
+#define RST_BUILDFLAG_FIBER_ASAN() (true)
+#else
+#define RST_BUILDFLAG_FIBER_ASAN() (false)
+#endif
+#endif  // !defined(RST_BUILDFLAG_FIBER_ASAN)
+
+#if !defined(RST_BUILDFLAG_FIBER_TSAN)
+#if defined(__SANITIZE_THREAD__)
+#define RST_BUILDFLAG_FIBER_TSAN() (true)
+#else
+#define RST_BUILDFLAG_FIBER_TSAN() (false)
+#endif
+#endif  // !defined(RST_BUILDFLAG_FIBER_TSAN)
+
+#if RST_BUILDFLAG(FIBER)
+
+namespace rst {
+namespace internal {
+
+// Stack of a fiber. The memory is mapped lazily, so only the touched pages
+// take physical memory. The page below the stack is inaccessible, so a stack
+// overflow crashes instead of corrupting the memory.
+class FiberStack {
+ public:
+  // Maps at least |size| bytes rounded up to the page size.
+  explicit FiberStack(size_t size);
+  FiberStack(FiberStack&& other) noexcept;
+  FiberStack& operator=(FiberStack&& other) noexcept;
+  ~FiberStack();
+
+  // The highest address of the stack, the stack grows down from it.
+  void* top() const;
+  // The usable size without the guard page.
+  size_t size() const { return size_ - page_size_; }
+
+ private:
+  void Unmap();
+
+  void* memory_ = nullptr;
+  // Includes the guard page.
+  size_t size_ = 0;
+  size_t page_size_ = 0;
+
+  RST_DISALLOW_COPY_AND_ASSIGN(FiberStack);
+};
+
+// Suspended execution context of a fiber or of a thread that runs fibers.
+struct FiberContext {
+  FiberContext();
+  ~FiberContext();
+
+  void* stack_pointer = nullptr;
+
+  // Set by MakeFiberContext().
+  void (*entry)(void*) = nullptr;
+  void* arg = nullptr;
+
+#if RST_BUILDFLAG(FIBER_ASAN)
+  // The stack of the context. Set by the switches from it for a thread.
+  const void* stack_bottom = nullptr;
+  size_t stack_size = 0;
+  // The fake stack of the locals escaping the frames while switched out.
+  void* fake_stack = nullptr;
+#endif  // RST_BUILDFLAG(FIBER_ASAN)
+
+#if RST_BUILDFLAG(FIBER_TSAN)
+  void* tsan_fiber = nullptr;
+  // True if |tsan_fiber| is created by MakeFiberContext().
+  bool owns_tsan_fiber = false;
+#endif  // RST_BUILDFLAG(FIBER_TSAN)
+
+  RST_DISALLOW_COPY_AND_ASSIGN(FiberContext);
+};
+
+// Prepares |context| to call |entry| with |arg| on |stack| when switched to.
+// |entry| must not return. |stack| must outlive the fiber.
+void MakeFiberContext(const FiberStack& stack, void (*entry)(void*), void* arg,
+                      NotNull<FiberContext*> context);
+
+// Saves the callee-saved registers of the calling context on its stack,
+// stores its stack pointer to |from| and continues the context |to|. Returns
+// when another context switches back to |from|, possibly on another thread.
+void SwitchFiberContext(NotNull<FiberContext*> from,
+                        NotNull<FiberContext*> to);
+
+// Like SwitchFiberContext(), but |from| is finished and is never switched
+// back to.
+[[noreturn]] void ExitFiberContext(NotNull<FiberContext*> from,
+                                   NotNull<FiberContext*> to);
+
+}  // namespace internal
+}  // namespace rst
+
+#endif  // RST_BUILDFLAG(FIBER)
+
+#endif  // RST_FIBER_FIBER_CONTEXT_H_
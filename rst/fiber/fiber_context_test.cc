@@ -0,0 +1,121 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/fiber/fiber_context.h"
+
+#if RST_BUILDFLAG(FIBER)
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include <gtest/gtest.h>
+
+namespace rst {
+namespace internal {
+namespace {
+
+struct PingPong {
+  FiberContext main_context;
+  FiberContext fiber_context;
+  std::string str;
+};
+
+void PingPongEntry(void* arg) {
+  auto* ping_pong = static_cast<PingPong*>(arg);
+  for (auto i = 0; true; i++) {
+    ping_pong->str += std::to_string(i);
+    SwitchFiberContext(&ping_pong->fiber_context, &ping_pong->main_context);
+  }
+}
+
+void AlignmentEntry(void* arg) {
+  auto* ping_pong = static_cast<PingPong*>(arg);
+  alignas(16) char buffer[16];
+  // Compilers align the locals assuming the ABI stack alignment. The volatile
+  // keeps the check from being folded.
+  const volatile auto address = reinterpret_cast<uintptr_t>(buffer);
+  ping_pong->str = address % 16 == 0 ? "a" : "u";
+  double value = 1.0;
+  for (auto i = 0; i < 10; i++)
+    value *= 1.5;
+  ping_pong->str += std::to_string(static_cast<int>(value));
+  ExitFiberContext(&ping_pong->fiber_context, &ping_pong->main_context);
+}
+
+}  // namespace
+
+TEST(FiberContext, SwitchBackAndForth) {
+  FiberStack stack(16 * 1024);
+  PingPong ping_pong;
+  MakeFiberContext(stack, &PingPongEntry, &ping_pong,
+                   &ping_pong.fiber_context);
+
+  std::string expected;
+  for (auto i = 0; i < 100; i++) {
+    SwitchFiberContext(&ping_pong.main_context, &ping_pong.fiber_context);
+    expected += std::to_string(i);
+    EXPECT_EQ(ping_pong.str, expected);
+  }
+}
+
+TEST(FiberContext, StackIsAligned) {
+  FiberStack stack(16 * 1024);
+  PingPong ping_pong;
+  MakeFiberContext(stack, &AlignmentEntry, &ping_pong,
+                   &ping_pong.fiber_context);
+  SwitchFiberContext(&ping_pong.main_context, &ping_pong.fiber_context);
+  EXPECT_EQ(ping_pong.str, "a57");
+}
+
+TEST(FiberContext, StackSize) {
+  FiberStack stack(1);
+  EXPECT_GE(stack.size(), size_t{1});
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(stack.top()) % 16, 0U);
+
+  // The stack is writable.
+  auto* bottom = static_cast<char*>(stack.top()) - stack.size();
+  bottom[0] = 1;
+  static_cast<char*>(stack.top())[-1] = 1;
+
+  FiberStack other(std::move(stack));
+  EXPECT_EQ(other.top(), bottom + other.size());
+  stack = std::move(other);
+  EXPECT_EQ(stack.top(), bottom + stack.size());
+}
+
+TEST(FiberContext, GuardPage) {
+  FiberStack stack(16 * 1024);
+  auto* volatile guard =
+      static_cast<char*>(stack.top()) - stack.size() - 1;
+  EXPECT_DEATH(*guard = 1, "");
+}
+
+}  // namespace internal
+}  // namespace rst
+
+#endif  // RST_BUILDFLAG(FIBER)
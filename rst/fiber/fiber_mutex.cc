@@ -0,0 +1,126 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/fiber/fiber_mutex.h"
+
+#if RST_BUILDFLAG(FIBER)
+
+#include "rst/check/check.h"
+
+namespace rst {
+
+FiberMutex::FiberMutex() = default;
+
+FiberMutex::~FiberMutex() { RST_DCHECK(!is_locked_); }
+
+void FiberMutex::lock() {
+  RST_DCHECK(this_fiber::IsInFiber());
+
+  std::unique_lock lock(mutex_);
+  if (!is_locked_) {
+    is_locked_ = true;
+    return;
+  }
+
+  // Owns the mutex when woken up.
+  internal::SuspendFiber(&waiters_, lock);
+}
+
+bool FiberMutex::try_lock() {
+  std::lock_guard lock(mutex_);
+  if (is_locked_)
+    return false;
+
+  is_locked_ = true;
+  return true;
+}
+
+void FiberMutex::unlock() {
+  Nullable<internal::Fiber*> waiter;
+  {
+    std::lock_guard lock(mutex_);
+    RST_DCHECK(is_locked_);
+    waiter = waiters_.Pop();
+    // Otherwise the ownership is handed over to |waiter|.
+    if (waiter == nullptr)
+      is_locked_ = false;
+  }
+
+  if (waiter != nullptr)
+    internal::WakeUpFiber(waiter.get());
+}
+
+FiberConditionVariable::FiberConditionVariable() = default;
+
+FiberConditionVariable::~FiberConditionVariable() = default;
+
+void FiberConditionVariable::Wait(std::unique_lock<FiberMutex>& lock) {
+  RST_DCHECK(lock.owns_lock());
+  RST_DCHECK(this_fiber::IsInFiber());
+
+  // Notifiers can't take the waiters before the fiber is registered, so a
+  // notification after |lock| is unlocked isn't lost.
+  std::unique_lock waiters_lock(mutex_);
+  lock.unlock();
+  internal::SuspendFiber(&waiters_, waiters_lock);
+  lock.lock();
+}
+
+void FiberConditionVariable::NotifyOne() {
+  Nullable<internal::Fiber*> waiter;
+  {
+    std::lock_guard lock(mutex_);
+    waiter = waiters_.Pop();
+  }
+
+  if (waiter != nullptr)
+    internal::WakeUpFiber(waiter.get());
+}
+
+void FiberConditionVariable::NotifyAll() {
+  internal::FiberQueue waiters;
+  {
+    std::lock_guard lock(mutex_);
+    while (true) {
+      auto waiter = waiters_.Pop();
+      if (waiter == nullptr)
+        break;
+      waiters.Push(waiter.get());
+    }
+  }
+
+  while (true) {
+    auto waiter = waiters.Pop();
+    if (waiter == nullptr)
+      break;
+    internal::WakeUpFiber(waiter.get());
+  }
+}
+
+}  // namespace rst
+
+#endif  // RST_BUILDFLAG(FIBER)
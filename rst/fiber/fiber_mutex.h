@@ -0,0 +1,121 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef RST_FIBER_FIBER_MUTEX_H_
+#define RST_FIBER_FIBER_MUTEX_H_
+
+#include "rst/fiber/fiber_context.h"
+
+#if RST_BUILDFLAG(FIBER)
+
+#include <mutex>
+
+#include "rst/fiber/fiber.h"
+#include "rst/macros/macros.h"
+
+namespace rst {
+
+// Mutex that suspends the waiting fiber instead of blocking its thread. The
+// ownership is handed over to the waiters in order. Must be locked from
+// fibers, but can be unlocked from another fiber.
+//
+// Example:
+//
+//   FiberMutex mutex;
+//   scheduler.Spawn([&mutex]() {
+//     std::lock_guard lock(mutex);
+//     ...
+//   });
+//
+class FiberMutex {
+ public:
+  FiberMutex();
+  ~FiberMutex();
+
+  // The lowercase names make it Lockable for std::lock_guard and
+  // std::unique_lock.
+  void lock();
+  bool try_lock();
+  void unlock();
+
+ private:
+  std::mutex mutex_;
+  bool is_locked_ = false;
+  internal::FiberQueue waiters_;
+
+  RST_DISALLOW_COPY_AND_ASSIGN(FiberMutex);
+};
+
+// Condition variable for FiberMutex that suspends the waiting fiber instead of
+// blocking its thread. Must be waited on from fibers.
+//
+// Example:
+//
+//   FiberMutex mutex;
+//   FiberConditionVariable cv;
+//   auto is_ready = false;
+//
+//   scheduler.Spawn([&mutex, &cv, &is_ready]() {
+//     std::unique_lock lock(mutex);
+//     cv.Wait(lock, [&is_ready]() { return is_ready; });
+//   });
+//   scheduler.Spawn([&mutex, &cv, &is_ready]() {
+//     std::lock_guard lock(mutex);
+//     is_ready = true;
+//     cv.NotifyOne();
+//   });
+//
+class FiberConditionVariable {
+ public:
+  FiberConditionVariable();
+  ~FiberConditionVariable();
+
+  // Unlocks |lock|, suspends the fiber until notified and locks |lock| again.
+  void Wait(std::unique_lock<FiberMutex>& lock);  // NOLINT
+
+  template <class Predicate>
+  void Wait(std::unique_lock<FiberMutex>& lock,  // NOLINT
+            Predicate predicate) {
+    while (!predicate())
+      Wait(lock);
+  }
+
+  void NotifyOne();
+  void NotifyAll();
+
+ private:
+  std::mutex mutex_;
+  internal::FiberQueue waiters_;
+
+  RST_DISALLOW_COPY_AND_ASSIGN(FiberConditionVariable);
+};
+
+}  // namespace rst
+
+#endif  // RST_BUILDFLAG(FIBER)
+
+#endif  // RST_FIBER_FIBER_MUTEX_H_
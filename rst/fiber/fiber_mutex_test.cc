@@ -0,0 +1,225 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/fiber/fiber_mutex.h"
+
+#if RST_BUILDFLAG(FIBER)
+
+#include <chrono>
+#include <deque>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "rst/fiber/fiber.h"
+#include "rst/task_runner/polling_task_runner.h"
+#include "rst/task_runner/thread_pool_task_runner.h"
+
+namespace chrono = std::chrono;
+
+namespace rst {
+namespace {
+
+chrono::milliseconds GetZeroFiberTime() { return chrono::milliseconds(0); }
+
+}  // namespace
+
+TEST(FiberMutex, MutualExclusion) {
+  static constexpr int kFibersNum = 100;
+  static constexpr int kIncrementsNum = 100;
+  auto counter = 0;
+  FiberMutex mutex;
+  {
+    ThreadPoolTaskRunner task_runner(4, GetZeroFiberTime);
+    FiberScheduler scheduler(&task_runner);
+    for (auto i = 0; i < kFibersNum; i++) {
+      scheduler.Spawn([&mutex, &counter]() {
+        for (auto j = 0; j < kIncrementsNum; j++) {
+          std::lock_guard lock(mutex);
+          const auto value = counter;
+          // Lets the other fibers run while the mutex is locked.
+          this_fiber::Yield();
+          counter = value + 1;
+        }
+      });
+    }
+  }
+  EXPECT_EQ(counter, kFibersNum * kIncrementsNum);
+}
+
+TEST(FiberMutex, BoundedTaskRunner) {
+  using OverflowPolicy = ThreadPoolTaskRunner::OverflowPolicy;
+  static constexpr int kFibersNum = 10;
+  static constexpr int kIncrementsNum = 100;
+  for (const auto policy :
+       {OverflowPolicy::kBlock, OverflowPolicy::kReject,
+        OverflowPolicy::kDropOldest, OverflowPolicy::kRunOnCaller}) {
+    auto counter = 0;
+    FiberMutex mutex;
+    ThreadPoolTaskRunner task_runner(2, GetZeroFiberTime);
+    task_runner.SetCapacity(1, policy);
+    {
+      FiberScheduler scheduler(&task_runner);
+      for (auto i = 0; i < kFibersNum; i++) {
+        scheduler.Spawn([&mutex, &counter]() {
+          for (auto j = 0; j < kIncrementsNum; j++) {
+            std::lock_guard lock(mutex);
+            const auto value = counter;
+            this_fiber::Yield();
+            counter = value + 1;
+          }
+        });
+      }
+    }
+    EXPECT_EQ(counter, kFibersNum * kIncrementsNum);
+
+    // The resumes of the fibers are queued over capacity.
+    const auto stats = task_runner.GetQueueStats();
+    EXPECT_EQ(stats.blocked, 0U);
+    EXPECT_EQ(stats.rejected, 0U);
+    EXPECT_EQ(stats.dropped, 0U);
+    EXPECT_EQ(stats.run_on_caller, 0U);
+  }
+}
+
+TEST(FiberMutex, HandsOverInOrder) {
+  PollingTaskRunner task_runner(GetZeroFiberTime);
+  FiberScheduler scheduler(&task_runner);
+  FiberMutex mutex;
+  std::string str;
+  for (auto i = 0; i < 5; i++) {
+    scheduler.Spawn([i, &mutex, &str]() {
+      std::lock_guard lock(mutex);
+      str += std::to_string(i);
+      this_fiber::Yield();
+    });
+  }
+
+  while (scheduler.fibers_num() != 0)
+    task_runner.RunPendingTasks();
+  EXPECT_EQ(str, "01234");
+}
+
+TEST(FiberMutex, TryLock) {
+  PollingTaskRunner task_runner(GetZeroFiberTime);
+  FiberScheduler scheduler(&task_runner);
+  FiberMutex mutex;
+  std::string str;
+  scheduler.Spawn([&mutex, &str]() {
+    std::lock_guard lock(mutex);
+    this_fiber::Yield();
+    str += "a";
+  });
+  scheduler.Spawn([&mutex, &str]() {
+    str += mutex.try_lock() ? "l" : "b";
+    this_fiber::Yield();
+    this_fiber::Yield();
+    str += mutex.try_lock() ? "l" : "b";
+    mutex.unlock();
+  });
+
+  while (scheduler.fibers_num() != 0)
+    task_runner.RunPendingTasks();
+  EXPECT_EQ(str, "bal");
+}
+
+TEST(FiberConditionVariable, ProducerConsumer) {
+  static constexpr int kItemsNum = 1000;
+  std::string consumed;
+  FiberMutex mutex;
+  FiberConditionVariable cv;
+  std::deque<int> queue;
+  {
+    ThreadPoolTaskRunner task_runner(4, GetZeroFiberTime);
+    FiberScheduler scheduler(&task_runner);
+
+    scheduler.Spawn([&mutex, &cv, &queue, &consumed]() {
+      for (auto i = 0; i < kItemsNum; i++) {
+        std::unique_lock lock(mutex);
+        cv.Wait(lock, [&queue]() { return !queue.empty(); });
+        consumed += std::to_string(queue.front());
+        queue.pop_front();
+      }
+    });
+    scheduler.Spawn([&mutex, &cv, &queue]() {
+      for (auto i = 0; i < kItemsNum; i++) {
+        {
+          std::lock_guard lock(mutex);
+          queue.emplace_back(i % 10);
+          cv.NotifyOne();
+        }
+        if (i % 7 == 0)
+          this_fiber::Yield();
+      }
+    });
+  }
+
+  std::string expected;
+  for (auto i = 0; i < kItemsNum; i++)
+    expected += std::to_string(i % 10);
+  EXPECT_EQ(consumed, expected);
+}
+
+TEST(FiberConditionVariable, NotifyAll) {
+  static constexpr int kWaitersNum = 50;
+  auto woken_num = 0;
+  FiberMutex mutex;
+  FiberConditionVariable cv;
+  auto is_ready = false;
+  auto waiting_num = 0;
+  {
+    ThreadPoolTaskRunner task_runner(4, GetZeroFiberTime);
+    FiberScheduler scheduler(&task_runner);
+
+    for (auto i = 0; i < kWaitersNum; i++) {
+      scheduler.Spawn([&mutex, &cv, &is_ready, &waiting_num, &woken_num]() {
+        std::unique_lock lock(mutex);
+        waiting_num++;
+        cv.Wait(lock, [&is_ready]() { return is_ready; });
+        woken_num++;
+      });
+    }
+    scheduler.Spawn([&mutex, &cv, &is_ready, &waiting_num]() {
+      while (true) {
+        {
+          std::lock_guard lock(mutex);
+          if (waiting_num == kWaitersNum) {
+            is_ready = true;
+            cv.NotifyAll();
+            return;
+          }
+        }
+        this_fiber::Yield();
+      }
+    });
+  }
+  EXPECT_EQ(woken_num, kWaitersNum);
+}
+
+}  // namespace rst
+
+#endif  // RST_BUILDFLAG(FIBER)
@@ -0,0 +1,150 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/fiber/fiber.h"
+
+#if RST_BUILDFLAG(FIBER)
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "rst/task_runner/polling_task_runner.h"
+#include "rst/task_runner/thread_pool_task_runner.h"
+
+namespace chrono = std::chrono;
+
+namespace rst {
+namespace {
+
+chrono::milliseconds GetSteadyTime() {
+  return chrono::duration_cast<chrono::milliseconds>(
+      chrono::steady_clock::now().time_since_epoch());
+}
+
+void RunUntilFinished(PollingTaskRunner& task_runner,  // NOLINT
+                      const FiberScheduler& scheduler) {
+  while (scheduler.fibers_num() != 0)
+    task_runner.RunPendingTasks();
+}
+
+}  // namespace
+
+TEST(Fiber, IsInFiber) {
+  EXPECT_FALSE(this_fiber::IsInFiber());
+
+  PollingTaskRunner task_runner(GetSteadyTime);
+  FiberScheduler scheduler(&task_runner);
+  auto is_in_fiber = false;
+  scheduler.Spawn(
+      [&is_in_fiber]() { is_in_fiber = this_fiber::IsInFiber(); });
+  EXPECT_EQ(scheduler.fibers_num(), 1U);
+  RunUntilFinished(task_runner, scheduler);
+  EXPECT_TRUE(is_in_fiber);
+  EXPECT_FALSE(this_fiber::IsInFiber());
+}
+
+TEST(Fiber, Yield) {
+  PollingTaskRunner task_runner(GetSteadyTime);
+  FiberScheduler scheduler(&task_runner);
+  std::string str;
+  scheduler.Spawn([&str]() {
+    str += "a";
+    this_fiber::Yield();
+    str += "b";
+  });
+  scheduler.Spawn([&str]() {
+    str += "c";
+    this_fiber::Yield();
+    str += "d";
+  });
+  task_runner.PostTask([&str]() { str += "t"; });
+
+  RunUntilFinished(task_runner, scheduler);
+  EXPECT_EQ(str, "actbd");
+}
+
+TEST(Fiber, SleepFor) {
+  auto ms = 0;
+  PollingTaskRunner task_runner(
+      [&ms]() -> chrono::milliseconds { return chrono::milliseconds(ms); });
+  FiberScheduler scheduler(&task_runner);
+  std::string str;
+  scheduler.Spawn([&str]() {
+    str += "a";
+    this_fiber::SleepFor(chrono::milliseconds(10));
+    str += "b";
+  });
+
+  task_runner.RunPendingTasks();
+  task_runner.RunPendingTasks();
+  EXPECT_EQ(str, "a");
+
+  ms = 10;
+  RunUntilFinished(task_runner, scheduler);
+  EXPECT_EQ(str, "ab");
+}
+
+TEST(Fiber, ManyFibers) {
+  static constexpr int kFibersNum = 10000;
+  std::atomic<int> counter = 0;
+  {
+    ThreadPoolTaskRunner task_runner(4, GetSteadyTime);
+    FiberScheduler scheduler(&task_runner, 16 * 1024);
+    for (auto i = 0; i < kFibersNum; i++) {
+      scheduler.Spawn([&counter]() {
+        this_fiber::SleepFor(chrono::milliseconds(1));
+        this_fiber::Yield();
+        counter++;
+      });
+    }
+  }
+  EXPECT_EQ(counter, kFibersNum);
+}
+
+TEST(Fiber, DeepStack) {
+  std::atomic<int> result = 0;
+  {
+    ThreadPoolTaskRunner task_runner(2, GetSteadyTime);
+    FiberScheduler scheduler(&task_runner, 256 * 1024);
+    scheduler.Spawn([&result]() {
+      // Touches most of the stack.
+      volatile char buffer[128 * 1024];
+      for (size_t i = 0; i < sizeof(buffer); i += 4096)
+        buffer[i] = 1;
+      this_fiber::Yield();
+      result = buffer[0] + buffer[sizeof(buffer) - 4096];
+    });
+  }
+  EXPECT_EQ(result, 2);
+}
+
+}  // namespace rst
+
+#endif  // RST_BUILDFLAG(FIBER)
@@ -34,6 +34,7 @@
 #include <optional>
 #include <utility>
 
+#include "rst/defer/scope_exit.h"
 #include "rst/guid/guid.h"
 #include "rst/macros/os.h"
 #include "rst/status/status_macros.h"
@@ -129,14 +130,17 @@ Status WriteFile(const NotNull<const char*> filename,
 Status WriteImportantFile(const NotNull<const char*> filename,
                           const std::string_view data) {
   const auto temp_filename = StrCat({filename, GenerateGuid(), ".tmp"});
+  auto remove_temp_file = ScopeExit(
+      [&temp_filename]() { (void)std::remove(temp_filename.c_str()); });
+
   RST_TRY(WriteFile(temp_filename.c_str(), "wxb", data));
 
   if (!Replace(temp_filename.c_str(), filename.get())) {
-    (void)std::remove(temp_filename.c_str());
     return MakeStatus<FileError>(
         StrCat({"Can't rename temp file ", temp_filename}));
   }
 
+  remove_temp_file.Dismiss();
   return Status::OK();
 }
 
@@ -0,0 +1,169 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/lazy_instance/lazy_instance.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
+
+#include "rst/no_destructor/no_destructor.h"
+#include "rst/strings/str_cat.h"
+
+namespace rst {
+namespace internal {
+
+uintptr_t WaitForLazyInstance(const NotNull<std::atomic<uintptr_t>*> state) {
+  constexpr uintptr_t kCreating = 1;
+  auto value = state->load(std::memory_order_acquire);
+  while (value == kCreating) {
+    std::this_thread::yield();
+    value = state->load(std::memory_order_acquire);
+  }
+
+  return value;
+}
+
+}  // namespace internal
+
+namespace {
+
+struct EagerInitializer {
+  std::string name;
+  std::vector<std::string> deps;
+  std::function<void()> init;
+};
+
+struct EagerInitRegistry {
+  std::mutex mutex;
+  std::vector<EagerInitializer> pending;
+  std::set<std::string> done;
+};
+
+EagerInitRegistry& GetEagerInitRegistry() {
+  static NoDestructor<EagerInitRegistry> registry;
+  return *registry;
+}
+
+}  // namespace
+
+void RegisterEagerInitializer(std::string&& name,
+                              std::vector<std::string>&& deps,
+                              std::function<void()>&& init) {
+  auto& registry = GetEagerInitRegistry();
+  std::lock_guard lock(registry.mutex);
+  registry.pending.push_back({std::move(name), std::move(deps),
+                              std::move(init)});
+}
+
+Status RunEagerInitializers() {
+  auto& registry = GetEagerInitRegistry();
+  std::vector<EagerInitializer> ordered;
+  {
+    std::lock_guard lock(registry.mutex);
+    auto pending = std::move(registry.pending);
+    registry.pending.clear();
+
+    std::set<std::string> names;
+    for (const auto& initializer : pending) {
+      if (registry.done.count(initializer.name) != 0 ||
+          !names.insert(initializer.name).second) {
+        return MakeStatus<EagerInitError>(
+            StrCat({"Duplicate eager initializer ", initializer.name}));
+      }
+    }
+
+    for (const auto& initializer : pending) {
+      for (const auto& dep : initializer.deps) {
+        if (names.count(dep) == 0 && registry.done.count(dep) == 0) {
+          return MakeStatus<EagerInitError>(
+              StrCat({"Eager initializer ", initializer.name,
+                      " depends on unknown ", dep}));
+        }
+      }
+    }
+
+    // Kahn's algorithm with the registration order as a tie breaker.
+    std::set<std::string> sorted;
+    std::vector<bool> is_sorted(pending.size(), false);
+    std::vector<size_t> order;
+    order.reserve(pending.size());
+    while (order.size() < pending.size()) {
+      const auto old_size = order.size();
+      for (size_t i = 0; i < pending.size(); i++) {
+        if (is_sorted[i])
+          continue;
+
+        const auto& deps = pending[i].deps;
+        const auto is_ready =
+            std::all_of(deps.cbegin(), deps.cend(),
+                        [&registry, &sorted](const std::string& dep) {
+                          return registry.done.count(dep) != 0 ||
+                                 sorted.count(dep) != 0;
+                        });
+        if (!is_ready)
+          continue;
+
+        is_sorted[i] = true;
+        sorted.insert(pending[i].name);
+        order.push_back(i);
+        break;
+      }
+
+      if (order.size() == old_size) {
+        return MakeStatus<EagerInitError>(
+            "Dependency cycle between eager initializers");
+      }
+    }
+
+    ordered.reserve(order.size());
+    for (const auto i : order) {
+      registry.done.insert(pending[i].name);
+      ordered.push_back(std::move(pending[i]));
+    }
+  }
+
+  // Initializers are run without the lock, so they can register new ones.
+  for (const auto& initializer : ordered)
+    initializer.init();
+
+  return Status::OK();
+}
+
+char EagerInitError::id_ = '\0';
+
+EagerInitError::EagerInitError(std::string&& message)
+    : message_(std::move(message)) {}
+
+EagerInitError::~EagerInitError() = default;
+
+const std::string& EagerInitError::AsString() const { return message_; }
+
+}  // namespace rst
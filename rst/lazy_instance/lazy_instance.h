@@ -0,0 +1,171 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef RST_LAZY_INSTANCE_LAZY_INSTANCE_H_
+#define RST_LAZY_INSTANCE_LAZY_INSTANCE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "rst/macros/macros.h"
+#include "rst/macros/optimization.h"
+#include "rst/not_null/not_null.h"
+#include "rst/status/status.h"
+
+namespace rst {
+namespace internal {
+
+// Spins until another thread finishes the construction and returns the stored
+// pointer.
+uintptr_t WaitForLazyInstance(NotNull<std::atomic<uintptr_t>*> state);
+
+}  // namespace internal
+
+// A thread-safe lazily constructed object with static storage duration that
+// never invokes the destructor.
+//
+// Unlike a function-local static NoDestructor<T>, LazyInstance<T> can be a
+// global: it's constant-initialized and trivially destructible, so it doesn't
+// require a static initializer or an exit-time destructor. After the object
+// is created Get() is a single acquire load and a branch.
+//
+// Example:
+//
+//   LazyInstance<std::mt19937> g_generator;
+//
+//   std::mt19937& GetGenerator() { return g_generator.Get(); }
+//
+// With a custom factory:
+//
+//   std::string CreateSession() { ... }
+//
+//   LazyInstance<std::string> g_session(&CreateSession);
+//
+// The factory must not call Get() on the same instance.
+template <class T>
+class LazyInstance {
+ public:
+  constexpr LazyInstance() = default;
+  constexpr explicit LazyInstance(T (*create)()) : create_(create) {}
+
+  ~LazyInstance() = default;
+
+  T& Get() {
+    const auto state = state_.load(std::memory_order_acquire);
+    if (RST_LIKELY(state > kCreating))
+      return *reinterpret_cast<T*>(state);
+
+    return *Create();
+  }
+
+  T& operator*() { return Get(); }
+  NotNull<T*> operator->() { return &Get(); }
+
+  // Returns true if the object has been created.
+  bool IsCreated() const {
+    return state_.load(std::memory_order_acquire) > kCreating;
+  }
+
+ private:
+  static constexpr uintptr_t kNotCreated = 0;
+  static constexpr uintptr_t kCreating = 1;
+
+  RST_ATTRIBUTE_NOINLINE T* Create() {
+    auto expected = kNotCreated;
+    if (state_.compare_exchange_strong(expected, kCreating,
+                                       std::memory_order_acquire)) {
+      T* instance = create_ == nullptr ? new (storage_) T()
+                                       : new (storage_) T(create_());
+      state_.store(reinterpret_cast<uintptr_t>(instance),
+                   std::memory_order_release);
+      return instance;
+    }
+
+    return reinterpret_cast<T*>(internal::WaitForLazyInstance(&state_));
+  }
+
+  // kNotCreated, kCreating or a pointer to the object in |storage_|.
+  std::atomic<uintptr_t> state_{kNotCreated};
+  T (*const create_)() = nullptr;
+  alignas(T) char storage_[sizeof(T)] = {};
+
+  RST_DISALLOW_COPY_AND_ASSIGN(LazyInstance);
+};
+
+// Eager initialization registry. Libraries register initializers, typically
+// ones calling LazyInstance<T>::Get() on expensive singletons, and the
+// application runs them once at startup so that hot paths never pay for the
+// construction.
+//
+// Example:
+//
+//   LazyInstance<Config> g_config;
+//   LazyInstance<Cache> g_cache;
+//
+//   int main() {
+//     RegisterEagerInitializer("config", {}, []() { g_config.Get(); });
+//     RegisterEagerInitializer("cache", {"config"}, []() { g_cache.Get(); });
+//     RST_CHECK(!RunEagerInitializers().err());
+//     ...
+//   }
+
+// Registers |init| to be run by RunEagerInitializers() after the initializers
+// named in |deps|.
+void RegisterEagerInitializer(std::string&& name,
+                              std::vector<std::string>&& deps,
+                              std::function<void()>&& init);
+
+// Runs all registered initializers that haven't been run yet in dependency
+// order, initializers without dependencies between them are run in the order
+// of registration. Returns EagerInitError without running anything if there is
+// a duplicate name, an unknown dependency or a dependency cycle; the pending
+// initializers are discarded then.
+Status RunEagerInitializers();
+
+class EagerInitError : public ErrorInfo<EagerInitError> {
+ public:
+  explicit EagerInitError(std::string&& message);
+  ~EagerInitError() override;
+
+  // ErrorInfo:
+  const std::string& AsString() const override;
+
+  static char id_;
+
+ private:
+  const std::string message_;
+
+  RST_DISALLOW_COPY_AND_ASSIGN(EagerInitError);
+};
+
+}  // namespace rst
+
+#endif  // RST_LAZY_INSTANCE_LAZY_INSTANCE_H_
@@ -0,0 +1,128 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/lazy_instance/lazy_instance.h"
+
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace rst {
+namespace {
+
+auto g_constructed = 0;
+
+struct Counted {
+  Counted() { g_constructed++; }
+  int value = 42;
+};
+
+LazyInstance<Counted> g_counted;
+
+std::string CreateString() { return "string"; }
+
+LazyInstance<std::string> g_string(&CreateString);
+
+}  // namespace
+
+TEST(LazyInstance, IsTriviallyDestructible) {
+  static_assert(std::is_trivially_destructible<LazyInstance<Counted>>::value);
+  static_assert(
+      std::is_trivially_destructible<LazyInstance<std::string>>::value);
+}
+
+TEST(LazyInstance, CreatesOnce) {
+  EXPECT_FALSE(g_counted.IsCreated());
+  EXPECT_EQ(g_constructed, 0);
+
+  EXPECT_EQ(g_counted.Get().value, 42);
+  EXPECT_TRUE(g_counted.IsCreated());
+  EXPECT_EQ(g_constructed, 1);
+
+  EXPECT_EQ(g_counted->value, 42);
+  EXPECT_EQ((*g_counted).value, 42);
+  EXPECT_EQ(g_constructed, 1);
+  EXPECT_EQ(&g_counted.Get(), &g_counted.Get());
+}
+
+TEST(LazyInstance, Factory) { EXPECT_EQ(g_string.Get(), "string"); }
+
+TEST(LazyInstance, Threads) {
+  static LazyInstance<std::vector<int>> instance;
+  std::vector<std::thread> threads;
+  std::vector<std::vector<int>*> results(8);
+  for (size_t i = 0; i < results.size(); i++) {
+    threads.emplace_back(
+        [&results, i]() { results[i] = &instance.Get(); });
+  }
+  for (auto& thread : threads)
+    thread.join();
+
+  for (auto result : results)
+    EXPECT_EQ(result, &instance.Get());
+}
+
+TEST(EagerInitializer, DependencyOrder) {
+  std::vector<std::string> order;
+  RegisterEagerInitializer("c", {"a", "b"},
+                           [&order]() { order.emplace_back("c"); });
+  RegisterEagerInitializer("b", {"a"}, [&order]() { order.emplace_back("b"); });
+  RegisterEagerInitializer("a", {}, [&order]() { order.emplace_back("a"); });
+  RegisterEagerInitializer("d", {}, [&order]() { order.emplace_back("d"); });
+  EXPECT_FALSE(RunEagerInitializers().err());
+  EXPECT_EQ(order, (std::vector<std::string>{"a", "b", "c", "d"}));
+
+  // Already run initializers are satisfied dependencies.
+  RegisterEagerInitializer("e", {"c"}, [&order]() { order.emplace_back("e"); });
+  EXPECT_FALSE(RunEagerInitializers().err());
+  EXPECT_EQ(order, (std::vector<std::string>{"a", "b", "c", "d", "e"}));
+
+  EXPECT_FALSE(RunEagerInitializers().err());
+  EXPECT_EQ(order.size(), 5U);
+}
+
+TEST(EagerInitializer, Errors) {
+  auto runs = 0;
+  RegisterEagerInitializer("x", {"y"}, [&runs]() { runs++; });
+  RegisterEagerInitializer("y", {"x"}, [&runs]() { runs++; });
+  auto status = RunEagerInitializers();
+  ASSERT_TRUE(status.err());
+  EXPECT_EQ(status.GetError()->AsString(),
+            "Dependency cycle between eager initializers");
+  EXPECT_EQ(runs, 0);
+
+  RegisterEagerInitializer("z", {"unknown"}, [&runs]() { runs++; });
+  status = RunEagerInitializers();
+  ASSERT_TRUE(status.err());
+  EXPECT_TRUE(status.GetError()->IsA<EagerInitError>());
+  EXPECT_EQ(runs, 0);
+}
+
+}  // namespace rst
@@ -0,0 +1,95 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef RST_LOCATION_LOCATION_H_
+#define RST_LOCATION_LOCATION_H_
+
+#include "rst/macros/macros.h"
+#include "rst/not_null/not_null.h"
+
+// Creates a Location of the current function, file and line.
+#define RST_FROM_HERE ::rst::Location(__func__, __FILE__, __LINE__)
+
+namespace rst {
+
+// Chromium-like location in the source code, for example the place where a
+// task has been posted from.
+//
+// Example:
+//
+//   void Foo(const Location& location) {
+//     std::printf("Called from %s\n", location.function_name().get());
+//   }
+//
+//   Foo(RST_FROM_HERE);
+//
+class Location {
+ public:
+  Location(NotNull<const char*> function_name, NotNull<const char*> file_name,
+           int line)
+      : function_name_(function_name), file_name_(file_name), line_(line) {}
+
+  NotNull<const char*> function_name() const { return function_name_; }
+  NotNull<const char*> file_name() const { return file_name_; }
+  int line() const { return line_; }
+
+ private:
+  NotNull<const char*> function_name_;
+  NotNull<const char*> file_name_;
+  int line_ = 0;
+};
+
+// Sets the location of the task running on the calling thread for the
+// lifetime of the object, for example to be reported in log lines. Keeps a
+// copy of the location. Scopes can be nested. TaskRunner::PostTask() with a
+// location sets it around the task.
+//
+// Example:
+//
+//   void RunTask(const Task& task) {
+//     ScopedTaskLocation scoped_location(task.location);
+//     task.function();
+//   }
+//
+class ScopedTaskLocation {
+ public:
+  explicit ScopedTaskLocation(const Location& location);
+  ~ScopedTaskLocation();
+
+  // Returns the location of the task running on the calling thread if any.
+  static Nullable<const Location*> Get();
+
+ private:
+  const Location location_;
+  const Location* const previous_;
+
+  RST_DISALLOW_COPY_AND_ASSIGN(ScopedTaskLocation);
+};
+
+}  // namespace rst
+
+#endif  // RST_LOCATION_LOCATION_H_
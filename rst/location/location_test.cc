@@ -0,0 +1,77 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/location/location.h"
+
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+namespace rst {
+namespace {
+
+// Returns the line of the task location on the calling thread or 0.
+int GetTaskLine() {
+  const auto location = ScopedTaskLocation::Get();
+  return location != nullptr ? location->line() : 0;
+}
+
+}  // namespace
+
+TEST(Location, FromHere) {
+  const auto line = __LINE__ + 1;
+  const auto location = RST_FROM_HERE;
+  EXPECT_EQ(std::string(location.function_name().get()), "TestBody");
+  EXPECT_EQ(std::string(location.file_name().get()), __FILE__);
+  EXPECT_EQ(location.line(), line);
+}
+
+TEST(ScopedTaskLocation, Nested) {
+  EXPECT_EQ(ScopedTaskLocation::Get(), nullptr);
+
+  const auto outer_line = __LINE__ + 2;
+  {
+    ScopedTaskLocation scoped_outer(RST_FROM_HERE);
+    EXPECT_EQ(GetTaskLine(), outer_line);
+
+    const auto inner_line = __LINE__ + 2;
+    {
+      ScopedTaskLocation scoped_inner(RST_FROM_HERE);
+      EXPECT_EQ(GetTaskLine(), inner_line);
+
+      std::thread thread(
+          []() { EXPECT_EQ(ScopedTaskLocation::Get(), nullptr); });
+      thread.join();
+    }
+    EXPECT_EQ(GetTaskLine(), outer_line);
+  }
+
+  EXPECT_EQ(ScopedTaskLocation::Get(), nullptr);
+}
+
+}  // namespace rst
@@ -0,0 +1,145 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/logger/json_lines_sink.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "rst/strings/arg.h"
+#include "rst/strings/json_escape.h"
+#include "rst/time/civil_time.h"
+#include "rst/time/rfc3339.h"
+
+namespace rst {
+namespace {
+
+constexpr size_t kInitialBufferSize = 512;
+// Size of "YYYY-MM-DDTHH:MM:SS".
+constexpr size_t kDateSize = 19;
+
+void AppendString(const std::string_view str, const NotNull<std::string*> out) {
+  *out += '"';
+  AppendJsonEscaped(str, out);
+  *out += '"';
+}
+
+// Returns true if |value| produced by Arg can be written unquoted. NaNs and
+// infinities aren't valid JSON numbers.
+bool IsJsonLiteral(const std::string_view value) {
+  if (value == "true" || value == "false")
+    return true;
+  if (value.empty())
+    return false;
+
+  const auto first = value.front() == '-' ? 1U : 0U;
+  if (first == value.size() || value[first] < '0' || value[first] > '9')
+    return false;
+
+  return value.find_first_of("in") == std::string_view::npos;
+}
+
+}  // namespace
+
+JsonLinesSink::JsonLinesSink(NotNull<std::unique_ptr<Sink>> sink)
+    : sink_(std::move(sink)) {
+  buffer_.reserve(kInitialBufferSize);
+}
+
+JsonLinesSink::~JsonLinesSink() = default;
+
+void JsonLinesSink::Log(const std::string_view message) {
+  std::lock_guard lock(mutex_);
+  buffer_.clear();
+  buffer_ += "{\"message\":";
+  AppendString(message, &buffer_);
+  buffer_ += '}';
+  sink_->Log(buffer_);
+}
+
+bool JsonLinesSink::IsStructured() const { return true; }
+
+void JsonLinesSink::LogStructured(const LogRecord& record) {
+  std::lock_guard lock(mutex_);
+  buffer_.clear();
+
+  auto second = record.time.count() / kMicrosecondsPerSecond;
+  auto fraction = record.time.count() % kMicrosecondsPerSecond;
+  if (fraction < 0) {
+    second--;
+    fraction += kMicrosecondsPerSecond;
+  }
+  if (second != date_second_) {
+    char time_buffer[kRfc3339BufferSize];
+    const auto time = FormatRfc3339(std::chrono::seconds(second),
+                                    std::chrono::seconds::zero(), time_buffer);
+    date_.assign(time.substr(0, kDateSize));
+    date_second_ = second;
+  }
+
+  // "YYYY-MM-DDTHH:MM:SS" is cached, only ".ffffffZ" is formatted.
+  char fraction_buffer[] = ".000000Z";
+  for (auto i = 6; i > 0; i--) {
+    fraction_buffer[i] = static_cast<char>('0' + fraction % 10);
+    fraction /= 10;
+  }
+
+  buffer_ += "{\"timestamp\":\"";
+  buffer_ += date_;
+  buffer_ += fraction_buffer;
+  buffer_ += "\",\"level\":\"";
+  buffer_ += record.level;
+  buffer_ += "\",\"file\":";
+  AppendString(record.filename.get(), &buffer_);
+  buffer_ += ",\"line\":";
+  buffer_ += internal::Arg(record.line).view();
+  buffer_ += ",\"message\":";
+  AppendString(record.message, &buffer_);
+
+  const auto fields = record.fields;
+  if (fields != nullptr) {
+    for (size_t i = 0; i < record.fields_size; i++) {
+      const auto& field = fields[i];
+      buffer_ += ',';
+      AppendString(field.key(), &buffer_);
+      buffer_ += ':';
+      if (!field.is_string() && IsJsonLiteral(field.value()))
+        buffer_ += field.value();
+      else
+        AppendString(field.value(), &buffer_);
+    }
+  }
+
+  buffer_ += '}';
+  sink_->Log(buffer_);
+}
+
+void JsonLinesSink::Flush() { sink_->Flush(); }
+
+}  // namespace rst
@@ -0,0 +1,85 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef RST_LOGGER_JSON_LINES_SINK_H_
+#define RST_LOGGER_JSON_LINES_SINK_H_
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include "rst/logger/sink.h"
+#include "rst/macros/macros.h"
+#include "rst/not_null/not_null.h"
+
+namespace rst {
+
+// A structured sink that encodes each record as one JSON object and passes it
+// as a line to the underlying |sink|:
+//
+//   {"timestamp":"2020-01-02T03:04:05.678901Z","level":"INFO","file":"a.cc",
+//    "line":12,"message":"Request done","path":"/","status":200}
+//
+// Key/value fields of RST_LOG_KV() follow the message, numbers and booleans
+// are written unquoted. Check failure messages are written as
+// {"message":"..."}. The encoding buffer is reused between records, so after
+// warming up logging doesn't allocate.
+//
+// Example:
+//
+//   Logger logger(std::make_unique<JsonLinesSink>(
+//       std::make_unique<FilePtrSink>(stderr)));
+//
+class JsonLinesSink final : public Sink {
+ public:
+  explicit JsonLinesSink(NotNull<std::unique_ptr<Sink>> sink);
+  ~JsonLinesSink() override;
+
+  // Sink:
+  void Log(std::string_view message) override;
+  bool IsStructured() const override;
+  void LogStructured(const LogRecord& record) override;
+  void Flush() override;
+
+ private:
+  std::mutex mutex_;
+  // Encoded record, reused to avoid allocations.
+  std::string buffer_;
+  // Formatted date and time of the last record up to seconds.
+  std::string date_;
+  int64_t date_second_ = std::numeric_limits<int64_t>::min();
+  const NotNull<std::unique_ptr<Sink>> sink_;
+
+  RST_DISALLOW_COPY_AND_ASSIGN(JsonLinesSink);
+};
+
+}  // namespace rst
+
+#endif  // RST_LOGGER_JSON_LINES_SINK_H_
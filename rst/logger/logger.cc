@@ -27,21 +27,148 @@
 
 #include "rst/logger/logger.h"
 
+#include <chrono>
+#include <cstddef>
 #include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <string>
+#include <thread>
 
+#include "rst/location/location.h"
 #include "rst/logger/log_error.h"
-#include "rst/strings/format.h"
+#include "rst/macros/optimization.h"
+#include "rst/macros/os.h"
+#include "rst/strings/arg.h"
+#include "rst/time/civil_time.h"
+#include "rst/time/rfc3339.h"
+#include "rst/time/time_zone.h"
+
+#if RST_BUILDFLAG(OS_WIN)
+#include <Windows.h>
+#elif RST_BUILDFLAG(OS_LINUX)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 namespace rst {
 namespace {
 
 Logger* g_logger = nullptr;
 
+// Set while the sink is logging a message, so that a check failure inside the
+// sink doesn't reenter it.
+thread_local bool t_is_in_sink = false;
+
+// The rendered "YYYY-MM-DD HH:MM:SS" part of the timestamp of the last line
+// logged by the thread. It's only re-rendered when the second changes.
+struct DateCache {
+  int64_t second = std::numeric_limits<int64_t>::min();
+  size_t size = 0;
+  char text[32] = {};
+};
+
+thread_local DateCache t_date_cache;
+thread_local uint64_t t_thread_id = 0;
+
+// Appends |value| padded with zeros up to |width| digits.
+void AppendNumber(const NotNull<std::string*> out, const uint64_t value,
+                  const size_t width) {
+  char buffer[internal::Arg::kBufferSize];
+  const auto str = internal::IntToString(buffer, value);
+  if (str.size() < width)
+    out->append(width - str.size(), '0');
+  out->append(str);
+}
+
+// Appends "seconds.microseconds".
+void AppendSeconds(const NotNull<std::string*> out,
+                   const std::chrono::microseconds time) {
+  const auto count = time.count();
+  AppendNumber(out, static_cast<uint64_t>(count / kMicrosecondsPerSecond), 0);
+  *out += '.';
+  AppendNumber(out, static_cast<uint64_t>(count % kMicrosecondsPerSecond), 6);
+}
+
+std::chrono::microseconds GetWallTime() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::system_clock::now().time_since_epoch());
+}
+
+void AppendTimestamp(const NotNull<std::string*> out,
+                     const std::chrono::microseconds time) {
+  const auto now = time.count();
+  auto second = now / kMicrosecondsPerSecond;
+  auto fraction = now % kMicrosecondsPerSecond;
+  if (fraction < 0) {
+    second--;
+    fraction += kMicrosecondsPerSecond;
+  }
+
+  auto& cache = t_date_cache;
+  if (RST_UNLIKELY(cache.second != second)) {
+    const std::chrono::seconds time(second);
+    char buffer[kRfc3339BufferSize];
+    const auto rfc3339 =
+        FormatRfc3339(time, GetLocalUtcOffset(time), buffer).substr(0, 19);
+    std::memcpy(cache.text, rfc3339.data(), rfc3339.size());
+    cache.text[10] = ' ';  // "YYYY-MM-DDTHH:MM:SS" -> "YYYY-MM-DD HH:MM:SS".
+    cache.size = rfc3339.size();
+    cache.second = second;
+  }
+
+  out->append(cache.text, cache.size);
+  *out += '.';
+  AppendNumber(out, static_cast<uint64_t>(fraction), 6);
+}
+
+void AppendMonotonicTime(const NotNull<std::string*> out) {
+  AppendSeconds(out, std::chrono::duration_cast<std::chrono::microseconds>(
+                         std::chrono::steady_clock::now().time_since_epoch()));
+}
+
+uint64_t GetThreadId() {
+  if (RST_LIKELY(t_thread_id != 0))
+    return t_thread_id;
+
+#if RST_BUILDFLAG(OS_WIN)
+  t_thread_id = ::GetCurrentThreadId();
+#elif RST_BUILDFLAG(OS_LINUX)
+  t_thread_id = static_cast<uint64_t>(::syscall(SYS_gettid));
+#else
+  t_thread_id = std::hash<std::thread::id>()(std::this_thread::get_id());
+#endif
+  return t_thread_id;
+}
+
 }  // namespace
 
+Logger::~Logger() {
+  if (g_logger == this) {
+    g_logger = nullptr;
+    SetCheckFailureHook(nullptr);
+  }
+}
+
 // static
 void Logger::Log(const Level level, const NotNull<const char*> filename,
                  const int line, const std::string_view message) {
+  LogImpl(level, filename, line, message, nullptr, 0);
+}
+
+// static
+void Logger::Log(const Level level, const NotNull<const char*> filename,
+                 const int line, const std::string_view message,
+                 const std::initializer_list<LogField> fields) {
+  LogImpl(level, filename, line, message, fields.begin(), fields.size());
+}
+
+// static
+void Logger::LogImpl(const Level level, const NotNull<const char*> filename,
+                     const int line, const std::string_view message,
+                     const Nullable<const LogField*> fields,
+                     const size_t fields_size) {
   RST_DCHECK(g_logger != nullptr);
   RST_DCHECK(line > 0);
 
@@ -77,15 +204,97 @@ void Logger::Log(const Level level, const NotNull<const char*> filename,
   }
   RST_DCHECK(level_str != nullptr);
 
-  g_logger->sink_->Log(
-      Format("[{}:{}({})] {}", {level_str, filename, line, message}));
+  t_is_in_sink = true;
+  if (g_logger->is_structured_) {
+    const LogRecord record{level_str, filename, line, GetWallTime(),
+                           message,   fields,   fields_size};
+    g_logger->sink_->LogStructured(record);
+  } else {
+    g_logger->sink_->Log(
+        FormatLine(level_str, filename, line, message, fields, fields_size));
+  }
+
+  if (RST_UNLIKELY(level == Level::kFatal)) {
+    g_logger->sink_->Flush();
+    std::abort();
+  }
+  t_is_in_sink = false;
+}
+
+// static
+std::string Logger::FormatLine(const NotNull<const char*> level_str,
+                               const NotNull<const char*> filename,
+                               const int line, const std::string_view message,
+                               const Nullable<const LogField*> fields,
+                               const size_t fields_size) {
+  const auto prefix_fields = g_logger->prefix_fields_;
+  std::string log_line;
+  log_line.reserve(message.size() + 128);
+  log_line += '[';
+  if ((prefix_fields & kTimestamp) != 0) {
+    AppendTimestamp(&log_line, GetWallTime());
+    log_line += ' ';
+  }
+  if ((prefix_fields & kMonotonicTime) != 0) {
+    AppendMonotonicTime(&log_line);
+    log_line += ' ';
+  }
+  if ((prefix_fields & kThreadId) != 0) {
+    AppendNumber(&log_line, GetThreadId(), 0);
+    log_line += ' ';
+  }
+
+  log_line += level_str.get();
+  log_line += ':';
+  log_line += filename.get();
+  log_line += '(';
+  AppendNumber(&log_line, static_cast<uint64_t>(line), 0);
+  log_line += ')';
 
-  RST_CHECK(level != Level::kFatal);
+  if ((prefix_fields & kTaskLocation) != 0) {
+    const auto location = ScopedTaskLocation::Get();
+    if (location != nullptr) {
+      log_line += ' ';
+      log_line += location->function_name().get();
+      log_line += '@';
+      log_line += location->file_name().get();
+      log_line += '(';
+      AppendNumber(&log_line, static_cast<uint64_t>(location->line()), 0);
+      log_line += ')';
+    }
+  }
+
+  log_line += "] ";
+  log_line += message;
+
+  if (fields != nullptr) {
+    for (size_t i = 0; i < fields_size; i++) {
+      const auto& field = fields[i];
+      log_line += ' ';
+      log_line += field.key();
+      log_line += '=';
+      log_line += field.value();
+    }
+  }
+
+  return log_line;
 }
 
 // static
 void Logger::SetGlobalLogger(const NotNull<Logger*> logger) {
   g_logger = logger.get();
+  SetCheckFailureHook(&Logger::OnCheckFailure);
+}
+
+// static
+bool Logger::OnCheckFailure(const std::string_view message) {
+  if (g_logger == nullptr || t_is_in_sink)
+    return false;
+
+  t_is_in_sink = true;
+  g_logger->sink_->Log(message);
+  g_logger->sink_->Flush();
+  return true;
 }
 
 }  // namespace rst
@@ -28,8 +28,11 @@
 #ifndef RST_LOGGER_LOGGER_H_
 #define RST_LOGGER_LOGGER_H_
 
+#include <cstddef>
 #include <cstdint>
+#include <initializer_list>
 #include <memory>
+#include <string>
 #include <string_view>
 #include <utility>
 
@@ -38,7 +41,9 @@
 #include "rst/macros/macros.h"
 #include "rst/not_null/not_null.h"
 
-// General logger component. Note that fatal logs exit the program.
+// General logger component. Note that fatal logs exit the program. The global
+// logger also receives RST_CHECK() failure messages and flushes its sink before
+// the program aborts.
 //
 // Example:
 //
@@ -70,6 +75,19 @@
 #define RST_LOG_FATAL(message) \
   ::rst::Logger::Log(::rst::Logger::Level::kFatal, __FILE__, __LINE__, message)
 
+// Logs a message with key/value fields at the |level|, one of Logger::Level
+// enumerators. Structured sinks get the fields as separate values, text sinks
+// get them appended as " key=value".
+//
+// Example:
+//
+//   RST_LOG_KV(kInfo, "Request done", {"path", path}, {"status", 200},
+//              {"ms", elapsed_ms});
+//
+#define RST_LOG_KV(level, message, ...)                               \
+  ::rst::Logger::Log(::rst::Logger::Level::level, __FILE__, __LINE__, \
+                     message, {__VA_ARGS__})
+
 // Like RST_LOG_* macros but compiles to nothing in release build.
 #if RST_BUILDFLAG(DCHECK_IS_ON)
 #define RST_DLOG_DEBUG(message) RST_LOG_DEBUG(message)
@@ -101,23 +119,64 @@ class Logger {
     kOff,
   };
 
+  // Optional fields of the log line prefix, a bitmask. The default prefix is
+  // "[LEVEL:file(line)] ", the enabled fields are added as
+  // "[timestamp monotonic thread LEVEL:file(line) task] ", for example
+  // "[2020-01-02 03:04:05.678901 12.345678 1234 INFO:a.cc(12) Run@b.cc(5)] ".
+  enum PrefixField : uint32_t {
+    kNoFields = 0,
+    // Local wall-clock time with microsecond precision.
+    kTimestamp = 1 << 0,
+    // Seconds since an unspecified point with microsecond precision.
+    kMonotonicTime = 1 << 1,
+    // Operating system thread id.
+    kThreadId = 1 << 2,
+    // Location of the task set by ScopedTaskLocation, if any.
+    kTaskLocation = 1 << 3,
+    kAllFields = kTimestamp | kMonotonicTime | kThreadId | kTaskLocation,
+  };
+
   explicit Logger(NotNull<std::unique_ptr<Sink>> sink)
-      : sink_(std::move(sink)) {}
-  ~Logger() = default;
+      : sink_(std::move(sink)), is_structured_(sink_->IsStructured()) {}
+  // Resets the global logger if it's this instance.
+  ~Logger();
 
   // Logs a |message|. If the |level| is less than |level_| nothing gets logged.
   static void Log(Level level, NotNull<const char*> filename, int line,
                   std::string_view message);
+  // Logs a |message| with key/value |fields|.
+  static void Log(Level level, NotNull<const char*> filename, int line,
+                  std::string_view message,
+                  std::initializer_list<LogField> fields);
 
-  // Sets |logger| as a global logger instance.
+  // Sets |logger| as a global logger instance and routes check failure
+  // messages to it.
   static void SetGlobalLogger(NotNull<Logger*> logger);
 
   void set_level(Level level) { level_ = level; }
+  void set_prefix_fields(uint32_t fields) { prefix_fields_ = fields; }
 
  private:
+  static void LogImpl(Level level, NotNull<const char*> filename, int line,
+                      std::string_view message,
+                      Nullable<const LogField*> fields, size_t fields_size);
+
+  // Formats a line for text sinks.
+  static std::string FormatLine(NotNull<const char*> level_str,
+                                NotNull<const char*> filename, int line,
+                                std::string_view message,
+                                Nullable<const LogField*> fields,
+                                size_t fields_size);
+
+  // Logs a check failure |message| and flushes the sink of the global logger.
+  static bool OnCheckFailure(std::string_view message);
+
   const NotNull<std::unique_ptr<Sink>> sink_;
+  const bool is_structured_;
   // Current severity level.
   Level level_ = Level::kAll;
+  // Bitmask of PrefixField.
+  uint32_t prefix_fields_ = kNoFields;
 
   RST_DISALLOW_COPY_AND_ASSIGN(Logger);
 };
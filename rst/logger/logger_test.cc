@@ -28,6 +28,7 @@
 #include "rst/logger/logger.h"
 
 #include <algorithm>
+#include <cmath>
 #include <cstdarg>
 #include <cstddef>
 #include <cstdio>
@@ -44,8 +45,10 @@
 #include <gtest/gtest.h>
 
 #include "rst/check/check.h"
+#include "rst/location/location.h"
 #include "rst/logger/file_name_sink.h"
 #include "rst/logger/file_ptr_sink.h"
+#include "rst/logger/json_lines_sink.h"
 #include "rst/logger/log_error.h"
 #include "rst/logger/sink.h"
 #include "rst/macros/macros.h"
@@ -53,6 +56,7 @@
 
 using testing::_;
 using testing::Eq;
+using testing::MatchesRegex;
 
 namespace rst {
 namespace {
@@ -81,6 +85,31 @@ class SinkMock : public Sink {
   MOCK_METHOD(void, Log, (std::string_view message), (override));
 };
 
+class FlushingSink : public Sink {
+ public:
+  void Log(const std::string_view message) override { message_ = message; }
+
+  void Flush() override {
+    std::fprintf(stderr, "Flushed: %s\n", message_.c_str());
+  }
+
+ private:
+  std::string message_;
+};
+
+class StringsSink : public Sink {
+ public:
+  explicit StringsSink(NotNull<std::vector<std::string>*> lines)
+      : lines_(lines) {}
+
+  void Log(const std::string_view message) override {
+    lines_->emplace_back(message);
+  }
+
+ private:
+  const NotNull<std::vector<std::string>*> lines_;
+};
+
 }  // namespace
 
 TEST(Logger, Log) {
@@ -94,6 +123,32 @@ TEST(Logger, Log) {
   Logger::Log(Logger::Level::kDebug, kFilename, kLine, kMessage);
 }
 
+TEST(Logger, PrefixFields) {
+  auto sink = std::make_unique<SinkMock>();
+
+  EXPECT_CALL(*sink, Log(MatchesRegex("\\[[0-9]{4}-[0-9]{2}-[0-9]{2} "
+                                      "[0-9]{2}:[0-9]{2}:[0-9]{2}\\.[0-9]{6} "
+                                      "[0-9]+\\.[0-9]{6} [0-9]+ "
+                                      "DEBUG:filename\\(10\\) "
+                                      "TestBody@.+\\([0-9]+\\)\\] message")));
+  EXPECT_CALL(*sink, Log(MatchesRegex("\\[[0-9]+ DEBUG:filename\\(10\\)\\] "
+                                      "message")))
+      .Times(2);
+
+  Logger logger(std::move(sink));
+  Logger::SetGlobalLogger(&logger);
+  logger.set_prefix_fields(Logger::kAllFields);
+  {
+    const auto location = RST_FROM_HERE;
+    ScopedTaskLocation scoped_location(location);
+    Logger::Log(Logger::Level::kDebug, kFilename, kLine, kMessage);
+  }
+
+  logger.set_prefix_fields(Logger::kThreadId | Logger::kTaskLocation);
+  Logger::Log(Logger::Level::kDebug, kFilename, kLine, kMessage);
+  Logger::Log(Logger::Level::kDebug, kFilename, kLine, kMessage);
+}
+
 TEST(Logger, LogSeverityLevelComparison) {
   auto sink = std::make_unique<SinkMock>();
 
@@ -207,6 +262,21 @@ TEST(Logger, Macros) {
   EXPECT_DEATH(RST_LOG_FATAL(kMessage), "");
 }
 
+TEST(Logger, KeyValueFields) {
+  auto sink = std::make_unique<SinkMock>();
+
+  EXPECT_CALL(*sink, Log(Eq(std::string("[") + kLevelStr + ":" + kFilename +
+                            "(" + kLineStr + ")] " + kMessage +
+                            " path=/a status=200 ok=true")));
+  EXPECT_CALL(*sink, Log(MatchesRegex(".*INFO.*\\] message key=value")));
+
+  Logger logger(std::move(sink));
+  Logger::SetGlobalLogger(&logger);
+  Logger::Log(Logger::Level::kDebug, kFilename, kLine, kMessage,
+              {{"path", "/a"}, {"status", 200}, {"ok", true}});
+  RST_LOG_KV(kInfo, kMessage, {"key", std::string("value")});
+}
+
 TEST(Logger, DebugMacros) {
   auto sink = std::make_unique<SinkMock>();
 
@@ -240,6 +310,31 @@ TEST(Logger, NegativeLine) {
   EXPECT_DEATH(Logger::Log(Logger::Level::kDebug, kFilename, -1, kMessage), "");
 }
 
+TEST(Logger, FatalFlushesSink) {
+  Logger logger(std::make_unique<FlushingSink>());
+  Logger::SetGlobalLogger(&logger);
+
+  EXPECT_DEATH(RST_LOG_FATAL(kMessage), "Flushed: \\[FATAL:.*\\] message");
+}
+
+TEST(Logger, CheckFailure) {
+  Logger logger(std::make_unique<FlushingSink>());
+  Logger::SetGlobalLogger(&logger);
+
+  EXPECT_DEATH(RST_CHECK_EQ(1, 2),
+               "Flushed: \\[FATAL:.*\\] Check failed: 1 == 2 "
+               "\\(1 vs. 2\\)");
+}
+
+TEST(Logger, CheckFailureAfterLoggerDestruction) {
+  {
+    Logger logger(std::make_unique<FlushingSink>());
+    Logger::SetGlobalLogger(&logger);
+  }
+
+  EXPECT_DEATH(RST_CHECK(false), "^\\[FATAL:.*\\] Check failed: false");
+}
+
 TEST(FileNameSink, Log) {
   File file;
   const auto filename = file.FileName();
@@ -296,6 +391,43 @@ TEST(FileNameSink, LogThreadSafe) {
   EXPECT_EQ(strings, messages);
 }
 
+TEST(JsonLinesSink, Log) {
+  std::vector<std::string> lines;
+  Logger logger(std::make_unique<JsonLinesSink>(
+      std::make_unique<StringsSink>(&lines)));
+  Logger::SetGlobalLogger(&logger);
+
+  Logger::Log(Logger::Level::kWarning, "dir/file.cc", kLine, "say \"hi\"\n");
+  RST_LOG_KV(kError, kMessage, {"path", "/a\\b"}, {"status", 200},
+             {"ratio", 0.5}, {"ok", false}, {"nan", std::nan("")},
+             {"number_string", "42"});
+
+  ASSERT_EQ(lines.size(), 2U);
+  EXPECT_THAT(lines[0],
+              MatchesRegex("\\{\"timestamp\":\"[0-9]{4}-[0-9]{2}-[0-9]{2}T"
+                           "[0-9]{2}:[0-9]{2}:[0-9]{2}\\.[0-9]{6}Z\","
+                           "\"level\":\"WARNING\",\"file\":\"dir/file.cc\","
+                           "\"line\":10,\"message\":"
+                           "\"say \\\\\"hi\\\\\"\\\\n\"\\}"));
+
+  EXPECT_NE(lines[1].find(std::string("\"level\":\"ERROR\",\"file\":\"") +
+                          __FILE__ + "\",\"line\":"),
+            std::string::npos);
+  EXPECT_EQ(lines[1].substr(lines[1].find(",\"message\"")),
+            ",\"message\":\"message\",\"path\":\"/a\\\\b\",\"status\":200,"
+            "\"ratio\":0.5,\"ok\":false,\"nan\":\"nan\","
+            "\"number_string\":\"42\"}");
+}
+
+TEST(JsonLinesSink, CheckFailure) {
+  std::vector<std::string> lines;
+  JsonLinesSink sink(std::make_unique<StringsSink>(&lines));
+  EXPECT_TRUE(sink.IsStructured());
+  sink.Log("Check failed: \"x\"");
+  ASSERT_EQ(lines.size(), 1U);
+  EXPECT_EQ(lines[0], "{\"message\":\"Check failed: \\\"x\\\"\"}");
+}
+
 TEST(FilePtrSink, Log) {
   const auto file = tmpfile();
 
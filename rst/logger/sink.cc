@@ -31,4 +31,10 @@ namespace rst {
 
 Sink::~Sink() = default;
 
+bool Sink::IsStructured() const { return false; }
+
+void Sink::LogStructured(const LogRecord&) {}
+
+void Sink::Flush() {}
+
 }  // namespace rst
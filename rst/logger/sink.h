@@ -28,16 +28,76 @@
 #ifndef RST_LOGGER_SINK_H_
 #define RST_LOGGER_SINK_H_
 
+#include <chrono>
+#include <cstddef>
+#include <string>
 #include <string_view>
+#include <type_traits>
+
+#include "rst/macros/macros.h"
+#include "rst/not_null/not_null.h"
+#include "rst/strings/arg.h"
 
 namespace rst {
 
+// A key/value field of a structured log record, see RST_LOG_KV(). Strings are
+// kept as strings, numbers and booleans are converted to their text
+// representation but marked as non-strings, so that structured sinks can emit
+// them unquoted.
+class LogField {
+ public:
+  template <class T>
+  LogField(const std::string_view key, const T& value)
+      : key_(key),
+        value_(value),
+        is_string_(std::is_convertible<const T&, std::string_view>::value ||
+                   std::is_same<T, NotNull<const char*>>::value ||
+                   std::is_same<T, char>::value) {}
+
+  ~LogField() = default;
+
+  std::string_view key() const { return key_; }
+  std::string_view value() const { return value_.view(); }
+  bool is_string() const { return is_string_; }
+
+ private:
+  const std::string_view key_;
+  const internal::Arg value_;
+  const bool is_string_;
+
+  RST_DISALLOW_COPY_AND_ASSIGN(LogField);
+};
+
+// A log record passed to structured sinks.
+struct LogRecord {
+  std::string_view level;
+  NotNull<const char*> filename;
+  int line = 0;
+  // Wall-clock time since the Unix epoch.
+  std::chrono::microseconds time;
+  std::string_view message;
+  Nullable<const LogField*> fields;
+  size_t fields_size = 0;
+};
+
 // The interface for the logger sink.
 class Sink {
  public:
   virtual ~Sink();
 
   virtual void Log(std::string_view message) = 0;
+
+  // Returns true if the logger should pass records to LogStructured() instead
+  // of formatted lines to Log(). Check failure messages are always passed to
+  // Log(). Returns false by default.
+  virtual bool IsStructured() const;
+
+  // Logs a structured |record|. Does nothing by default.
+  virtual void LogStructured(const LogRecord& record);
+
+  // Writes out buffered messages. Called before the program aborts on a fatal
+  // log or a check failure. Does nothing by default.
+  virtual void Flush();
 };
 
 }  // namespace rst
@@ -0,0 +1,66 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef RST_MACROS_ARCH_H_
+#define RST_MACROS_ARCH_H_
+
+// Macros to test the current processor architecture.
+//
+// Example:
+//
+//   #include "rst/macros/arch.h"
+//
+//   #if RST_BUILDFLAG(ARCH_CPU_X86_FAMILY)
+//   x86 or x86-64 code.
+//   #endif
+//
+//   #if RST_BUILDFLAG(ARCH_CPU_ARM64)
+//   ARM64 code.
+//   #endif
+//
+#if defined(__x86_64__) || defined(_M_X64)
+#define RST_BUILDFLAG_ARCH_CPU_X86_64() (true)
+#else
+#define RST_BUILDFLAG_ARCH_CPU_X86_64() (false)
+#endif
+
+#if defined(__i386__) || defined(_M_IX86)
+#define RST_BUILDFLAG_ARCH_CPU_X86() (true)
+#else
+#define RST_BUILDFLAG_ARCH_CPU_X86() (false)
+#endif
+
+#define RST_BUILDFLAG_ARCH_CPU_X86_FAMILY() \
+  (RST_BUILDFLAG_ARCH_CPU_X86_64() || RST_BUILDFLAG_ARCH_CPU_X86())
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define RST_BUILDFLAG_ARCH_CPU_ARM64() (true)
+#else
+#define RST_BUILDFLAG_ARCH_CPU_ARM64() (false)
+#endif
+
+#endif  // RST_MACROS_ARCH_H_
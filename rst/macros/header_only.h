@@ -0,0 +1,64 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef RST_MACROS_HEADER_ONLY_H_
+#define RST_MACROS_HEADER_ONLY_H_
+
+// Header-only mode: the hot non-template functions of the library, like
+// Format() and StrCat(), are defined inline in their headers instead of in the
+// compiled library, so that they can be inlined into the callers without LTO.
+// Enabled by defining RST_HEADER_ONLY, e.g. with the RST_HEADER_ONLY CMake
+// option.
+//
+// Example:
+//
+//   // foo.h
+//   RST_HEADER_ONLY_INLINE void Foo();
+//
+//   #if RST_BUILDFLAG(HEADER_ONLY)
+//   #include "foo-inl.h"
+//   #endif
+//
+//   // foo-inl.h
+//   RST_HEADER_ONLY_INLINE void Foo() { ... }
+//
+//   // foo.cc
+//   #include "foo.h"
+//
+//   #if !RST_BUILDFLAG(HEADER_ONLY)
+//   #include "foo-inl.h"
+//   #endif
+//
+#if defined(RST_HEADER_ONLY)
+#define RST_BUILDFLAG_HEADER_ONLY() (true)
+#define RST_HEADER_ONLY_INLINE inline
+#else
+#define RST_BUILDFLAG_HEADER_ONLY() (false)
+#define RST_HEADER_ONLY_INLINE
+#endif
+
+#endif  // RST_MACROS_HEADER_ONLY_H_
@@ -28,6 +28,9 @@
 #ifndef RST_MACROS_OPTIMIZATION_H_
 #define RST_MACROS_OPTIMIZATION_H_
 
+#include <cstddef>
+#include <new>
+
 // Enables the compiler to prioritize compilation using static analysis for
 // likely paths within a boolean or switch branches.
 //
@@ -70,4 +73,204 @@
 #define RST_LIKELY(x) RST_LIKELY_EQ(x, 1)
 #define RST_UNLIKELY(x) RST_LIKELY_EQ(x, 0)
 
+// Tells the compiler that a function is a hot spot of the program. The
+// function is optimized more aggressively and placed in a special subsection
+// of the text section so that all hot functions appear close together,
+// improving locality.
+//
+// Example:
+//
+//   RST_ATTRIBUTE_HOT void ProcessPacket(Packet* packet);
+//
+#if defined(__GNUC__) || defined(__clang__)
+#define RST_ATTRIBUTE_HOT __attribute__((hot))
+#else
+#define RST_ATTRIBUTE_HOT
+#endif
+
+// Tells the compiler that a function is unlikely to be executed. The function
+// is optimized for size rather than speed and placed in a special subsection
+// of the text section so that all cold functions appear close together,
+// improving code locality of the non-cold parts of the program. The paths
+// leading to calls of cold functions are marked as unlikely.
+//
+// Example:
+//
+//   RST_ATTRIBUTE_COLD void ReportError();
+//
+#if defined(__GNUC__) || defined(__clang__)
+#define RST_ATTRIBUTE_COLD __attribute__((cold))
+#else
+#define RST_ATTRIBUTE_COLD
+#endif
+
+// Prevents a function from being considered for inlining.
+//
+// Example:
+//
+//   RST_ATTRIBUTE_NOINLINE void Foo();
+//
+#if defined(__GNUC__) || defined(__clang__)
+#define RST_ATTRIBUTE_NOINLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define RST_ATTRIBUTE_NOINLINE __declspec(noinline)
+#else
+#define RST_ATTRIBUTE_NOINLINE
+#endif
+
+// Forces a function to be inlined even when optimization is disabled. Use it
+// for tiny functions on hot paths where the call overhead is measurable.
+//
+// Example:
+//
+//   RST_ATTRIBUTE_ALWAYS_INLINE inline int Twice(int x) { return x * 2; }
+//
+#if defined(__GNUC__) || defined(__clang__)
+#define RST_ATTRIBUTE_ALWAYS_INLINE __attribute__((always_inline))
+#elif defined(_MSC_VER)
+#define RST_ATTRIBUTE_ALWAYS_INLINE __forceinline
+#else
+#define RST_ATTRIBUTE_ALWAYS_INLINE
+#endif
+
+// Inlines every call inside the function body if possible.
+//
+// Example:
+//
+//   RST_ATTRIBUTE_FLATTEN void Loop();
+//
+#if defined(__GNUC__) || defined(__clang__)
+#define RST_ATTRIBUTE_FLATTEN __attribute__((flatten))
+#else
+#define RST_ATTRIBUTE_FLATTEN
+#endif
+
+// Selects the initial-exec TLS model for a thread_local variable. An access is
+// then a load at a fixed offset from the thread pointer even in a shared
+// library, instead of a __tls_get_addr() call. Such a library can still be
+// dlopen()'ed as long as the variables fit into the static TLS surplus
+// reserved by the loader, so keep them small.
+//
+// Example:
+//
+//   thread_local Foo* foo RST_ATTRIBUTE_TLS_INITIAL_EXEC = nullptr;
+//
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__ELF__)
+#define RST_ATTRIBUTE_TLS_INITIAL_EXEC \
+  __attribute__((tls_model("initial-exec")))
+#else
+#define RST_ATTRIBUTE_TLS_INITIAL_EXEC
+#endif
+
+// Tells the compiler that |condition| is always true, so it can optimize the
+// code around it. The behavior is undefined if |condition| is false, so prefer
+// RST_DCHECK() unless profiling proves the hint useful. |condition| must not
+// have side effects: it may or may not be evaluated.
+//
+// Example:
+//
+//   int Divide(int a, int b) {
+//     RST_ASSUME(b > 0);
+//     return a / b;  // No code for negative b.
+//   }
+//
+#if defined(__clang__)
+#define RST_ASSUME(condition) __builtin_assume(condition)
+#elif defined(__GNUC__)
+#define RST_ASSUME(condition)  \
+  do {                         \
+    if (!(condition))          \
+      __builtin_unreachable(); \
+  } while (false)
+#elif defined(_MSC_VER)
+#define RST_ASSUME(condition) __assume(condition)
+#else
+#define RST_ASSUME(condition) static_cast<void>(0)
+#endif
+
+// Fetches the cache line containing |addr| ahead of use. |rw| is 0 for a read
+// and 1 for a write. |locality| ranges from 0 (no temporal locality, the data
+// can be evicted right after the access) to 3 (keep in all cache levels). Both
+// must be compile time constants. Never faults, so |addr| may be invalid.
+//
+// Example:
+//
+//   for (size_t i = 0; i < size; i++) {
+//     RST_PREFETCH(&nodes[i + 8], 0, 3);
+//     Process(nodes[i]);
+//   }
+//
+#if defined(__GNUC__) || defined(__clang__)
+#define RST_PREFETCH(addr, rw, locality) __builtin_prefetch(addr, rw, locality)
+#else
+#define RST_PREFETCH(addr, rw, locality) \
+  static_cast<void>(static_cast<const volatile void*>(addr))
+#endif
+
+// Hints the CPU that the thread is in a spin-wait loop. On x86 it's the pause
+// instruction that saves power and avoids the memory order violation on the
+// loop exit, on ARM it's yield that lets the other hardware thread run.
+//
+// Example:
+//
+//   while (!flag.load(std::memory_order_acquire))
+//     RST_CPU_RELAX();
+//
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define RST_CPU_RELAX() __builtin_ia32_pause()
+#elif (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__aarch64__) || defined(__arm__))
+#define RST_CPU_RELAX() __asm__ __volatile__("yield" ::: "memory")
+#else
+#define RST_CPU_RELAX() static_cast<void>(0)
+#endif
+
+// Tells the compiler that the pointer is the only way to access the object it
+// points to, so that stores through other pointers don't force reloads.
+//
+// Example:
+//
+//   void Add(int* RST_RESTRICT out, const int* RST_RESTRICT in, size_t size);
+//
+#if defined(__GNUC__) || defined(__clang__)
+#define RST_RESTRICT __restrict__
+#elif defined(_MSC_VER)
+#define RST_RESTRICT __restrict
+#else
+#define RST_RESTRICT
+#endif
+
+// The size of a cache line, that is the minimum offset between two objects to
+// avoid false sharing. Apple Silicon and POWER have 128 bytes lines, x86 and
+// other ARM cores have 64 bytes ones. For unknown architectures
+// std::hardware_destructive_interference_size is used if available.
+//
+// Example:
+//
+//   struct Counters {
+//     RST_CACHELINE_ALIGNED std::atomic<int> produced;
+//     RST_CACHELINE_ALIGNED std::atomic<int> consumed;
+//   };
+//
+#if (defined(__APPLE__) && defined(__aarch64__)) || defined(__powerpc64__)
+#define RST_CACHELINE_SIZE 128
+#elif defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+    defined(_M_IX86) || defined(__aarch64__) || defined(_M_ARM64) || \
+    defined(__arm__) || defined(_M_ARM)
+#define RST_CACHELINE_SIZE 64
+#elif defined(__cpp_lib_hardware_interference_size)
+#define RST_CACHELINE_SIZE std::hardware_destructive_interference_size
+#else
+#define RST_CACHELINE_SIZE 64
+#endif
+
+#define RST_CACHELINE_ALIGNED alignas(RST_CACHELINE_SIZE)
+
+namespace rst {
+
+inline constexpr size_t kCacheLineSize = RST_CACHELINE_SIZE;
+
+}  // namespace rst
+
 #endif  // RST_MACROS_OPTIMIZATION_H_
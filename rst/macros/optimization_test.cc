@@ -0,0 +1,122 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/macros/optimization.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#include <gtest/gtest.h>
+
+namespace rst {
+namespace {
+
+struct Counters {
+  RST_CACHELINE_ALIGNED int produced = 0;
+  RST_CACHELINE_ALIGNED int consumed = 0;
+};
+
+RST_ATTRIBUTE_HOT int Hot(const int x) { return x + 1; }
+RST_ATTRIBUTE_COLD RST_ATTRIBUTE_NOINLINE int Cold(const int x) {
+  return x - 1;
+}
+RST_ATTRIBUTE_ALWAYS_INLINE inline int AlwaysInline(const int x) {
+  return x * 2;
+}
+RST_ATTRIBUTE_FLATTEN int Flatten(const int x) {
+  return AlwaysInline(Hot(x));
+}
+
+int Assume(const int x) {
+  RST_ASSUME(x > 0);
+  return x / 2;
+}
+
+void Add(int* RST_RESTRICT out, const int* RST_RESTRICT in,
+         const size_t size) {
+  for (size_t i = 0; i < size; i++)
+    out[i] += in[i];
+}
+
+}  // namespace
+
+TEST(Optimization, Likely) {
+  auto x = 1;
+  EXPECT_TRUE(RST_LIKELY(x == 1));
+  EXPECT_FALSE(RST_UNLIKELY(x != 1));
+  EXPECT_EQ(RST_LIKELY_EQ(x, 1), 1);
+}
+
+TEST(Optimization, Attributes) {
+  EXPECT_EQ(Hot(1), 2);
+  EXPECT_EQ(Cold(1), 0);
+  EXPECT_EQ(AlwaysInline(2), 4);
+  EXPECT_EQ(Flatten(1), 4);
+}
+
+TEST(Optimization, Assume) { EXPECT_EQ(Assume(4), 2); }
+
+TEST(Optimization, Prefetch) {
+  int values[4] = {1, 2, 3, 4};
+  RST_PREFETCH(&values[0], 0, 3);
+  RST_PREFETCH(&values[2], 1, 0);
+  // Prefetching an invalid address doesn't fault.
+  RST_PREFETCH(static_cast<const int*>(nullptr), 0, 0);
+  EXPECT_EQ(values[3], 4);
+}
+
+TEST(Optimization, CpuRelax) {
+  auto iterations = 0;
+  for (auto i = 0; i < 3; i++) {
+    RST_CPU_RELAX();
+    iterations++;
+  }
+  EXPECT_EQ(iterations, 3);
+}
+
+TEST(Optimization, Restrict) {
+  int out[3] = {1, 2, 3};
+  const int in[3] = {10, 20, 30};
+  Add(out, in, 3);
+  EXPECT_EQ(out[0], 11);
+  EXPECT_EQ(out[1], 22);
+  EXPECT_EQ(out[2], 33);
+}
+
+TEST(Optimization, CacheLine) {
+  EXPECT_GE(kCacheLineSize, size_t{64});
+  EXPECT_EQ(kCacheLineSize & (kCacheLineSize - 1), size_t{0});
+  EXPECT_EQ(alignof(Counters), kCacheLineSize);
+  EXPECT_EQ(sizeof(Counters), kCacheLineSize * 2);
+
+  Counters counters;
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(&counters.consumed) -
+                reinterpret_cast<uintptr_t>(&counters.produced),
+            kCacheLineSize);
+}
+
+}  // namespace rst
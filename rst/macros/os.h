@@ -48,6 +48,12 @@
 #define RST_BUILDFLAG_OS_WIN() (false)
 #endif
 
+#if defined(__linux__)
+#define RST_BUILDFLAG_OS_LINUX() (true)
+#else
+#define RST_BUILDFLAG_OS_LINUX() (false)
+#endif
+
 #if defined(__ANDROID__)
 #define RST_BUILDFLAG_OS_ANDROID() (true)
 #else
@@ -27,13 +27,15 @@
 
 #include "rst/random/random_device.h"
 
-#include "rst/no_destructor/no_destructor.h"
+#include "rst/lazy_instance/lazy_instance.h"
 
 namespace rst {
+namespace {
 
-std::random_device& GetRandomDevice() {
-  static NoDestructor<std::random_device> device;
-  return *device;
-}
+LazyInstance<std::random_device> g_device;
+
+}  // namespace
+
+std::random_device& GetRandomDevice() { return g_device.Get(); }
 
 }  // namespace rst
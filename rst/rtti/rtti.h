@@ -28,6 +28,11 @@
 #ifndef RST_RTTI_RTTI_H_
 #define RST_RTTI_RTTI_H_
 
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
 #include "rst/check/check.h"
 #include "rst/not_null/not_null.h"
 
@@ -55,8 +60,117 @@
 //     // File doesn't exist.
 //   }
 //
+// Any class hierarchy can support dyn_cast() by providing IsA<T>(). ClassIds
+// and ClassAncestry implement it in constant time regardless of the depth of
+// the hierarchy: every class stores the IDs of all its ancestors indexed by
+// depth, so checking for T is a bounds check and a single comparison at the
+// depth of T.
+//
+// Example:
+//
+//   class Shape {
+//    public:
+//     using RttiParent = void;
+//     static char id_;
+//
+//     virtual ~Shape();
+//     virtual ClassAncestry GetClassAncestry() const {
+//       return ClassIds<Shape>::GetAncestry();
+//     }
+//
+//     template <class T>
+//     bool IsA() const {
+//       return GetClassAncestry().Contains<T>();
+//     }
+//   };
+//
+//   class Circle : public Shape {
+//    public:
+//     using RttiParent = Shape;
+//     static char id_;
+//
+//     ClassAncestry GetClassAncestry() const override {
+//       return ClassIds<Circle>::GetAncestry();
+//     }
+//   };
+//
 namespace rst {
 
+template <class T>
+class ClassIds;
+
+// IDs of the classes from the root of a hierarchy to some class.
+class ClassAncestry {
+ public:
+  constexpr ClassAncestry(const void* const* ids, const size_t size)
+      : ids_(ids), size_(size) {}
+
+  // Returns true if T is the class or one of its ancestors.
+  template <class T>
+  constexpr bool Contains() const {
+    constexpr auto depth = ClassIds<T>::kDepth;
+    return depth < size_ && ids_[depth] == ClassIds<T>::GetClassID();
+  }
+
+  // Linear in the depth of the hierarchy, for class IDs known at runtime.
+  bool Contains(const NotNull<const void*> class_id) const {
+    for (size_t i = 0; i < size_; i++) {
+      if (ids_[i] == class_id.get())
+        return true;
+    }
+    return false;
+  }
+
+  size_t size() const { return size_; }
+
+ private:
+  const void* const* ids_;
+  size_t size_;
+};
+
+// Compile-time IDs of T and its ancestors. T is identified by the address of
+// its static id_ field and has a single parent T::RttiParent, which is void for
+// the root of the hierarchy.
+template <class T>
+class ClassIds {
+ private:
+  using Parent = typename T::RttiParent;
+
+  static constexpr size_t GetDepth() {
+    if constexpr (std::is_void<Parent>::value) {
+      return 0;
+    } else {
+      return ClassIds<Parent>::kDepth + 1;
+    }
+  }
+
+ public:
+  // The root of the hierarchy has depth 0.
+  static constexpr size_t kDepth = GetDepth();
+
+  static constexpr const void* GetClassID() { return &T::id_; }
+
+  static constexpr ClassAncestry GetAncestry() {
+    return ClassAncestry(kIds.data(), kIds.size());
+  }
+
+ private:
+  static constexpr std::array<const void*, kDepth + 1> MakeIds() {
+    std::array<const void*, kDepth + 1> ids = {};
+    if constexpr (!std::is_void<Parent>::value) {
+      for (size_t i = 0; i < kDepth; i++)
+        ids[i] = ClassIds<Parent>::kIds[i];
+    }
+    ids[kDepth] = GetClassID();
+    return ids;
+  }
+
+  template <class U>
+  friend class ClassIds;
+
+  static constexpr std::array<const void*, kDepth + 1> kIds = MakeIds();
+};
+
 template <class T, class U>
 Nullable<T*> dyn_cast(const NotNull<U*> ptr) {
   if (ptr->template IsA<T>())
@@ -81,6 +195,21 @@ Nullable<const T*> dyn_cast(const U* ptr) {
   return dyn_cast<T, U>(NotNull(ptr));
 }
 
+// Transfers the ownership to the result if the object is a T, otherwise
+// leaves |ptr| untouched and returns null.
+template <class T, class U>
+Nullable<std::unique_ptr<T>> dyn_cast(const NotNull<std::unique_ptr<U>*> ptr) {
+  RST_DCHECK(*ptr != nullptr);
+  if (!(*ptr)->template IsA<T>())
+    return nullptr;
+  return std::unique_ptr<T>(static_cast<T*>(ptr->release()));
+}
+
+template <class T, class U>
+Nullable<std::unique_ptr<T>> dyn_cast(std::unique_ptr<U>* ptr) {
+  return dyn_cast<T, U>(NotNull(ptr));
+}
+
 }  // namespace rst
 
 #endif  // RST_RTTI_RTTI_H_
@@ -27,6 +27,7 @@
 
 #include "rst/rtti/rtti.h"
 
+#include <memory>
 #include <utility>
 
 #include <gmock/gmock.h>
@@ -57,6 +58,61 @@ class ConstMock {
   MOCK_METHOD(bool, DoIsA, (), (const));
 };
 
+class Shape {
+ public:
+  using RttiParent = void;
+  static char id_;
+
+  virtual ~Shape() = default;
+
+  virtual ClassAncestry GetClassAncestry() const {
+    return ClassIds<Shape>::GetAncestry();
+  }
+
+  template <class T>
+  bool IsA() const {
+    return GetClassAncestry().Contains<T>();
+  }
+};
+
+char Shape::id_ = '\0';
+
+class Ellipse : public Shape {
+ public:
+  using RttiParent = Shape;
+  static char id_;
+
+  ClassAncestry GetClassAncestry() const override {
+    return ClassIds<Ellipse>::GetAncestry();
+  }
+};
+
+char Ellipse::id_ = '\0';
+
+class Circle : public Ellipse {
+ public:
+  using RttiParent = Ellipse;
+  static char id_;
+
+  ClassAncestry GetClassAncestry() const override {
+    return ClassIds<Circle>::GetAncestry();
+  }
+};
+
+char Circle::id_ = '\0';
+
+class Square : public Shape {
+ public:
+  using RttiParent = Shape;
+  static char id_;
+
+  ClassAncestry GetClassAncestry() const override {
+    return ClassIds<Square>::GetAncestry();
+  }
+};
+
+char Square::id_ = '\0';
+
 }  // namespace
 
 TEST(RTTI, Check) {
@@ -107,4 +163,48 @@ TEST(RTTI, ConstCheckRawPointer) {
   testing::Mock::VerifyAndClearExpectations(&mock);
 }
 
+TEST(RTTI, ClassIds) {
+  static_assert(ClassIds<Shape>::kDepth == 0);
+  static_assert(ClassIds<Ellipse>::kDepth == 1);
+  static_assert(ClassIds<Circle>::kDepth == 2);
+  static_assert(ClassIds<Square>::kDepth == 1);
+
+  static_assert(ClassIds<Circle>::GetAncestry().Contains<Shape>());
+  static_assert(ClassIds<Circle>::GetAncestry().Contains<Ellipse>());
+  static_assert(ClassIds<Circle>::GetAncestry().Contains<Circle>());
+  static_assert(!ClassIds<Circle>::GetAncestry().Contains<Square>());
+  static_assert(!ClassIds<Shape>::GetAncestry().Contains<Circle>());
+
+  EXPECT_TRUE(ClassIds<Circle>::GetAncestry().Contains(&Ellipse::id_));
+  EXPECT_FALSE(ClassIds<Circle>::GetAncestry().Contains(&Square::id_));
+}
+
+TEST(RTTI, Hierarchy) {
+  Circle circle;
+  Shape* shape = &circle;
+
+  EXPECT_EQ(dyn_cast<Shape>(shape), shape);
+  EXPECT_EQ(dyn_cast<Ellipse>(shape), &circle);
+  EXPECT_EQ(dyn_cast<Circle>(shape), &circle);
+  EXPECT_EQ(dyn_cast<Square>(shape), nullptr);
+
+  const Shape* const_shape = &circle;
+  EXPECT_EQ(dyn_cast<Circle>(const_shape), &circle);
+  EXPECT_EQ(dyn_cast<Square>(const_shape), nullptr);
+}
+
+TEST(RTTI, UniquePtr) {
+  std::unique_ptr<Shape> shape = std::make_unique<Circle>();
+  const auto raw = shape.get();
+
+  auto square = dyn_cast<Square>(&shape);
+  EXPECT_EQ(square, nullptr);
+  EXPECT_EQ(shape.get(), raw);
+
+  auto circle = dyn_cast<Circle>(NotNull(&shape));
+  ASSERT_NE(circle, nullptr);
+  EXPECT_EQ(circle.get(), raw);
+  EXPECT_EQ(shape, nullptr);
+}
+
 }  // namespace rst
@@ -37,8 +37,12 @@ ErrorInfoBase::~ErrorInfoBase() = default;
 // static
 NotNull<const void*> ErrorInfoBase::GetClassID() { return &id_; }
 
+ClassAncestry ErrorInfoBase::GetClassAncestry() const {
+  return ClassIds<ErrorInfoBase>::GetAncestry();
+}
+
 bool ErrorInfoBase::IsA(const NotNull<const void*> class_id) const {
-  return class_id == GetClassID();
+  return GetClassAncestry().Contains(class_id);
 }
 
 }  // namespace rst
@@ -35,7 +35,7 @@
 #include "rst/check/check.h"
 #include "rst/macros/macros.h"
 #include "rst/not_null/not_null.h"
-#include "rst/status/status.h"
+#include "rst/rtti/rtti.h"
 
 namespace rst {
 
@@ -68,8 +68,12 @@ namespace rst {
 //     static char id_;
 //   };
 //
+// IsA<T>() and dyn_cast() take constant time regardless of the depth of the
+// hierarchy.
 class ErrorInfoBase {
  public:
+  using RttiParent = void;
+
   ErrorInfoBase();
   virtual ~ErrorInfoBase();
 
@@ -78,14 +82,20 @@ class ErrorInfoBase {
   virtual const std::string& AsString() const = 0;
   virtual NotNull<const void*> GetDynamicClassID() const = 0;
 
-  virtual bool IsA(NotNull<const void*> class_id) const;
+  // IDs of the class and all of its ancestors.
+  virtual ClassAncestry GetClassAncestry() const;
+
+  bool IsA(NotNull<const void*> class_id) const;
 
   template <class ErrorInfoT>
   bool IsA() const {
-    return IsA(ErrorInfoT::GetClassID());
+    return GetClassAncestry().Contains<ErrorInfoT>();
   }
 
  private:
+  template <class T>
+  friend class ClassIds;
+
   static char id_;
 
   RST_DISALLOW_COPY_AND_ASSIGN(ErrorInfoBase);
@@ -94,6 +104,8 @@ class ErrorInfoBase {
 template <class T, class Parent = ErrorInfoBase>
 class ErrorInfo : public Parent {
  public:
+  using RttiParent = Parent;
+
   using Parent::Parent;
   ~ErrorInfo() override = default;
 
@@ -102,14 +114,20 @@ class ErrorInfo : public Parent {
   // Parent:
   NotNull<const void*> GetDynamicClassID() const override { return &T::id_; }
 
-  bool IsA(const NotNull<const void*> class_id) const override {
-    return class_id == GetClassID() || Parent::IsA(class_id);
+  ClassAncestry GetClassAncestry() const override {
+    return ClassIds<T>::GetAncestry();
   }
 
  private:
   RST_DISALLOW_COPY_AND_ASSIGN(ErrorInfo);
 };
 
+template <class F>
+class ScopeSuccess;
+
+template <class F>
+class ScopeFailure;
+
 // A Google-like Status class for recoverable error handling. It's impossible to
 // ignore an error.
 //
@@ -196,6 +214,12 @@ class [[nodiscard]] Status {
   template <class Err, class... Args>
   friend Status MakeStatus(Args && ... args);
 
+  template <class F>
+  friend class ScopeSuccess;
+
+  template <class F>
+  friend class ScopeFailure;
+
   // Sets the object as not checked by default and to be OK.
   Status() = default;
 
@@ -183,4 +183,22 @@ TEST(Status, Errors) {
   }
 }
 
+TEST(Status, IsA) {
+  const Error3 error;
+  EXPECT_TRUE(error.IsA<ErrorInfoBase>());
+  EXPECT_TRUE(error.IsA<Error2>());
+  EXPECT_TRUE(error.IsA<Error3>());
+  EXPECT_FALSE(error.IsA<Error>());
+
+  EXPECT_TRUE(error.IsA(ErrorInfoBase::GetClassID()));
+  EXPECT_TRUE(error.IsA(Error2::GetClassID()));
+  EXPECT_TRUE(error.IsA(Error3::GetClassID()));
+  EXPECT_FALSE(error.IsA(Error::GetClassID()));
+
+  static_assert(ClassIds<ErrorInfoBase>::kDepth == 0);
+  static_assert(ClassIds<Error2>::kDepth == 1);
+  static_assert(ClassIds<Error3>::kDepth == 2);
+  EXPECT_EQ(error.GetClassAncestry().size(), 3u);
+}
+
 }  // namespace rst
@@ -27,6 +27,9 @@
 
 #include "rst/strings/arg.h"
 
+#include "rst/macros/header_only.h"
+
+#if !RST_BUILDFLAG(HEADER_ONLY)
 namespace rst {
 namespace internal {
 
@@ -51,3 +54,4 @@ template std::string_view IntToString(
 
 }  // namespace internal
 }  // namespace rst
+#endif  // !RST_BUILDFLAG(HEADER_ONLY)
@@ -35,6 +35,7 @@
 #include <type_traits>
 
 #include "rst/check/check.h"
+#include "rst/macros/header_only.h"
 #include "rst/macros/macros.h"
 #include "rst/not_null/not_null.h"
 
@@ -154,6 +155,7 @@ class Arg {
   RST_DISALLOW_COPY_AND_ASSIGN(Arg);
 };
 
+#if !RST_BUILDFLAG(HEADER_ONLY)
 extern template std::string_view IntToString(char (&str)[Arg::kBufferSize],
                                              short val);  // NOLINT(runtime/int)
 extern template std::string_view IntToString(
@@ -174,6 +176,7 @@ extern template std::string_view IntToString(
 extern template std::string_view IntToString(
     char (&str)[Arg::kBufferSize],
     unsigned long long val);  // NOLINT(runtime/int)
+#endif  // !RST_BUILDFLAG(HEADER_ONLY)
 
 }  // namespace internal
 }  // namespace rst
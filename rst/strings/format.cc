@@ -27,69 +27,8 @@
 
 #include "rst/strings/format.h"
 
-#include <algorithm>
-#include <cstring>
+#include "rst/macros/header_only.h"
 
-#include "rst/check/check.h"
-#include "rst/macros/optimization.h"
-#include "rst/stl/resize_uninitialized.h"
-
-namespace rst {
-namespace internal {
-
-std::string FormatAndReturnString(const NotNull<const char*> not_null_format,
-                                  const size_t format_size,
-                                  const Nullable<const Arg*> values,
-                                  const size_t size) {
-  auto format = not_null_format.get();
-
-  RST_DCHECK(format_size == std::strlen(format));
-  auto new_size = format_size;
-  for (size_t i = 0; i < size; i++) {
-    RST_DCHECK(values != nullptr);
-    new_size += values[i].size();
-  }
-  RST_DCHECK(new_size >= size * 2);
-  new_size -= size * 2;
-
-  std::string output;
-  StringResizeUninitialized(&output, new_size);
-
-  size_t arg_idx = 0;
-  auto target = output.data();
-  for (auto c = '\0'; (c = *format) != '\0'; format++) {
-    switch (RST_LIKELY_EQ(c, ' ')) {
-      case '{': {
-        if (RST_LIKELY(*(format + 1) == '}')) {
-          RST_DCHECK(arg_idx < size && "Extra arguments");
-          const auto src = values[arg_idx++].view();
-          target = std::copy_n(src.data(), src.size(), target);
-        } else {
-          RST_DCHECK((*(format + 1) == '{') && "Invalid format string");
-          *target++ = '{';
-        }
-
-        format++;
-        break;
-      }
-      case '}': {
-        RST_DCHECK((*(format + 1) == '}') && "Unmatched '}' in format string");
-        format++;
-        *target++ = '}';
-        break;
-      }
-      default: {
-        *target++ = c;
-        break;
-      }
-    }
-  }
-
-  RST_DCHECK(arg_idx == size && "Numbers of parameters should match");
-
-  output.resize(static_cast<size_t>(target - output.data()));
-  return output;
-}
-
-}  // namespace internal
-}  // namespace rst
+#if !RST_BUILDFLAG(HEADER_ONLY)
+#include "rst/strings/format-inl.h"
+#endif  // !RST_BUILDFLAG(HEADER_ONLY)
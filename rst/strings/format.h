@@ -32,6 +32,7 @@
 #include <initializer_list>
 #include <string>
 
+#include "rst/macros/header_only.h"
 #include "rst/not_null/not_null.h"
 #include "rst/strings/arg.h"
 
@@ -69,9 +70,9 @@
 namespace rst {
 namespace internal {
 
-std::string FormatAndReturnString(NotNull<const char*> format,
-                                  size_t format_size,
-                                  Nullable<const Arg*> values, size_t size);
+RST_HEADER_ONLY_INLINE std::string FormatAndReturnString(
+    NotNull<const char*> format, size_t format_size,
+    Nullable<const Arg*> values, size_t size);
 }  // namespace internal
 
 template <size_t N>
@@ -88,4 +89,8 @@ inline std::string Format(const char (&format)[N],
 
 }  // namespace rst
 
+#if RST_BUILDFLAG(HEADER_ONLY)
+#include "rst/strings/format-inl.h"
+#endif  // RST_BUILDFLAG(HEADER_ONLY)
+
 #endif  // RST_STRINGS_FORMAT_H_
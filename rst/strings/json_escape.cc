@@ -0,0 +1,141 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/strings/json_escape.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#include "rst/bits/bits.h"
+#include "rst/macros/arch.h"
+#include "rst/macros/macros.h"
+#include "rst/macros/optimization.h"
+
+// SSE2 is a part of x86-64, 32-bit x86 builds may target older CPUs.
+#if RST_BUILDFLAG(ARCH_CPU_X86_64) || defined(__SSE2__) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RST_BUILDFLAG_SSE2() (true)
+#else
+#define RST_BUILDFLAG_SSE2() (false)
+#endif
+
+#if RST_BUILDFLAG(SSE2)
+#include <emmintrin.h>
+#endif
+
+namespace rst {
+namespace {
+
+constexpr bool NeedsEscaping(const char c) {
+  return c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20;
+}
+
+void AppendEscapedChar(const char c, const NotNull<std::string*> out) {
+  switch (c) {
+    case '"':
+      out->append("\\\"");
+      return;
+    case '\\':
+      out->append("\\\\");
+      return;
+    case '\b':
+      out->append("\\b");
+      return;
+    case '\f':
+      out->append("\\f");
+      return;
+    case '\n':
+      out->append("\\n");
+      return;
+    case '\r':
+      out->append("\\r");
+      return;
+    case '\t':
+      out->append("\\t");
+      return;
+    default:
+      break;
+  }
+
+  constexpr char kHexDigits[] = "0123456789abcdef";
+  const auto byte = static_cast<unsigned char>(c);
+  const char escaped[] = {'\\', 'u', '0', '0', kHexDigits[byte >> 4],
+                          kHexDigits[byte & 0xf]};
+  out->append(escaped, sizeof(escaped));
+}
+
+// Returns the offset of the first character needing escaping in |str| or
+// |size| if there are none.
+size_t FindSpecialChar(const char* str, const size_t size) {
+  size_t i = 0;
+#if RST_BUILDFLAG(SSE2)
+  const auto quote = _mm_set1_epi8('"');
+  const auto backslash = _mm_set1_epi8('\\');
+  const auto max_control = _mm_set1_epi8(0x1f);
+  for (; i + 16 <= size; i += 16) {
+    const auto chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + i));
+    // Unsigned c <= 0x1f is max(c, 0x1f) == 0x1f.
+    const auto special = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                     _mm_cmpeq_epi8(chunk, backslash)),
+        _mm_cmpeq_epi8(_mm_max_epu8(chunk, max_control), max_control));
+    const auto mask = static_cast<uint32_t>(_mm_movemask_epi8(special));
+    if (mask != 0)
+      return i + static_cast<size_t>(CountTrailingZeros(mask));
+  }
+#endif  // RST_BUILDFLAG(SSE2)
+
+  for (; i < size; i++) {
+    if (NeedsEscaping(str[i]))
+      return i;
+  }
+
+  return size;
+}
+
+}  // namespace
+
+void AppendJsonEscaped(const std::string_view str,
+                       const NotNull<std::string*> out) {
+  out->reserve(out->size() + str.size());
+
+  auto data = str.data();
+  auto size = str.size();
+  while (size != 0) {
+    const auto clean = FindSpecialChar(data, size);
+    out->append(data, clean);
+    if (clean == size)
+      return;
+
+    AppendEscapedChar(data[clean], out);
+    data += clean + 1;
+    size -= clean + 1;
+  }
+}
+
+}  // namespace rst
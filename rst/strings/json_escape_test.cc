@@ -0,0 +1,97 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/strings/json_escape.h"
+
+#include <string>
+#include <string_view>
+
+#include <gtest/gtest.h>
+
+namespace rst {
+namespace {
+
+std::string Escape(const std::string_view str) {
+  std::string out;
+  AppendJsonEscaped(str, &out);
+  return out;
+}
+
+}  // namespace
+
+TEST(JsonEscape, NoEscaping) {
+  EXPECT_EQ(Escape(""), "");
+  EXPECT_EQ(Escape("abc"), "abc");
+  EXPECT_EQ(Escape("a long string without special characters"),
+            "a long string without special characters");
+  EXPECT_EQ(Escape("\xd0\xbf\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82 \x7f"),
+            "\xd0\xbf\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82 \x7f");
+}
+
+TEST(JsonEscape, Escaping) {
+  EXPECT_EQ(Escape("\""), "\\\"");
+  EXPECT_EQ(Escape("\\"), "\\\\");
+  EXPECT_EQ(Escape("\b\f\n\r\t"), "\\b\\f\\n\\r\\t");
+  EXPECT_EQ(Escape(std::string_view("\0\x01\x1f", 3)), "\\u0000\\u0001\\u001f");
+  EXPECT_EQ(Escape("say \"hi\"\n"), "say \\\"hi\\\"\\n");
+}
+
+TEST(JsonEscape, AllPositions) {
+  // Special characters at every offset of and across 16 bytes blocks.
+  for (size_t size = 1; size < 70; size++) {
+    for (size_t pos = 0; pos < size; pos++) {
+      std::string str(size, 'x');
+      str[pos] = '"';
+      std::string expected(pos, 'x');
+      expected += "\\\"";
+      expected.append(size - pos - 1, 'x');
+      ASSERT_EQ(Escape(str), expected);
+    }
+  }
+}
+
+TEST(JsonEscape, AllBytes) {
+  for (auto i = 0; i < 256; i++) {
+    const auto c = static_cast<char>(i);
+    std::string str(40, 'y');
+    str[20] = c;
+    const auto escaped = Escape(str);
+    if (c == '"' || c == '\\' || i < 0x20)
+      EXPECT_NE(escaped, str);
+    else
+      EXPECT_EQ(escaped, str);
+  }
+}
+
+TEST(JsonEscape, Appends) {
+  std::string out = "\"";
+  AppendJsonEscaped("a\"b", &out);
+  out += '"';
+  EXPECT_EQ(out, "\"a\\\"b\"");
+}
+
+}  // namespace rst
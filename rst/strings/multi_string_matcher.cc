@@ -0,0 +1,375 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/strings/multi_string_matcher.h"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <numeric>
+
+#include "rst/bits/bits.h"
+#include "rst/check/check.h"
+#include "rst/cpu/cpu.h"
+#include "rst/cpu/dispatch.h"
+#include "rst/macros/arch.h"
+#include "rst/macros/optimization.h"
+
+// Teddy needs PSHUFB, the SSSE3 byte shuffle, enabled per function.
+#if RST_BUILDFLAG(ARCH_CPU_X86_FAMILY) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define RST_BUILDFLAG_TEDDY() (true)
+#else
+#define RST_BUILDFLAG_TEDDY() (false)
+#endif
+
+#if RST_BUILDFLAG(TEDDY)
+#include <tmmintrin.h>
+#endif
+
+namespace rst {
+namespace {
+
+constexpr uint32_t kNoState = std::numeric_limits<uint32_t>::max();
+
+constexpr size_t kTeddyBucketCount = 8;
+constexpr size_t kMaxTeddyFingerprintSize = 3;
+
+#if RST_BUILDFLAG(TEDDY)
+// Above that the buckets get crowded and candidates need too many
+// comparisons.
+constexpr size_t kMaxTeddyPatterns = 32;
+
+// Looks for positions in 16-byte chunks starting at |pos| where the first
+// |FingerprintSize| bytes of a pattern may start. Returns the offset of the
+// first chunk with candidates and sets bits of |candidates| for them and
+// |buckets| to the possible buckets at each position. Returns an offset
+// after which less than a chunk with the fingerprint fits if there are no
+// more candidates.
+template <size_t FingerprintSize>
+RST_ATTRIBUTE_TARGET("ssse3")
+size_t FindTeddyChunk(const uint8_t (*low)[16], const uint8_t (*high)[16],
+                      const char* text, const size_t size, size_t pos,
+                      const NotNull<uint32_t*> candidates,
+                      uint8_t (&buckets)[16]) {
+  const auto nibble_mask = _mm_set1_epi8(0x0f);
+  __m128i low_masks[FingerprintSize];
+  __m128i high_masks[FingerprintSize];
+  for (size_t i = 0; i < FingerprintSize; i++) {
+    low_masks[i] = _mm_load_si128(reinterpret_cast<const __m128i*>(low[i]));
+    high_masks[i] = _mm_load_si128(reinterpret_cast<const __m128i*>(high[i]));
+  }
+
+  for (; pos + 16 + FingerprintSize - 1 <= size; pos += 16) {
+    auto result = _mm_set1_epi8(-1);
+    for (size_t i = 0; i < FingerprintSize; i++) {
+      const auto chunk =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + pos + i));
+      const auto low_nibbles = _mm_and_si128(chunk, nibble_mask);
+      const auto high_nibbles =
+          _mm_and_si128(_mm_srli_epi16(chunk, 4), nibble_mask);
+      result = _mm_and_si128(
+          result, _mm_and_si128(_mm_shuffle_epi8(low_masks[i], low_nibbles),
+                                _mm_shuffle_epi8(high_masks[i], high_nibbles)));
+    }
+
+    const auto empty = static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(result, _mm_setzero_si128())));
+    if (RST_UNLIKELY(empty != 0xffff)) {
+      *candidates = ~empty & 0xffff;
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(buckets), result);
+      return pos;
+    }
+  }
+
+  *candidates = 0;
+  return pos;
+}
+#endif  // RST_BUILDFLAG(TEDDY)
+
+}  // namespace
+
+MultiStringMatcher::MultiStringMatcher(
+    const std::vector<std::string_view>& patterns)
+    : patterns_(patterns.begin(), patterns.end()) {
+  RST_DCHECK(!patterns_.empty());
+  RST_DCHECK(patterns_.size() < kNoState);
+  for (const auto& pattern : patterns_)
+    RST_DCHECK(!pattern.empty());
+
+#if RST_BUILDFLAG(TEDDY)
+  use_teddy_ = patterns_.size() <= kMaxTeddyPatterns &&
+               GetCpuLevel() >= CpuLevel::kSse42;
+#endif  // RST_BUILDFLAG(TEDDY)
+
+  if (use_teddy_) {
+    BuildTeddy();
+  } else {
+    BuildAhoCorasick();
+  }
+}
+
+MultiStringMatcher::~MultiStringMatcher() = default;
+
+void MultiStringMatcher::FindAll(
+    const std::string_view text,
+    const NotNull<std::vector<Match>*> matches) const {
+  const auto on_match = [matches](const size_t pattern, const size_t offset) {
+    matches->push_back({pattern, offset});
+    return true;
+  };
+
+  if (use_teddy_) {
+    ScanTeddy(text, on_match);
+  } else {
+    ScanAhoCorasick(text, on_match);
+  }
+}
+
+bool MultiStringMatcher::Contains(const std::string_view text) const {
+  const auto on_match = [](size_t, size_t) { return false; };
+  if (use_teddy_)
+    return !ScanTeddy(text, on_match);
+  return !ScanAhoCorasick(text, on_match);
+}
+
+template <class F>
+bool MultiStringMatcher::ScanAhoCorasick(const std::string_view text,
+                                         F on_match) const {
+  const auto* transitions = transitions_.data();
+  uint32_t state = 0;
+  for (size_t i = 0; i < text.size(); i++) {
+    const auto byte = static_cast<uint8_t>(text[i]);
+    state = transitions[state + byte_classes_[byte]];
+    if (RST_LIKELY(state < first_match_state_))
+      continue;
+
+    const auto match_index = (state - first_match_state_) / byte_class_count_;
+    for (auto j = match_offsets_[match_index];
+         j < match_offsets_[match_index + 1]; j++) {
+      const auto pattern = match_patterns_[j];
+      if (!on_match(pattern, i + 1 - patterns_[pattern].size()))
+        return false;
+    }
+  }
+
+  return true;
+}
+
+template <class F>
+bool MultiStringMatcher::ScanTeddy(const std::string_view text,
+                                   F on_match) const {
+  const auto* data = text.data();
+  const auto size = text.size();
+
+  // Compares the patterns of |bucket_bits| with the text at |pos|.
+  const auto verify = [this, data, size, &on_match](const size_t pos,
+                                                    uint32_t bucket_bits) {
+    while (bucket_bits != 0) {
+      const auto bucket = CountTrailingZeros(bucket_bits);
+      bucket_bits &= bucket_bits - 1;
+      for (const auto pattern : teddy_buckets_[bucket]) {
+        const auto& str = patterns_[pattern];
+        if (size - pos >= str.size() &&
+            std::memcmp(data + pos, str.data(), str.size()) == 0 &&
+            !on_match(static_cast<size_t>(pattern), pos)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  };
+
+  size_t pos = 0;
+#if RST_BUILDFLAG(TEDDY)
+  for (;;) {
+    uint32_t candidates = 0;
+    alignas(16) uint8_t buckets[16];
+    switch (teddy_fingerprint_size_) {
+      case 1:
+        pos = FindTeddyChunk<1>(teddy_low_, teddy_high_, data, size, pos,
+                                &candidates, buckets);
+        break;
+      case 2:
+        pos = FindTeddyChunk<2>(teddy_low_, teddy_high_, data, size, pos,
+                                &candidates, buckets);
+        break;
+      default:
+        pos = FindTeddyChunk<3>(teddy_low_, teddy_high_, data, size, pos,
+                                &candidates, buckets);
+        break;
+    }
+    if (candidates == 0)
+      break;
+
+    while (candidates != 0) {
+      const auto index = CountTrailingZeros(candidates);
+      candidates &= candidates - 1;
+      if (!verify(pos + static_cast<size_t>(index), buckets[index]))
+        return false;
+    }
+    pos += 16;
+  }
+#endif  // RST_BUILDFLAG(TEDDY)
+
+  // The tail that is shorter than a chunk.
+  for (; pos + teddy_fingerprint_size_ <= size; pos++) {
+    uint32_t bucket_bits = 0xff;
+    for (size_t i = 0; i < teddy_fingerprint_size_; i++) {
+      const auto byte = static_cast<uint8_t>(data[pos + i]);
+      bucket_bits &= teddy_low_[i][byte & 0xf] & teddy_high_[i][byte >> 4];
+    }
+    if (bucket_bits != 0 && !verify(pos, bucket_bits))
+      return false;
+  }
+
+  return true;
+}
+
+void MultiStringMatcher::BuildAhoCorasick() {
+  // Bytes not occurring in the patterns share class 0.
+  for (const auto& pattern : patterns_) {
+    for (const auto c : pattern)
+      byte_classes_[static_cast<uint8_t>(c)] = 1;
+  }
+  byte_class_count_ = 1;
+  for (auto& byte_class : byte_classes_) {
+    if (byte_class != 0)
+      byte_class = static_cast<uint8_t>(byte_class_count_++);
+  }
+  const auto stride = byte_class_count_;
+
+  // The trie with unnumbered state ids, the root is 0.
+  std::vector<uint32_t> trie(stride, kNoState);
+  std::vector<std::vector<uint32_t>> outputs(1);
+  for (size_t i = 0; i < patterns_.size(); i++) {
+    uint32_t state = 0;
+    for (const auto c : patterns_[i]) {
+      const auto byte_class = byte_classes_[static_cast<uint8_t>(c)];
+      auto& next = trie[state * stride + byte_class];
+      if (next == kNoState) {
+        next = static_cast<uint32_t>(outputs.size());
+        trie.resize(trie.size() + stride, kNoState);
+        outputs.emplace_back();
+      }
+      state = trie[state * stride + byte_class];
+    }
+    outputs[state].push_back(static_cast<uint32_t>(i));
+  }
+  const auto state_count = outputs.size();
+
+  // Breadth-first, turn the trie into a DFA following failure links: a
+  // missing transition is the transition of the longest proper suffix that is
+  // in the trie. Outputs of the suffix are inherited.
+  std::vector<uint32_t> failure(state_count, 0);
+  std::deque<uint32_t> queue;
+  for (size_t byte_class = 0; byte_class < stride; byte_class++) {
+    auto& next = trie[byte_class];
+    if (next == kNoState) {
+      next = 0;
+    } else {
+      queue.push_back(next);
+    }
+  }
+  while (!queue.empty()) {
+    const auto state = queue.front();
+    queue.pop_front();
+    const auto fail = failure[state];
+    outputs[state].insert(outputs[state].end(), outputs[fail].begin(),
+                          outputs[fail].end());
+    for (size_t byte_class = 0; byte_class < stride; byte_class++) {
+      auto& next = trie[state * stride + byte_class];
+      const auto fail_next = trie[fail * stride + byte_class];
+      if (next == kNoState) {
+        next = fail_next;
+      } else {
+        failure[next] = fail_next;
+        queue.push_back(next);
+      }
+    }
+  }
+
+  // States without outputs go first, keeping the root 0.
+  std::vector<uint32_t> order(state_count);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_partition(order.begin(), order.end(),
+                        [&outputs](const uint32_t state) {
+                          return outputs[state].empty();
+                        });
+  std::vector<uint32_t> new_ids(state_count);
+  for (size_t i = 0; i < state_count; i++)
+    new_ids[order[i]] = static_cast<uint32_t>(i * stride);
+
+  RST_CHECK(state_count * stride < kNoState);
+  transitions_.resize(state_count * stride);
+  match_offsets_.push_back(0);
+  for (size_t i = 0; i < state_count; i++) {
+    const auto state = order[i];
+    for (size_t byte_class = 0; byte_class < stride; byte_class++) {
+      transitions_[i * stride + byte_class] =
+          new_ids[trie[state * stride + byte_class]];
+    }
+
+    if (outputs[state].empty()) {
+      first_match_state_ = static_cast<uint32_t>((i + 1) * stride);
+      continue;
+    }
+    match_patterns_.insert(match_patterns_.end(), outputs[state].begin(),
+                           outputs[state].end());
+    match_offsets_.push_back(static_cast<uint32_t>(match_patterns_.size()));
+  }
+}
+
+void MultiStringMatcher::BuildTeddy() {
+  auto min_size = patterns_.front().size();
+  for (const auto& pattern : patterns_)
+    min_size = std::min(min_size, pattern.size());
+  teddy_fingerprint_size_ = std::min(min_size, kMaxTeddyFingerprintSize);
+
+  // Patterns with the same fingerprint share a bucket not to make extra
+  // candidates.
+  std::vector<uint32_t> order(patterns_.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [this](uint32_t lhs, uint32_t rhs) {
+    return patterns_[lhs].compare(0, teddy_fingerprint_size_, patterns_[rhs],
+                                  0, teddy_fingerprint_size_) < 0;
+  });
+
+  for (size_t i = 0; i < order.size(); i++) {
+    const auto bucket = i * kTeddyBucketCount / order.size();
+    const auto& pattern = patterns_[order[i]];
+    teddy_buckets_[bucket].push_back(order[i]);
+    for (size_t j = 0; j < teddy_fingerprint_size_; j++) {
+      const auto byte = static_cast<uint8_t>(pattern[j]);
+      teddy_low_[j][byte & 0xf] |= static_cast<uint8_t>(1 << bucket);
+      teddy_high_[j][byte >> 4] |= static_cast<uint8_t>(1 << bucket);
+    }
+  }
+}
+
+}  // namespace rst
@@ -0,0 +1,126 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef RST_STRINGS_MULTI_STRING_MATCHER_H_
+#define RST_STRINGS_MULTI_STRING_MATCHER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "rst/macros/macros.h"
+#include "rst/not_null/not_null.h"
+
+namespace rst {
+
+// Finds all occurrences of a fixed set of non-empty patterns in a text in one
+// pass, independently of the number of patterns.
+//
+// Up to 32 patterns on CPUs with SSSE3 are searched with Teddy: 16 text
+// positions at a time are checked against nibble masks of the first bytes of
+// the patterns, and only candidate positions are compared with the patterns.
+// Larger sets use an Aho-Corasick automaton compiled into a DFA over byte
+// classes, which makes one table lookup per text byte.
+//
+// Example:
+//
+//   MultiStringMatcher matcher({"error", "timeout", "refused"});
+//
+//   std::vector<MultiStringMatcher::Match> matches;
+//   matcher.FindAll("connection refused: timeout", &matches);
+//   // {{2, 11}, {1, 20}}: "refused" at 11 and "timeout" at 20.
+//
+//   if (matcher.Contains(line))
+//     ...
+//
+class MultiStringMatcher {
+ public:
+  struct Match {
+    // Index of the pattern in the constructor argument.
+    size_t pattern = 0;
+    // Offset of the occurrence in the text.
+    size_t offset = 0;
+
+    bool operator==(const Match& other) const {
+      return pattern == other.pattern && offset == other.offset;
+    }
+    bool operator!=(const Match& other) const { return !(*this == other); }
+  };
+
+  explicit MultiStringMatcher(const std::vector<std::string_view>& patterns);
+  ~MultiStringMatcher();
+
+  // Appends all occurrences, including overlapping ones, to |matches|. The
+  // order of the matches is unspecified.
+  void FindAll(std::string_view text,
+               NotNull<std::vector<Match>*> matches) const;
+
+  // Returns whether any pattern occurs in |text|, stops at the first match.
+  bool Contains(std::string_view text) const;
+
+ private:
+  // Calls |on_match(pattern, offset)| for the occurrences until it returns
+  // false. Returns false if stopped.
+  template <class F>
+  bool ScanAhoCorasick(std::string_view text, F on_match) const;
+  template <class F>
+  bool ScanTeddy(std::string_view text, F on_match) const;
+
+  void BuildAhoCorasick();
+  void BuildTeddy();
+
+  std::vector<std::string> patterns_;
+
+  // Aho-Corasick DFA. States are numbered so that the states with matches go
+  // last, and are stored premultiplied by the number of byte classes, so that
+  // a transition is transitions_[state + byte_classes_[byte]].
+  uint8_t byte_classes_[256] = {};
+  size_t byte_class_count_ = 0;
+  std::vector<uint32_t> transitions_;
+  uint32_t first_match_state_ = 0;
+  // Patterns matching at the state first_match_state_ + i * byte_class_count_
+  // are match_patterns_[match_offsets_[i]..match_offsets_[i + 1]).
+  std::vector<uint32_t> match_offsets_;
+  std::vector<uint32_t> match_patterns_;
+
+  // Teddy masks. A pattern in bucket b has bit b set in
+  // teddy_low_[i][byte & 0xf] and teddy_high_[i][byte >> 4] for its byte at
+  // index i < teddy_fingerprint_size_.
+  bool use_teddy_ = false;
+  size_t teddy_fingerprint_size_ = 0;
+  alignas(16) uint8_t teddy_low_[3][16] = {};
+  alignas(16) uint8_t teddy_high_[3][16] = {};
+  std::vector<uint32_t> teddy_buckets_[8];
+
+  RST_DISALLOW_COPY_AND_ASSIGN(MultiStringMatcher);
+};
+
+}  // namespace rst
+
+#endif  // RST_STRINGS_MULTI_STRING_MATCHER_H_
@@ -0,0 +1,144 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/strings/multi_string_matcher.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "rst/cpu/cpu.h"
+
+namespace rst {
+namespace {
+
+using Match = MultiStringMatcher::Match;
+
+std::vector<Match> FindAll(const MultiStringMatcher& matcher,
+                           const std::string_view text) {
+  std::vector<Match> matches;
+  matcher.FindAll(text, &matches);
+  std::sort(matches.begin(), matches.end(),
+            [](const Match& lhs, const Match& rhs) {
+              return std::tie(lhs.offset, lhs.pattern) <
+                     std::tie(rhs.offset, rhs.pattern);
+            });
+  return matches;
+}
+
+std::vector<Match> FindAllNaive(const std::vector<std::string_view>& patterns,
+                                const std::string_view text) {
+  std::vector<Match> matches;
+  for (size_t offset = 0; offset < text.size(); offset++) {
+    for (size_t pattern = 0; pattern < patterns.size(); pattern++) {
+      if (text.substr(offset, patterns[pattern].size()) == patterns[pattern])
+        matches.push_back({pattern, offset});
+    }
+  }
+  return matches;
+}
+
+// Runs the test body with Teddy on CPUs that support it and with
+// Aho-Corasick.
+class MultiStringMatcherTest : public testing::TestWithParam<CpuLevel> {
+ protected:
+  MultiStringMatcherTest() { SetCpuLevelLimit(GetParam()); }
+  ~MultiStringMatcherTest() override { SetCpuLevelLimit(CpuLevel::kAvx512); }
+};
+
+}  // namespace
+
+TEST_P(MultiStringMatcherTest, FindAll) {
+  const MultiStringMatcher matcher({"error", "timeout", "refused"});
+  EXPECT_EQ(FindAll(matcher, "connection refused: timeout"),
+            (std::vector<Match>{{2, 11}, {1, 20}}));
+  EXPECT_TRUE(FindAll(matcher, "").empty());
+  EXPECT_TRUE(FindAll(matcher, "erro").empty());
+  EXPECT_EQ(FindAll(matcher, "error"), (std::vector<Match>{{0, 0}}));
+}
+
+TEST_P(MultiStringMatcherTest, Overlapping) {
+  const MultiStringMatcher matcher({"he", "she", "his", "hers"});
+  EXPECT_EQ(FindAll(matcher, "ushers"),
+            (std::vector<Match>{{1, 1}, {0, 2}, {3, 2}}));
+  EXPECT_EQ(FindAll(matcher, "hishe"),
+            (std::vector<Match>{{2, 0}, {1, 2}, {0, 3}}));
+}
+
+TEST_P(MultiStringMatcherTest, Duplicates) {
+  const MultiStringMatcher matcher({"aa", "aa", "a"});
+  EXPECT_EQ(FindAll(matcher, "aaa"),
+            (std::vector<Match>{
+                {0, 0}, {1, 0}, {2, 0}, {0, 1}, {1, 1}, {2, 1}, {2, 2}}));
+}
+
+TEST_P(MultiStringMatcherTest, Contains) {
+  const MultiStringMatcher matcher(
+      {"GET /admin", "DROP TABLE", std::string_view("\x00\xff", 2)});
+  EXPECT_TRUE(matcher.Contains("10.0.0.1 GET /admin HTTP/1.1"));
+  EXPECT_TRUE(matcher.Contains("'; DROP TABLE users; --"));
+  EXPECT_TRUE(matcher.Contains(std::string_view("\x01\x00\xff", 3)));
+  EXPECT_FALSE(matcher.Contains("10.0.0.1 GET /index.html HTTP/1.1"));
+  EXPECT_FALSE(matcher.Contains(""));
+}
+
+TEST_P(MultiStringMatcherTest, MatchesNaive) {
+  std::mt19937 random(42);
+  for (const size_t pattern_count : {1, 2, 7, 8, 9, 32, 33, 200}) {
+    // A small alphabet makes many overlapping matches.
+    std::vector<std::string> storage;
+    for (size_t i = 0; i < pattern_count; i++) {
+      std::string pattern(1 + random() % 6, '\0');
+      for (auto& c : pattern)
+        c = static_cast<char>('a' + random() % 4);
+      storage.push_back(std::move(pattern));
+    }
+    const std::vector<std::string_view> patterns(storage.begin(),
+                                                 storage.end());
+    const MultiStringMatcher matcher(patterns);
+
+    for (auto i = 0; i < 20; i++) {
+      std::string text(random() % 100, '\0');
+      for (auto& c : text)
+        c = static_cast<char>('a' + random() % 5);
+      EXPECT_EQ(FindAll(matcher, text), FindAllNaive(patterns, text));
+      EXPECT_EQ(matcher.Contains(text),
+                !FindAllNaive(patterns, text).empty());
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(CpuLevels, MultiStringMatcherTest,
+                         testing::Values(CpuLevel::kBaseline,
+                                         CpuLevel::kAvx512));
+
+}  // namespace rst
@@ -0,0 +1,126 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef RST_STRINGS_PARSE_NUMBER_H_
+#define RST_STRINGS_PARSE_NUMBER_H_
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "rst/macros/macros.h"
+#include "rst/not_null/not_null.h"
+#include "rst/status/status.h"
+#include "rst/status/status_or.h"
+
+namespace rst {
+namespace internal {
+
+// Parses a decimal integer with an optional leading minus into its sign and
+// magnitude. Returns false on malformed input or if the magnitude doesn't fit
+// into uint64_t.
+bool ParseIntMagnitude(std::string_view str, NotNull<bool*> negative,
+                       NotNull<uint64_t*> magnitude);
+
+Status MakeNumberParseError(std::string_view str);
+
+}  // namespace internal
+
+// Parses the whole |str| as a decimal integer of type |Int|. Only digits with
+// an optional leading minus for signed types are accepted, no whitespace, no
+// plus sign, no base prefixes. Doesn't depend on the locale. Digits are
+// converted 8 at a time with SWAR arithmetic. Returns NumberParseError on
+// malformed input or overflow.
+//
+// Example:
+//
+//   StatusOr<int> value = ParseInt<int>("-42");  // -42
+//   StatusOr<uint8_t> byte = ParseInt<uint8_t>("256");  // Error.
+//
+template <class Int>
+StatusOr<Int> ParseInt(const std::string_view str) {
+  static_assert(std::is_integral_v<Int> && !std::is_same_v<Int, bool>);
+
+  auto negative = false;
+  uint64_t magnitude = 0;
+  if (!internal::ParseIntMagnitude(str, &negative, &magnitude))
+    return internal::MakeNumberParseError(str);
+
+  constexpr auto kMax = static_cast<uint64_t>(std::numeric_limits<Int>::max());
+  if constexpr (std::is_signed_v<Int>) {
+    if (negative) {
+      if (magnitude > kMax + 1)
+        return internal::MakeNumberParseError(str);
+      // Negating in unsigned arithmetic handles the minimum value.
+      return static_cast<Int>(0 - magnitude);
+    }
+  } else {
+    if (negative && magnitude != 0)
+      return internal::MakeNumberParseError(str);
+  }
+
+  if (magnitude > kMax)
+    return internal::MakeNumberParseError(str);
+  return static_cast<Int>(magnitude);
+}
+
+// Parses the whole |str| as a decimal floating point number like "-1.5e-3",
+// "inf" or "nan", rounding correctly to the nearest double. Doesn't depend on
+// the locale. Uses the Eisel-Lemire algorithm and falls back to exact big
+// decimal arithmetic only for inputs with more than 19 significant digits that
+// are too close to a rounding boundary. Values too small for a double become
+// zero. Returns NumberParseError on malformed input or if the value is too
+// large for a double.
+//
+// Example:
+//
+//   StatusOr<double> value = ParseDouble("0.1");  // 0.1
+//   StatusOr<double> error = ParseDouble("1,5");  // Error.
+//
+StatusOr<double> ParseDouble(std::string_view str);
+
+class NumberParseError : public ErrorInfo<NumberParseError> {
+ public:
+  explicit NumberParseError(std::string&& message);
+  ~NumberParseError() override;
+
+  // ErrorInfo:
+  const std::string& AsString() const override;
+
+  static char id_;
+
+ private:
+  const std::string message_;
+
+  RST_DISALLOW_COPY_AND_ASSIGN(NumberParseError);
+};
+
+}  // namespace rst
+
+#endif  // RST_STRINGS_PARSE_NUMBER_H_
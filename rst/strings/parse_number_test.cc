@@ -0,0 +1,250 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/strings/parse_number.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <string_view>
+
+#include <gtest/gtest.h>
+
+namespace rst {
+namespace {
+
+template <class Int>
+void ExpectInt(const std::string_view str, const Int expected) {
+  auto value = ParseInt<Int>(str);
+  ASSERT_FALSE(value.err()) << str;
+  EXPECT_EQ(*value, expected) << str;
+}
+
+template <class Int>
+void ExpectIntError(const std::string_view str) {
+  auto value = ParseInt<Int>(str);
+  ASSERT_TRUE(value.err()) << str;
+  EXPECT_TRUE(value.status().GetError()->template IsA<NumberParseError>());
+}
+
+// Compares bit patterns to tell apart -0.0 and 0.0.
+void ExpectDouble(const std::string_view str, const double expected) {
+  auto value = ParseDouble(str);
+  ASSERT_FALSE(value.err()) << str;
+  uint64_t bits = 0;
+  uint64_t expected_bits = 0;
+  std::memcpy(&bits, &*value, sizeof(bits));
+  std::memcpy(&expected_bits, &expected, sizeof(expected_bits));
+  EXPECT_EQ(bits, expected_bits) << str;
+}
+
+void ExpectDoubleError(const std::string_view str) {
+  auto value = ParseDouble(str);
+  ASSERT_TRUE(value.err()) << str;
+  EXPECT_TRUE(value.status().GetError()->IsA<NumberParseError>());
+}
+
+// Tests run in the "C" locale.
+double StrToD(const std::string_view str) {
+  return std::strtod(std::string(str).c_str(), nullptr);
+}
+
+}  // namespace
+
+TEST(ParseInt, Valid) {
+  ExpectInt<int>("0", 0);
+  ExpectInt<int>("-0", 0);
+  ExpectInt<int>("42", 42);
+  ExpectInt<int>("-42", -42);
+  ExpectInt<int>("000000000000000000000000000123", 123);
+  ExpectInt<int>("2147483647", std::numeric_limits<int>::max());
+  ExpectInt<int>("-2147483648", std::numeric_limits<int>::min());
+  ExpectInt<int8_t>("-128", -128);
+  ExpectInt<uint8_t>("255", 255);
+  ExpectInt<uint32_t>("12345678", 12345678);
+  ExpectInt<uint64_t>("1234567890123456789", 1234567890123456789);
+  ExpectInt<uint64_t>("18446744073709551615",
+                      std::numeric_limits<uint64_t>::max());
+  ExpectInt<int64_t>("-9223372036854775808",
+                     std::numeric_limits<int64_t>::min());
+  ExpectInt<int64_t>("9223372036854775807",
+                     std::numeric_limits<int64_t>::max());
+}
+
+TEST(ParseInt, Invalid) {
+  ExpectIntError<int>("");
+  ExpectIntError<int>("-");
+  ExpectIntError<int>("+1");
+  ExpectIntError<int>(" 1");
+  ExpectIntError<int>("1 ");
+  ExpectIntError<int>("0x10");
+  ExpectIntError<int>("1.0");
+  ExpectIntError<int>("12345678a");
+  ExpectIntError<int>("1234567a9");
+  ExpectIntError<int>("--1");
+  ExpectIntError<unsigned>("-1");
+}
+
+TEST(ParseInt, Overflow) {
+  ExpectIntError<int>("2147483648");
+  ExpectIntError<int>("-2147483649");
+  ExpectIntError<int8_t>("128");
+  ExpectIntError<int8_t>("-129");
+  ExpectIntError<uint8_t>("256");
+  ExpectIntError<int64_t>("9223372036854775808");
+  ExpectIntError<int64_t>("-9223372036854775809");
+  ExpectIntError<uint64_t>("18446744073709551616");
+  ExpectIntError<uint64_t>("99999999999999999999");
+  ExpectIntError<uint64_t>("100000000000000000000");
+}
+
+TEST(ParseInt, MatchesFromChars) {
+  std::mt19937_64 random(42);
+  for (auto i = 0; i < 10000; i++) {
+    const auto value = static_cast<int64_t>(random()) >> (random() % 64);
+    const auto str = std::to_string(value);
+    ExpectInt<int64_t>(str, value);
+  }
+}
+
+TEST(ParseDouble, Valid) {
+  ExpectDouble("0", 0.0);
+  ExpectDouble("-0", -0.0);
+  ExpectDouble("1", 1.0);
+  ExpectDouble("-1.5", -1.5);
+  ExpectDouble(".5", 0.5);
+  ExpectDouble("5.", 5.0);
+  ExpectDouble("0.1", 0.1);
+  ExpectDouble("1e10", 1e10);
+  ExpectDouble("1E+10", 1e10);
+  ExpectDouble("1.5e-3", 1.5e-3);
+  ExpectDouble("3.141592653589793", 3.141592653589793);
+  ExpectDouble("123456789012345678901234567890", 1.2345678901234568e29);
+  ExpectDouble("0.000000000000000000000000000001", 1e-30);
+  ExpectDouble("1.7976931348623157e308", std::numeric_limits<double>::max());
+  ExpectDouble("2.2250738585072014e-308", std::numeric_limits<double>::min());
+  ExpectDouble("4.9406564584124654e-324",
+               std::numeric_limits<double>::denorm_min());
+  ExpectDouble("1e-400", 0.0);
+  ExpectDouble("-1e-400", -0.0);
+  ExpectDouble("0e999999999999", 0.0);
+  ExpectDouble("inf", std::numeric_limits<double>::infinity());
+  ExpectDouble("-Infinity", -std::numeric_limits<double>::infinity());
+
+  auto nan = ParseDouble("NaN");
+  ASSERT_FALSE(nan.err());
+  EXPECT_TRUE(std::isnan(*nan));
+}
+
+TEST(ParseDouble, Rounding) {
+  // Halfway between 1 and the next double, rounds to even.
+  ExpectDouble("1.00000000000000011102230246251565404236316680908203125", 1.0);
+  // Just above halfway.
+  ExpectDouble("1.00000000000000011102230246251565404236316680908203126",
+               1.0000000000000002);
+  ExpectDouble("9007199254740993", 9007199254740992.0);
+  ExpectDouble("9007199254740995", 9007199254740996.0);
+  ExpectDouble("2.4703282292062327e-324", 0.0);
+  ExpectDouble("2.4703282292062328e-324",
+               std::numeric_limits<double>::denorm_min());
+}
+
+TEST(ParseDouble, LongMantissas) {
+  // Halfway cases with more than 19 significant digits.
+  ExpectDouble("9007199254740993.0000000000000000000", 9007199254740992.0);
+  ExpectDouble("9007199254740993.0000000000000000001", 9007199254740994.0);
+  ExpectDouble("9007199254740995.0000000000000000000", 9007199254740996.0);
+  ExpectDouble("2.4703282292062327208828439643411068618252990130716238"
+               "2212792841250337753635104e-324",
+               0.0);
+  ExpectDouble("2.4703282292062327208828439643411068618252990130716238"
+               "2212792841250337753635105e-324",
+               std::numeric_limits<double>::denorm_min());
+  ExpectDouble("1.7976931348623158079372897140530341e308",
+               std::numeric_limits<double>::max());
+  ExpectDoubleError("1.7976931348623158079372897140530342e308");
+
+  // A non-zero digit after more than 800 digits still breaks the tie.
+  const auto zeros = std::string(1000, '0');
+  ExpectDouble("9007199254740993." + zeros, 9007199254740992.0);
+  ExpectDouble("9007199254740993." + zeros + "1", 9007199254740994.0);
+  ExpectDouble("0." + zeros + "9007199254740993" + zeros + "1e1016",
+               9007199254740994.0);
+}
+
+TEST(ParseDouble, Invalid) {
+  ExpectDoubleError("");
+  ExpectDoubleError("-");
+  ExpectDoubleError(".");
+  ExpectDoubleError("+1");
+  ExpectDoubleError(" 1");
+  ExpectDoubleError("1 ");
+  ExpectDoubleError("1,5");
+  ExpectDoubleError("1e");
+  ExpectDoubleError("1e+");
+  ExpectDoubleError("e5");
+  ExpectDoubleError("1.2.3");
+  ExpectDoubleError("0x1p3");
+  ExpectDoubleError("infinit");
+  ExpectDoubleError("1e309");
+  ExpectDoubleError("-1e309");
+}
+
+TEST(ParseDouble, MatchesStrToD) {
+  std::mt19937_64 random(42);
+  char buffer[64];
+  for (auto i = 0; i < 20000; i++) {
+    // Random bit patterns cover all exponents, shortest and 17-digit
+    // representations cover both parsing paths.
+    auto value = 0.0;
+    const auto bits = random();
+    std::memcpy(&value, &bits, sizeof(value));
+    if (!std::isfinite(value))
+      continue;
+
+    const auto format = i % 2 == 0 ? "%.17g" : "%g";
+    const auto size = std::snprintf(buffer, sizeof(buffer), format, value);
+    const std::string_view str(buffer, static_cast<size_t>(size));
+    ExpectDouble(str, StrToD(str));
+  }
+
+  for (auto i = 0; i < 20000; i++) {
+    // Up to 40 digits exercise truncated mantissas.
+    std::string str = std::to_string(random());
+    str += std::to_string(random() % 1000000);
+    str.insert(random() % str.size(), ".");
+    str += "e" + std::to_string(static_cast<int>(random() % 600) - 320);
+    ExpectDouble(str, StrToD(str));
+  }
+}
+
+}  // namespace rst
@@ -0,0 +1,62 @@
+// Copyright (c) 2019, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef RST_STRINGS_STR_CAT_INL_H_
+#define RST_STRINGS_STR_CAT_INL_H_
+
+#include <algorithm>
+#include <cstddef>
+
+#include "rst/check/check.h"
+#include "rst/macros/header_only.h"
+#include "rst/stl/resize_uninitialized.h"
+#include "rst/strings/str_cat.h"
+
+namespace rst {
+
+RST_HEADER_ONLY_INLINE std::string StrCat(
+    const std::initializer_list<internal::Arg> values) {
+  size_t new_size = 0;
+  for (const auto& val : values)
+    new_size += val.size();
+
+  std::string output;
+  StringResizeUninitialized(&output, new_size);
+
+  auto out = output.data();
+  for (const auto& val : values) {
+    const auto src = val.view();
+    out = std::copy_n(src.data(), src.size(), out);
+  }
+
+  RST_DCHECK(out == output.data() + output.size());
+  return output;
+}
+
+}  // namespace rst
+
+#endif  // RST_STRINGS_STR_CAT_INL_H_
@@ -27,30 +27,8 @@
 
 #include "rst/strings/str_cat.h"
 
-#include <algorithm>
-#include <cstddef>
+#include "rst/macros/header_only.h"
 
-#include "rst/check/check.h"
-#include "rst/stl/resize_uninitialized.h"
-
-namespace rst {
-
-std::string StrCat(std::initializer_list<internal::Arg> values) {
-  size_t new_size = 0;
-  for (const auto& val : values)
-    new_size += val.size();
-
-  std::string output;
-  StringResizeUninitialized(&output, new_size);
-
-  auto out = output.data();
-  for (const auto& val : values) {
-    const auto src = val.view();
-    out = std::copy_n(src.data(), src.size(), out);
-  }
-
-  RST_DCHECK(out == output.data() + output.size());
-  return output;
-}
-
-}  // namespace rst
+#if !RST_BUILDFLAG(HEADER_ONLY)
+#include "rst/strings/str_cat-inl.h"
+#endif  // !RST_BUILDFLAG(HEADER_ONLY)
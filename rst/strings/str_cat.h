@@ -31,6 +31,7 @@
 #include <initializer_list>
 #include <string>
 
+#include "rst/macros/header_only.h"
 #include "rst/strings/arg.h"
 
 // This component is for efficiently performing merging an arbitrary number of
@@ -59,8 +60,13 @@
 //   * enums (printed as underlying integer type)
 namespace rst {
 
-std::string StrCat(std::initializer_list<internal::Arg> values);
+RST_HEADER_ONLY_INLINE std::string StrCat(
+    std::initializer_list<internal::Arg> values);
 
 }  // namespace rst
 
+#if RST_BUILDFLAG(HEADER_ONLY)
+#include "rst/strings/str_cat-inl.h"
+#endif  // RST_BUILDFLAG(HEADER_ONLY)
+
 #endif  // RST_STRINGS_STR_CAT_H_
@@ -34,6 +34,7 @@
 #include <tuple>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "rst/macros/macros.h"
 
@@ -46,8 +47,11 @@ struct Item {
   using Function = std::function<void()>;
 
   Item(Function&& task, const std::chrono::milliseconds time_point,
-       const uint64_t task_id)
-      : task(std::move(task)), time_point(time_point), task_id(task_id) {}
+       const uint64_t task_id, const uint64_t source_id = 0)
+      : task(std::move(task)),
+        time_point(time_point),
+        task_id(task_id),
+        source_id(source_id) {}
   Item(Item&&) noexcept(std::is_nothrow_move_constructible<Function>::value) =
       default;
   ~Item() = default;
@@ -62,11 +66,27 @@ struct Item {
   Function task;
   std::chrono::milliseconds time_point;
   uint64_t task_id = 0;
+  // Task source for fair scheduling, see ThreadPoolTaskRunner.
+  uint64_t source_id = 0;
 
  private:
   RST_DISALLOW_COPY_AND_ASSIGN(Item);
 };
 
+// Returns the time left at |now| until the first task of the |queue| priority
+// queue is due, zero if it's already due or std::chrono::milliseconds::max()
+// if the |queue| is empty. Used as a budget of idle tasks.
+inline std::chrono::milliseconds GetIdleBudget(
+    const std::vector<Item>& queue, const std::chrono::milliseconds now) {
+  if (queue.empty())
+    return std::chrono::milliseconds::max();
+
+  const auto time_point = queue.front().time_point;
+  if (time_point <= now)
+    return std::chrono::milliseconds::zero();
+  return time_point - now;
+}
+
 }  // namespace internal
 }  // namespace rst
 
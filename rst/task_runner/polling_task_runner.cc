@@ -27,6 +27,7 @@
 
 #include "rst/task_runner/polling_task_runner.h"
 
+#include <cstddef>
 #include <utility>
 
 #include "rst/check/check.h"
@@ -40,7 +41,11 @@ PollingTaskRunner::PollingTaskRunner(
     std::function<chrono::milliseconds()>&& time_function)
     : time_function_(std::move(time_function)) {}
 
-PollingTaskRunner::~PollingTaskRunner() { RunPendingTasks(); }
+PollingTaskRunner::~PollingTaskRunner() {
+  InvalidateReplies();
+  ScopedCurrentTaskRunner scoped_current(this);
+  RunDueTasks();
+}
 
 void PollingTaskRunner::PostDelayedTask(std::function<void()>&& task,
                                         const chrono::milliseconds delay) {
@@ -53,7 +58,19 @@ void PollingTaskRunner::PostDelayedTask(std::function<void()>&& task,
   c_push_heap(queue_, std::greater<>());
 }
 
+void PollingTaskRunner::PostIdleTask(
+    std::function<void(chrono::milliseconds)>&& task) {
+  std::lock_guard lock(mutex_);
+  idle_queue_.emplace_back(std::move(task));
+}
+
 void PollingTaskRunner::RunPendingTasks() {
+  ScopedCurrentTaskRunner scoped_current(this);
+  RunDueTasks();
+  RunIdleTasks();
+}
+
+void PollingTaskRunner::RunDueTasks() {
   {
     std::lock_guard lock(mutex_);
 
@@ -77,4 +94,30 @@ void PollingTaskRunner::RunPendingTasks() {
   pending_tasks_.clear();
 }
 
+void PollingTaskRunner::RunIdleTasks() {
+  size_t idle_tasks_num = 0;
+  {
+    std::lock_guard lock(mutex_);
+    idle_tasks_num = idle_queue_.size();
+  }
+
+  // Idle tasks posted by idle tasks are run on the next call.
+  for (; idle_tasks_num > 0; idle_tasks_num--) {
+    std::function<void(chrono::milliseconds)> task;
+    auto budget = chrono::milliseconds::zero();
+    {
+      std::lock_guard lock(mutex_);
+      budget = internal::GetIdleBudget(queue_, time_function_());
+      if (budget.count() == 0)
+        break;
+
+      RST_DCHECK(!idle_queue_.empty());
+      task = std::move(idle_queue_.front());
+      idle_queue_.pop_front();
+    }
+
+    task(budget);
+  }
+}
+
 }  // namespace rst
@@ -30,6 +30,7 @@
 
 #include <chrono>
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <mutex>
 #include <vector>
@@ -53,6 +54,13 @@ namespace rst {
 //     ...
 //   }
 //
+// Idle tasks run only when no regular tasks are due. They get the time left
+// until the next delayed task as a budget:
+//
+//   task_runner.PostIdleTask([](std::chrono::milliseconds budget) {
+//     ...
+//   });
+//
 class PollingTaskRunner : public TaskRunner {
  public:
   // Takes |time_function| that returns current time.
@@ -64,10 +72,20 @@ class PollingTaskRunner : public TaskRunner {
   void PostDelayedTask(std::function<void()>&& task,
                        std::chrono::milliseconds delay) override;
 
-  // Runs all pending tasks in interval (-inf, time_function_()].
+  // Posts |task| to be run when no regular tasks are due. The |task| gets the
+  // time left until the next delayed task or std::chrono::milliseconds::max()
+  // if there are no such tasks. Idle tasks are run in order. Pending idle tasks
+  // are dropped on destruction.
+  void PostIdleTask(std::function<void(std::chrono::milliseconds)>&& task);
+
+  // Runs all pending tasks in interval (-inf, time_function_()] and then the
+  // idle tasks posted before the call while no regular tasks are due.
   void RunPendingTasks();
 
  private:
+  void RunDueTasks();
+  void RunIdleTasks();
+
   std::mutex mutex_;
   // Returns current time.
   const std::function<std::chrono::milliseconds()> time_function_;
@@ -75,6 +93,8 @@ class PollingTaskRunner : public TaskRunner {
   std::vector<std::function<void()>> pending_tasks_;
   // Priority queue of tasks.
   std::vector<internal::Item> queue_;
+  // Queue of idle tasks.
+  std::deque<std::function<void(std::chrono::milliseconds)>> idle_queue_;
   // Increasing task counter.
   uint64_t task_id_ = 0;
 
@@ -118,6 +118,77 @@ TEST(PollingTaskRunner, PostDelayedTaskInOrder) {
   EXPECT_EQ(str, expected);
 }
 
+TEST(PollingTaskRunner, PostIdleTask) {
+  auto ms = 0;
+  PollingTaskRunner task_runner(
+      [&ms]() -> chrono::milliseconds { return chrono::milliseconds(ms); });
+
+  std::string str;
+  std::vector<chrono::milliseconds> budgets;
+  for (auto i = 0; i < 3; i++) {
+    task_runner.PostIdleTask([i, &str, &budgets](chrono::milliseconds budget) {
+      str += "i" + std::to_string(i);
+      budgets.emplace_back(budget);
+    });
+  }
+  task_runner.PostTask([&str]() { str += "t"; });
+
+  task_runner.RunPendingTasks();
+  EXPECT_EQ(str, "ti0i1i2");
+  EXPECT_EQ(budgets, std::vector<chrono::milliseconds>(
+                         3, chrono::milliseconds::max()));
+
+  str.clear();
+  budgets.clear();
+  task_runner.PostDelayedTask([&str]() { str += "d"; },
+                              chrono::milliseconds(100));
+  task_runner.PostIdleTask([&str, &budgets](chrono::milliseconds budget) {
+    str += "i";
+    budgets.emplace_back(budget);
+  });
+  ms = 40;
+  task_runner.RunPendingTasks();
+  EXPECT_EQ(str, "i");
+  EXPECT_EQ(budgets,
+            std::vector<chrono::milliseconds>{chrono::milliseconds(60)});
+
+  ms = 100;
+  task_runner.RunPendingTasks();
+  EXPECT_EQ(str, "id");
+}
+
+TEST(PollingTaskRunner, IdleTasksYieldToRegularTasks) {
+  PollingTaskRunner task_runner(
+      []() -> chrono::milliseconds { return chrono::milliseconds(0); });
+
+  std::string str;
+  task_runner.PostIdleTask([&task_runner, &str](chrono::milliseconds) {
+    str += "i0";
+    task_runner.PostTask([&str]() { str += "t"; });
+    task_runner.PostIdleTask([&str](chrono::milliseconds) { str += "i2"; });
+  });
+  task_runner.PostIdleTask([&str](chrono::milliseconds) { str += "i1"; });
+
+  task_runner.RunPendingTasks();
+  EXPECT_EQ(str, "i0");
+
+  task_runner.RunPendingTasks();
+  EXPECT_EQ(str, "i0ti1i2");
+}
+
+TEST(PollingTaskRunner, DestructorDropsIdleTasks) {
+  std::string str;
+
+  {
+    PollingTaskRunner task_runner(
+        []() -> chrono::milliseconds { return chrono::milliseconds(0); });
+    task_runner.PostIdleTask([&str](chrono::milliseconds) { str += "i"; });
+    task_runner.PostTask([&str]() { str += "t"; });
+  }
+
+  EXPECT_EQ(str, "t");
+}
+
 TEST(PollingTaskRunner, PostTaskConcurrently) {
   PollingTaskRunner task_runner(
       []() -> chrono::milliseconds { return chrono::milliseconds(0); });
@@ -0,0 +1,185 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/task_runner/simulated_task_runner.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "rst/check/check.h"
+#include "rst/stl/algorithm.h"
+
+namespace chrono = std::chrono;
+
+namespace rst {
+
+SimulatedClock::SimulatedClock() = default;
+
+SimulatedClock::~SimulatedClock() { RST_DCHECK(runners_.empty()); }
+
+chrono::milliseconds SimulatedClock::Now() const {
+  std::lock_guard lock(mutex_);
+  return now_;
+}
+
+std::function<chrono::milliseconds()> SimulatedClock::GetTimeFunction() {
+  return [this]() { return Now(); };
+}
+
+void SimulatedClock::RunUntilIdle() { RunTasksUntil(Now()); }
+
+void SimulatedClock::FastForwardBy(const chrono::milliseconds delta) {
+  RST_DCHECK(delta.count() >= 0);
+  const auto end = Now() + delta;
+  RunTasksUntil(end);
+
+  std::lock_guard lock(mutex_);
+  now_ = end;
+}
+
+void SimulatedClock::FastForwardUntilNoTasksRemain() {
+  RunTasksUntil(chrono::milliseconds::max());
+}
+
+void SimulatedClock::RunTasksUntil(const chrono::milliseconds end) {
+  {
+    std::lock_guard lock(mutex_);
+    // Tasks must not run the clock.
+    RST_DCHECK(!is_running_);
+    is_running_ = true;
+  }
+
+  while (true) {
+    std::function<void()> task;
+    Nullable<SimulatedTaskRunner*> runner;
+    {
+      std::lock_guard lock(mutex_);
+      auto time_point = chrono::milliseconds::zero();
+      runner = GetNextRunner(&time_point);
+      if (runner == nullptr || time_point > end)
+        break;
+
+      now_ = std::max(now_, time_point);
+      task = runner->PopNextTask();
+    }
+
+    ScopedCurrentTaskRunner scoped_current(runner.get());
+    task();
+  }
+
+  std::lock_guard lock(mutex_);
+  is_running_ = false;
+}
+
+Nullable<SimulatedTaskRunner*> SimulatedClock::GetNextRunner(
+    const NotNull<chrono::milliseconds*> time_point) {
+  Nullable<SimulatedTaskRunner*> next_runner;
+  uint64_t next_task_id = 0;
+  for (auto* runner : runners_) {
+    auto runner_time_point = chrono::milliseconds::zero();
+    uint64_t task_id = 0;
+    if (!runner->GetNextTask(&runner_time_point, &task_id))
+      continue;
+
+    if (next_runner == nullptr ||
+        std::make_pair(runner_time_point, task_id) <
+            std::make_pair(*time_point, next_task_id)) {
+      next_runner = runner;
+      *time_point = runner_time_point;
+      next_task_id = task_id;
+    }
+  }
+
+  return next_runner;
+}
+
+SimulatedTaskRunner::SimulatedTaskRunner(const NotNull<SimulatedClock*> clock)
+    : clock_(clock) {
+  std::lock_guard lock(clock_->mutex_);
+  clock_->runners_.emplace_back(this);
+}
+
+SimulatedTaskRunner::~SimulatedTaskRunner() {
+  InvalidateReplies();
+
+  {
+    std::lock_guard lock(clock_->mutex_);
+    auto& runners = clock_->runners_;
+    runners.erase(std::find(runners.begin(), runners.end(), this));
+  }
+
+  // Destroyed out of the lock.
+  std::vector<internal::Item> queue;
+  std::lock_guard lock(mutex_);
+  queue.swap(queue_);
+}
+
+void SimulatedTaskRunner::PostDelayedTask(std::function<void()>&& task,
+                                          const chrono::milliseconds delay) {
+  RST_DCHECK(delay.count() >= 0);
+
+  auto time_point = chrono::milliseconds::zero();
+  uint64_t task_id = 0;
+  {
+    std::lock_guard lock(clock_->mutex_);
+    time_point = clock_->now_ + delay;
+    task_id = clock_->task_id_++;
+  }
+
+  std::lock_guard lock(mutex_);
+  queue_.emplace_back(std::move(task), time_point, task_id);
+  c_push_heap(queue_, std::greater<>());
+}
+
+size_t SimulatedTaskRunner::GetPendingTasksNum() const {
+  std::lock_guard lock(mutex_);
+  return queue_.size();
+}
+
+bool SimulatedTaskRunner::GetNextTask(
+    const NotNull<chrono::milliseconds*> time_point,
+    const NotNull<uint64_t*> task_id) const {
+  std::lock_guard lock(mutex_);
+  if (queue_.empty())
+    return false;
+
+  const auto& item = queue_.front();
+  *time_point = item.time_point;
+  *task_id = item.task_id;
+  return true;
+}
+
+std::function<void()> SimulatedTaskRunner::PopNextTask() {
+  std::lock_guard lock(mutex_);
+  RST_DCHECK(!queue_.empty());
+  auto task = std::move(queue_.front().task);
+  c_pop_heap(queue_, std::greater<>());
+  queue_.pop_back();
+  return task;
+}
+
+}  // namespace rst
@@ -0,0 +1,164 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef RST_TASK_RUNNER_SIMULATED_TASK_RUNNER_H_
+#define RST_TASK_RUNNER_SIMULATED_TASK_RUNNER_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "rst/macros/macros.h"
+#include "rst/not_null/not_null.h"
+#include "rst/task_runner/item.h"
+#include "rst/task_runner/task_runner.h"
+
+namespace rst {
+
+class SimulatedTaskRunner;
+
+// Virtual time shared by simulated task runners. The time advances only by
+// FastForwardBy() that jumps from one task deadline to the next, so timers of
+// any length run instantly and in a reproducible order. Tasks of all runners
+// of the clock are run on the calling thread in the order of their deadlines
+// and then the order of posting.
+//
+// Example:
+//
+//   SimulatedClock clock;
+//   SimulatedTaskRunner task_runner(&clock);
+//   OneShotTimer timer(&task_runner);
+//   timer.Start(std::move(task), std::chrono::hours(1));
+//   clock.FastForwardBy(std::chrono::hours(1));
+//   // |task| has run.
+//
+class SimulatedClock {
+ public:
+  // The time starts at zero.
+  SimulatedClock();
+  // The runners must be destroyed first.
+  ~SimulatedClock();
+
+  std::chrono::milliseconds Now() const;
+
+  // Returns a function that returns Now(), e.g. for the time functions of
+  // other task runners. The clock must outlive it.
+  std::function<std::chrono::milliseconds()> GetTimeFunction();
+
+  // Runs the due tasks, including the ones posted by them, without advancing
+  // the time.
+  void RunUntilIdle();
+
+  // Advances the time by |delta|, running the tasks due in the meantime at
+  // their deadlines.
+  void FastForwardBy(std::chrono::milliseconds delta);
+
+  // Advances the time to the deadlines of the tasks until no tasks remain. A
+  // task that always posts another one makes it loop forever.
+  void FastForwardUntilNoTasksRemain();
+
+ private:
+  friend class SimulatedTaskRunner;
+
+  // Runs the tasks due at |end| in order, moving the time to their deadlines.
+  void RunTasksUntil(std::chrono::milliseconds end);
+
+  // Returns the runner with the next task and stores the deadline of the task
+  // to |time_point|. Returns null if there are no tasks.
+  Nullable<SimulatedTaskRunner*> GetNextRunner(
+      NotNull<std::chrono::milliseconds*> time_point);
+
+  mutable std::mutex mutex_;
+  std::chrono::milliseconds now_ = std::chrono::milliseconds::zero();
+  // Task counter of all runners to run the tasks with the same deadline in
+  // the order of posting.
+  uint64_t task_id_ = 0;
+  std::vector<SimulatedTaskRunner*> runners_;
+  bool is_running_ = false;
+
+  RST_DISALLOW_COPY_AND_ASSIGN(SimulatedClock);
+};
+
+// Task runner with virtual time for simulations and tests. Its tasks are run
+// by the methods of its SimulatedClock.
+//
+// Example:
+//
+//   SimulatedTaskRunner task_runner(&clock);
+//   task_runner.PostDelayedTask(std::move(task), std::chrono::minutes(1));
+//   task_runner.FastForwardBy(std::chrono::minutes(1));
+//   // |task| has run.
+//
+class SimulatedTaskRunner : public TaskRunner {
+ public:
+  explicit SimulatedTaskRunner(NotNull<SimulatedClock*> clock);
+  // Pending tasks are dropped.
+  ~SimulatedTaskRunner() override;
+
+  // TaskRunner:
+  void PostDelayedTask(std::function<void()>&& task,
+                       std::chrono::milliseconds delay) override;
+
+  // Shortcuts for the methods of the clock. They run the tasks of all runners
+  // of the clock.
+  void RunUntilIdle() { clock_->RunUntilIdle(); }
+  void FastForwardBy(const std::chrono::milliseconds delta) {
+    clock_->FastForwardBy(delta);
+  }
+  void FastForwardUntilNoTasksRemain() {
+    clock_->FastForwardUntilNoTasksRemain();
+  }
+
+  size_t GetPendingTasksNum() const;
+
+  NotNull<SimulatedClock*> clock() const { return clock_; }
+
+ private:
+  friend class SimulatedClock;
+
+  // Returns false if there are no tasks. Otherwise stores the deadline and the
+  // id of the next task.
+  bool GetNextTask(NotNull<std::chrono::milliseconds*> time_point,
+                   NotNull<uint64_t*> task_id) const;
+
+  std::function<void()> PopNextTask();
+
+  const NotNull<SimulatedClock*> clock_;
+
+  mutable std::mutex mutex_;
+  // Priority queue of tasks.
+  std::vector<internal::Item> queue_;
+
+  RST_DISALLOW_COPY_AND_ASSIGN(SimulatedTaskRunner);
+};
+
+}  // namespace rst
+
+#endif  // RST_TASK_RUNNER_SIMULATED_TASK_RUNNER_H_
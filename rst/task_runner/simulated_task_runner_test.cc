@@ -0,0 +1,207 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/task_runner/simulated_task_runner.h"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "rst/task_runner/polling_task_runner.h"
+#include "rst/timer/one_shot_timer.h"
+
+namespace chrono = std::chrono;
+
+namespace rst {
+
+TEST(SimulatedTaskRunner, IsTaskRunner) {
+  SimulatedClock clock;
+  const SimulatedTaskRunner task_runner(&clock);
+  const TaskRunner& i_task_runner = task_runner;
+  (void)i_task_runner;
+  EXPECT_EQ(task_runner.clock().get(), &clock);
+}
+
+TEST(SimulatedTaskRunner, RunUntilIdle) {
+  SimulatedClock clock;
+  SimulatedTaskRunner task_runner(&clock);
+
+  std::string str;
+  task_runner.PostTask([&task_runner, &str]() {
+    str += "a";
+    task_runner.PostTask([&str]() { str += "c"; });
+  });
+  task_runner.PostTask([&str]() { str += "b"; });
+  task_runner.PostDelayedTask([&str]() { str += "d"; },
+                              chrono::milliseconds(1));
+  EXPECT_EQ(task_runner.GetPendingTasksNum(), 3U);
+
+  task_runner.RunUntilIdle();
+  EXPECT_EQ(str, "abc");
+  EXPECT_EQ(clock.Now(), chrono::milliseconds(0));
+  EXPECT_EQ(task_runner.GetPendingTasksNum(), 1U);
+}
+
+TEST(SimulatedTaskRunner, FastForwardBy) {
+  SimulatedClock clock;
+  SimulatedTaskRunner task_runner(&clock);
+
+  std::vector<chrono::milliseconds> run_times;
+  for (const auto delay : {30, 5, 10, 10}) {
+    task_runner.PostDelayedTask(
+        [&clock, &run_times]() { run_times.emplace_back(clock.Now()); },
+        chrono::milliseconds(delay));
+  }
+
+  task_runner.FastForwardBy(chrono::milliseconds(20));
+  EXPECT_EQ(run_times,
+            (std::vector<chrono::milliseconds>{chrono::milliseconds(5),
+                                               chrono::milliseconds(10),
+                                               chrono::milliseconds(10)}));
+  EXPECT_EQ(clock.Now(), chrono::milliseconds(20));
+
+  task_runner.FastForwardBy(chrono::milliseconds(10));
+  EXPECT_EQ(run_times.size(), 4U);
+  EXPECT_EQ(run_times.back(), chrono::milliseconds(30));
+  EXPECT_EQ(clock.Now(), chrono::milliseconds(30));
+}
+
+TEST(SimulatedTaskRunner, TasksPostedWhileFastForwarding) {
+  SimulatedClock clock;
+  SimulatedTaskRunner task_runner(&clock);
+
+  // A periodic task every 10 ms.
+  std::vector<chrono::milliseconds> run_times;
+  std::function<void()> tick;
+  tick = [&clock, &task_runner, &run_times, &tick]() {
+    run_times.emplace_back(clock.Now());
+    task_runner.PostDelayedTask(std::function<void()>(tick),
+                                chrono::milliseconds(10));
+  };
+  task_runner.PostTask(std::function<void()>(tick));
+
+  task_runner.FastForwardBy(chrono::minutes(1));
+  EXPECT_EQ(run_times.size(), 6001U);
+  EXPECT_EQ(run_times.back(), chrono::minutes(1));
+}
+
+TEST(SimulatedTaskRunner, SharedClock) {
+  SimulatedClock clock;
+  SimulatedTaskRunner first(&clock);
+  SimulatedTaskRunner second(&clock);
+
+  std::string str;
+  const auto post = [&str](SimulatedTaskRunner& task_runner,  // NOLINT
+                           const std::string& name, const int delay) {
+    task_runner.PostDelayedTask(
+        [&task_runner, &str, name]() {
+          EXPECT_EQ(TaskRunner::GetCurrent(), &task_runner);
+          str += name;
+        },
+        chrono::milliseconds(delay));
+  };
+  post(first, "a", 2);
+  post(second, "b", 1);
+  post(first, "c", 1);
+  post(second, "d", 2);
+  post(second, "e", 3);
+
+  first.FastForwardBy(chrono::milliseconds(2));
+  EXPECT_EQ(str, "bcad");
+  EXPECT_EQ(second.GetPendingTasksNum(), 1U);
+
+  second.FastForwardUntilNoTasksRemain();
+  EXPECT_EQ(str, "bcade");
+  EXPECT_EQ(clock.Now(), chrono::milliseconds(3));
+}
+
+TEST(SimulatedTaskRunner, PostTaskAndReply) {
+  SimulatedClock clock;
+  SimulatedTaskRunner origin(&clock);
+  SimulatedTaskRunner worker(&clock);
+
+  std::string str;
+  origin.PostTask([&worker, &str]() {
+    worker.PostTaskAndReplyWithResult(
+        [&worker]() -> std::string {
+          EXPECT_EQ(TaskRunner::GetCurrent(), &worker);
+          return "task";
+        },
+        [&str](std::string result) { str = result + " reply"; });
+  });
+
+  clock.RunUntilIdle();
+  EXPECT_EQ(str, "task reply");
+}
+
+TEST(SimulatedTaskRunner, DestructorDropsPendingTasks) {
+  SimulatedClock clock;
+  auto is_run = false;
+  {
+    SimulatedTaskRunner task_runner(&clock);
+    task_runner.PostTask([&is_run]() { is_run = true; });
+  }
+  clock.FastForwardUntilNoTasksRemain();
+  EXPECT_FALSE(is_run);
+}
+
+TEST(SimulatedTaskRunner, OneShotTimer) {
+  SimulatedClock clock;
+  SimulatedTaskRunner task_runner(&clock);
+  OneShotTimer timer(&task_runner);
+
+  auto is_fired = false;
+  timer.Start([&is_fired]() { is_fired = true; }, chrono::hours(24));
+  task_runner.FastForwardBy(chrono::hours(24) - chrono::milliseconds(1));
+  EXPECT_FALSE(is_fired);
+  EXPECT_TRUE(timer.IsRunning());
+
+  task_runner.FastForwardBy(chrono::milliseconds(1));
+  EXPECT_TRUE(is_fired);
+  EXPECT_FALSE(timer.IsRunning());
+}
+
+TEST(SimulatedClock, TimeFunction) {
+  SimulatedClock clock;
+  PollingTaskRunner task_runner(clock.GetTimeFunction());
+
+  auto is_run = false;
+  task_runner.PostDelayedTask([&is_run]() { is_run = true; },
+                              chrono::milliseconds(5));
+  task_runner.RunPendingTasks();
+  EXPECT_FALSE(is_run);
+
+  clock.FastForwardBy(chrono::milliseconds(5));
+  task_runner.RunPendingTasks();
+  EXPECT_TRUE(is_run);
+}
+
+}  // namespace rst
@@ -0,0 +1,204 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/task_runner/task_graph.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <utility>
+
+#include "rst/check/check.h"
+#include "rst/stl/algorithm.h"
+
+namespace rst {
+
+TaskGraph::TaskGraph() = default;
+
+TaskGraph::~TaskGraph() { RST_DCHECK(!is_running_); }
+
+size_t TaskGraph::AddNode(std::function<void()>&& task, const uint64_t cost) {
+  RST_DCHECK(!is_running_);
+  RST_DCHECK(task != nullptr);
+
+  is_prepared_ = false;
+  auto& node = nodes_.emplace_back();
+  node.task = std::move(task);
+  node.cost = cost;
+  return nodes_.size() - 1;
+}
+
+void TaskGraph::AddEdge(const size_t predecessor, const size_t successor) {
+  RST_DCHECK(!is_running_);
+  RST_DCHECK(predecessor < nodes_.size());
+  RST_DCHECK(successor < nodes_.size());
+  RST_DCHECK(predecessor != successor);
+
+  is_prepared_ = false;
+  nodes_[predecessor].successors.emplace_back(successor);
+  nodes_[successor].predecessors_num++;
+}
+
+void TaskGraph::Run(const NotNull<TaskRunner*> task_runner,
+                    std::function<void()>&& on_done) {
+  RST_DCHECK(on_done != nullptr);
+
+  size_t ready_nodes_num = 0;
+  {
+    std::lock_guard lock(mutex_);
+    RST_DCHECK(!is_running_);
+    if (!is_prepared_)
+      Prepare();
+
+    if (nodes_.empty()) {
+      task_runner->PostTask(std::move(on_done));
+      return;
+    }
+
+    is_running_ = true;
+    unfinished_nodes_num_ = nodes_.size();
+    on_done_ = std::move(on_done);
+    ready_nodes_.clear();
+    for (size_t i = 0; i < nodes_.size(); i++) {
+      pending_predecessors_[i] = nodes_[i].predecessors_num;
+      if (pending_predecessors_[i] == 0)
+        ready_nodes_.emplace_back(i);
+    }
+    std::make_heap(ready_nodes_.begin(), ready_nodes_.end(),
+                   [this](const size_t lhs, const size_t rhs) {
+                     return IsLessUrgent(lhs, rhs);
+                   });
+    ready_nodes_num = ready_nodes_.size();
+  }
+
+  // Every posted task takes the most urgent node ready at the moment it's run,
+  // not at the moment it's posted.
+  for (size_t i = 0; i < ready_nodes_num; i++)
+    task_runner->PostTask([this, task_runner]() { RunNextNode(task_runner); });
+}
+
+void TaskGraph::RunAndWait(const NotNull<TaskRunner*> task_runner) {
+  std::mutex done_mutex;
+  std::condition_variable done_cv;
+  auto is_done = false;
+
+  Run(task_runner, [&done_mutex, &done_cv, &is_done]() {
+    std::lock_guard lock(done_mutex);
+    is_done = true;
+    done_cv.notify_one();
+  });
+
+  std::unique_lock lock(done_mutex);
+  while (!is_done)
+    done_cv.wait(lock);
+}
+
+void TaskGraph::Prepare() {
+  // Kahn's algorithm.
+  std::vector<size_t> order;
+  order.reserve(nodes_.size());
+  pending_predecessors_.resize(nodes_.size());
+  for (size_t i = 0; i < nodes_.size(); i++) {
+    pending_predecessors_[i] = nodes_[i].predecessors_num;
+    if (pending_predecessors_[i] == 0)
+      order.emplace_back(i);
+  }
+  for (size_t i = 0; i < order.size(); i++) {
+    for (const auto successor : nodes_[order[i]].successors) {
+      if (--pending_predecessors_[successor] == 0)
+        order.emplace_back(successor);
+    }
+  }
+  RST_CHECK(order.size() == nodes_.size());
+
+  for (auto it = order.rbegin(); it != order.rend(); ++it) {
+    auto& node = nodes_[*it];
+    uint64_t successors_path = 0;
+    for (const auto successor : node.successors) {
+      successors_path =
+          std::max(successors_path, nodes_[successor].critical_path);
+    }
+    node.critical_path = node.cost + successors_path;
+  }
+
+  ready_nodes_.reserve(nodes_.size());
+  is_prepared_ = true;
+}
+
+void TaskGraph::RunNextNode(const NotNull<TaskRunner*> task_runner) {
+  const auto is_less_urgent = [this](const size_t lhs, const size_t rhs) {
+    return IsLessUrgent(lhs, rhs);
+  };
+
+  size_t id = 0;
+  {
+    std::lock_guard lock(mutex_);
+    RST_DCHECK(!ready_nodes_.empty());
+    c_pop_heap(ready_nodes_, is_less_urgent);
+    id = ready_nodes_.back();
+    ready_nodes_.pop_back();
+  }
+
+  const auto& node = nodes_[id];
+  node.task();
+
+  size_t ready_nodes_num = 0;
+  std::function<void()> on_done;
+  {
+    std::lock_guard lock(mutex_);
+    for (const auto successor : node.successors) {
+      if (--pending_predecessors_[successor] != 0)
+        continue;
+      ready_nodes_.emplace_back(successor);
+      c_push_heap(ready_nodes_, is_less_urgent);
+      ready_nodes_num++;
+    }
+
+    if (--unfinished_nodes_num_ == 0) {
+      is_running_ = false;
+      on_done = std::move(on_done_);
+      on_done_ = nullptr;
+    }
+  }
+
+  // The graph may be destroyed by |on_done| once the posted nodes have
+  // finished, so it isn't accessed below.
+  for (size_t i = 0; i < ready_nodes_num; i++)
+    task_runner->PostTask([this, task_runner]() { RunNextNode(task_runner); });
+  if (on_done != nullptr)
+    on_done();
+}
+
+bool TaskGraph::IsLessUrgent(const size_t lhs, const size_t rhs) const {
+  const auto lhs_path = nodes_[lhs].critical_path;
+  const auto rhs_path = nodes_[rhs].critical_path;
+  if (lhs_path != rhs_path)
+    return lhs_path < rhs_path;
+  // Earlier added nodes first.
+  return lhs > rhs;
+}
+
+}  // namespace rst
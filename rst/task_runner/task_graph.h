@@ -0,0 +1,126 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef RST_TASK_RUNNER_TASK_GRAPH_H_
+#define RST_TASK_RUNNER_TASK_GRAPH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "rst/macros/macros.h"
+#include "rst/not_null/not_null.h"
+#include "rst/task_runner/task_runner.h"
+
+namespace rst {
+
+// Directed acyclic graph of tasks. A node is run on a task runner as soon as
+// all its predecessors have finished. The graph is built once and can be run
+// many times: the per run state is allocated by the first run after a change.
+//
+// Of the ready nodes the one with the longest path to the end of the graph
+// (the critical path) is started first. The path length is the sum of the
+// node costs, which are estimates in any units.
+//
+// Example:
+//
+//   TaskGraph graph;
+//   const size_t build = graph.AddNode([]() { Build(); }, /*cost=*/10);
+//   const size_t test = graph.AddNode([]() { Test(); });
+//   const size_t publish = graph.AddNode([]() { Publish(); });
+//   graph.AddEdge(build, test);
+//   graph.AddEdge(test, publish);
+//
+//   ThreadPoolTaskRunner task_runner(...);
+//   graph.Run(&task_runner, []() {
+//     // All nodes have finished.
+//   });
+//
+class TaskGraph {
+ public:
+  TaskGraph();
+  ~TaskGraph();
+
+  // Adds a node running |task| and returns its id. Ids are consecutive
+  // starting from zero.
+  size_t AddNode(std::function<void()>&& task, uint64_t cost = 1);
+
+  // Makes the node |successor| wait for the node |predecessor|. The graph must
+  // stay acyclic.
+  void AddEdge(size_t predecessor, size_t successor);
+
+  // Posts the nodes to |task_runner| and calls |on_done| on it after all of
+  // them have finished. The graph must not be changed, run again or destroyed
+  // until then, but it can be destroyed by |on_done|.
+  void Run(NotNull<TaskRunner*> task_runner, std::function<void()>&& on_done);
+
+  // Runs the graph and blocks until all nodes have finished. Must not be
+  // called on a thread of |task_runner|.
+  void RunAndWait(NotNull<TaskRunner*> task_runner);
+
+  size_t nodes_num() const { return nodes_.size(); }
+
+ private:
+  struct Node {
+    std::function<void()> task;
+    uint64_t cost = 1;
+    std::vector<size_t> successors;
+    size_t predecessors_num = 0;
+    // The longest sum of costs on a path from the node to a sink.
+    uint64_t critical_path = 0;
+  };
+
+  // Computes the critical paths and allocates the per run state.
+  void Prepare();
+
+  // Runs the ready node with the longest critical path.
+  void RunNextNode(NotNull<TaskRunner*> task_runner);
+
+  // Max heap comparator of |ready_nodes_|.
+  bool IsLessUrgent(size_t lhs, size_t rhs) const;
+
+  std::vector<Node> nodes_;
+  bool is_prepared_ = false;
+
+  // Per run state.
+  std::mutex mutex_;
+  bool is_running_ = false;
+  // Unfinished predecessors of the nodes.
+  std::vector<size_t> pending_predecessors_;
+  // Max heap of the nodes without unfinished predecessors.
+  std::vector<size_t> ready_nodes_;
+  size_t unfinished_nodes_num_ = 0;
+  std::function<void()> on_done_;
+
+  RST_DISALLOW_COPY_AND_ASSIGN(TaskGraph);
+};
+
+}  // namespace rst
+
+#endif  // RST_TASK_RUNNER_TASK_GRAPH_H_
@@ -0,0 +1,184 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/task_runner/task_graph.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "rst/bind/bind_helpers.h"
+#include "rst/stl/algorithm.h"
+#include "rst/task_runner/polling_task_runner.h"
+#include "rst/task_runner/thread_pool_task_runner.h"
+
+namespace chrono = std::chrono;
+
+namespace rst {
+namespace {
+
+chrono::milliseconds GetZeroGraphTime() { return chrono::milliseconds(0); }
+
+}  // namespace
+
+TEST(TaskGraph, Empty) {
+  PollingTaskRunner task_runner(GetZeroGraphTime);
+  TaskGraph graph;
+  auto is_done = false;
+  graph.Run(&task_runner, [&is_done]() { is_done = true; });
+  task_runner.RunPendingTasks();
+  EXPECT_TRUE(is_done);
+}
+
+TEST(TaskGraph, RunsInDependencyOrder) {
+  ThreadPoolTaskRunner task_runner(4, GetZeroGraphTime);
+
+  // 0 -> 1, 2, 3 -> 4.
+  std::mutex mtx;
+  std::vector<size_t> order;
+  TaskGraph graph;
+  for (size_t i = 0; i < 5; i++) {
+    graph.AddNode([i, &mtx, &order]() {
+      std::lock_guard lock(mtx);
+      order.emplace_back(i);
+    });
+  }
+  for (size_t i = 1; i < 4; i++) {
+    graph.AddEdge(0, i);
+    graph.AddEdge(i, 4);
+  }
+  EXPECT_EQ(graph.nodes_num(), 5U);
+
+  graph.RunAndWait(&task_runner);
+
+  ASSERT_EQ(order.size(), 5U);
+  EXPECT_EQ(order.front(), 0U);
+  EXPECT_EQ(order.back(), 4U);
+  std::vector<size_t> middle(order.begin() + 1, order.end() - 1);
+  c_sort(middle);
+  EXPECT_EQ(middle, (std::vector<size_t>{1, 2, 3}));
+}
+
+TEST(TaskGraph, CriticalPathFirst) {
+  PollingTaskRunner task_runner(GetZeroGraphTime);
+
+  std::string str;
+  TaskGraph graph;
+  const auto short_path = graph.AddNode([&str]() { str += "s"; });
+  const auto long_path = graph.AddNode([&str]() { str += "l"; });
+  const auto long_path_end =
+      graph.AddNode([&str]() { str += "e"; }, /*cost=*/10);
+  const auto heavy = graph.AddNode([&str]() { str += "h"; }, /*cost=*/5);
+  graph.AddEdge(long_path, long_path_end);
+  EXPECT_EQ(short_path, 0U);
+  EXPECT_EQ(heavy, 3U);
+
+  auto is_done = false;
+  graph.Run(&task_runner, [&is_done]() { is_done = true; });
+  while (!is_done)
+    task_runner.RunPendingTasks();
+
+  // The paths are 1, 11 and 5 long. The end of the long path has a 10 long one
+  // and overtakes the nodes posted before it.
+  EXPECT_EQ(str, "lehs");
+}
+
+TEST(TaskGraph, RunMultipleTimes) {
+  ThreadPoolTaskRunner task_runner(2, GetZeroGraphTime);
+
+  std::mutex mtx;
+  std::string str;
+  TaskGraph graph;
+  const auto a = graph.AddNode([&mtx, &str]() {
+    std::lock_guard lock(mtx);
+    str += "a";
+  });
+  const auto b = graph.AddNode([&mtx, &str]() {
+    std::lock_guard lock(mtx);
+    str += "b";
+  });
+  graph.AddEdge(a, b);
+
+  for (auto i = 0; i < 100; i++)
+    graph.RunAndWait(&task_runner);
+  std::string expected;
+  for (auto i = 0; i < 100; i++)
+    expected += "ab";
+  EXPECT_EQ(str, expected);
+
+  // Changes are picked up by the next run.
+  const auto c = graph.AddNode([&mtx, &str]() {
+    std::lock_guard lock(mtx);
+    str += "c";
+  });
+  graph.AddEdge(c, a);
+  str.clear();
+  graph.RunAndWait(&task_runner);
+  EXPECT_EQ(str, "cab");
+}
+
+TEST(TaskGraph, DestroyedByOnDone) {
+  ThreadPoolTaskRunner task_runner(2, GetZeroGraphTime);
+
+  std::mutex mtx;
+  std::condition_variable cv;
+  auto graph = std::make_unique<TaskGraph>();
+  for (auto i = 0; i < 10; i++)
+    graph->AddNode(DoNothing());
+
+  auto is_done = false;
+  auto* graph_ptr = graph.get();
+  graph_ptr->Run(&task_runner, [&mtx, &cv, &graph, &is_done]() {
+    graph.reset();
+    std::lock_guard lock(mtx);
+    is_done = true;
+    cv.notify_one();
+  });
+
+  std::unique_lock lock(mtx);
+  while (!is_done)
+    cv.wait(lock);
+  EXPECT_EQ(graph, nullptr);
+}
+
+TEST(TaskGraph, Cycle) {
+  PollingTaskRunner task_runner(GetZeroGraphTime);
+  TaskGraph graph;
+  const auto a = graph.AddNode(DoNothing());
+  const auto b = graph.AddNode(DoNothing());
+  graph.AddEdge(a, b);
+  graph.AddEdge(b, a);
+  EXPECT_DEATH(graph.Run(&task_runner, DoNothing()), "");
+}
+
+}  // namespace rst
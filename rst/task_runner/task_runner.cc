@@ -30,7 +30,81 @@
 namespace chrono = std::chrono;
 
 namespace rst {
+namespace {
 
-TaskRunner::~TaskRunner() = default;
+thread_local TaskRunner* t_current_task_runner = nullptr;
+
+}  // namespace
+
+namespace internal {
+
+TaskRunnerHandle::TaskRunnerHandle(const NotNull<TaskRunner*> task_runner)
+    : task_runner_(task_runner) {}
+
+TaskRunnerHandle::~TaskRunnerHandle() = default;
+
+void TaskRunnerHandle::PostTask(std::function<void()>&& task) {
+  std::lock_guard lock(mutex_);
+  if (task_runner_ != nullptr)
+    task_runner_->PostTask(std::move(task));
+}
+
+void TaskRunnerHandle::Invalidate() {
+  std::lock_guard lock(mutex_);
+  task_runner_ = nullptr;
+}
+
+}  // namespace internal
+
+TaskRunner::TaskRunner()
+    : handle_(std::make_shared<internal::TaskRunnerHandle>(this)) {}
+
+TaskRunner::~TaskRunner() { InvalidateReplies(); }
+
+void TaskRunner::PostTask(const Location& location,
+                          std::function<void()>&& task) {
+  PostTask([location, task = std::move(task)]() {
+    ScopedTaskLocation scoped_location(location);
+    task();
+  });
+}
+
+void TaskRunner::PostTaskAndReply(std::function<void()>&& task,
+                                  std::function<void()>&& reply) {
+  struct Relay {
+    std::function<void()> task;
+    std::function<void()> reply;
+    NotNull<std::shared_ptr<internal::TaskRunnerHandle>> origin;
+  };
+
+  auto relay = std::make_shared<Relay>(
+      Relay{std::move(task), std::move(reply), GetCurrentHandle()});
+  PostTask([relay]() {
+    relay->task();
+    relay->origin->PostTask([relay]() { relay->reply(); });
+  });
+}
+
+// static
+Nullable<TaskRunner*> TaskRunner::GetCurrent() { return t_current_task_runner; }
+
+void TaskRunner::InvalidateReplies() { handle_->Invalidate(); }
+
+// static
+NotNull<std::shared_ptr<internal::TaskRunnerHandle>>
+TaskRunner::GetCurrentHandle() {
+  RST_DCHECK(t_current_task_runner != nullptr);
+  return t_current_task_runner->handle_;
+}
+
+ScopedCurrentTaskRunner::ScopedCurrentTaskRunner(
+    const NotNull<TaskRunner*> task_runner)
+    : previous_(t_current_task_runner) {
+  t_current_task_runner = task_runner.get();
+}
+
+ScopedCurrentTaskRunner::~ScopedCurrentTaskRunner() {
+  t_current_task_runner = previous_.get();
+}
 
 }  // namespace rst
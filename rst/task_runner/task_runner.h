@@ -30,10 +30,46 @@
 
 #include <chrono>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
 #include <utility>
 
+#include "rst/check/check.h"
+#include "rst/location/location.h"
+#include "rst/macros/macros.h"
+#include "rst/not_null/not_null.h"
+
 namespace rst {
 
+class TaskRunner;
+
+namespace internal {
+
+// Posts tasks to a task runner until the task runner is destroyed. Shared by
+// the task runner and the replies on the way to it.
+class TaskRunnerHandle {
+ public:
+  explicit TaskRunnerHandle(NotNull<TaskRunner*> task_runner);
+  ~TaskRunnerHandle();
+
+  // Posts |task| to the task runner or drops it if the task runner has been
+  // destroyed.
+  void PostTask(std::function<void()>&& task);
+
+  // Makes subsequent PostTask() calls drop tasks.
+  void Invalidate();
+
+ private:
+  std::mutex mutex_;
+  Nullable<TaskRunner*> task_runner_;
+
+  RST_DISALLOW_COPY_AND_ASSIGN(TaskRunnerHandle);
+};
+
+}  // namespace internal
+
 // An object that runs posted tasks in sequence (in the form of
 // std::function<void()> objects). All methods are thread-safe.
 class TaskRunner {
@@ -46,12 +82,122 @@ class TaskRunner {
   virtual void PostDelayedTask(std::function<void()>&& task,
                                std::chrono::milliseconds delay) = 0;
 
+  // Like PostDelayedTask(), but queues |task| even if the queue of the task
+  // runner is at capacity, rather than blocking, dropping or running it on the
+  // calling thread. For tasks of schedulers built on top of the task runner
+  // that must run later and exactly once, like resuming a fiber.
+  virtual void PostDelayedTaskOverCapacity(std::function<void()>&& task,
+                                           std::chrono::milliseconds delay) {
+    PostDelayedTask(std::move(task), delay);
+  }
+
   // Posts the given task to be run.
   void PostTask(std::function<void()>&& task) {
     PostDelayedTask(std::move(task), std::chrono::milliseconds::zero());
   }
+
+  // Like PostTask(), but sets |location| as the ScopedTaskLocation while
+  // |task| runs, for example for log lines of the task.
+  //
+  // Example:
+  //
+  //   task_runner.PostTask(RST_FROM_HERE, []() { RST_LOG_INFO("Task"); });
+  //
+  void PostTask(const Location& location, std::function<void()>&& task);
+
+  // Posts |task| to be run and then |reply| to be run on the task runner that
+  // runs the calling task, see GetCurrent(). The |reply| is dropped if that
+  // task runner is destroyed in the meantime. Must be called from a task.
+  //
+  // Example:
+  //
+  //   thread_pool.PostTaskAndReply([]() { DoBlockingWork(); },
+  //                                []() { OnWorkDone(); });
+  //
+  void PostTaskAndReply(std::function<void()>&& task,
+                        std::function<void()>&& reply);
+
+  // Like PostTaskAndReply(), but passes the result of |task| to |reply|. The
+  // result is moved, so it can be of a move-only type as well as |task| and
+  // |reply|.
+  //
+  // Example:
+  //
+  //   thread_pool.PostTaskAndReplyWithResult(
+  //       []() -> std::unique_ptr<Data> { return LoadData(); },
+  //       [](std::unique_ptr<Data> data) { ... });
+  //
+  template <class Task, class Reply>
+  void PostTaskAndReplyWithResult(Task&& task, Reply&& reply);
+
+  // Returns the task runner that runs the task on the calling thread if any.
+  static Nullable<TaskRunner*> GetCurrent();
+
+ protected:
+  TaskRunner();
+
+  // Makes replies posted to the task runner after the call be dropped.
+  // Implementations call it in their destructors before anything used by
+  // PostDelayedTask() is destroyed.
+  void InvalidateReplies();
+
+ private:
+  // Returns the handle of the current task runner.
+  static NotNull<std::shared_ptr<internal::TaskRunnerHandle>>
+  GetCurrentHandle();
+
+  const NotNull<std::shared_ptr<internal::TaskRunnerHandle>> handle_;
+
+  RST_DISALLOW_COPY_AND_ASSIGN(TaskRunner);
+};
+
+// Sets the task runner returned by TaskRunner::GetCurrent() on the calling
+// thread for the lifetime of the object. Used by implementations of
+// TaskRunner around running tasks. Scopes can be nested.
+//
+// Example:
+//
+//   void FooTaskRunner::RunTask(const std::function<void()>& task) {
+//     ScopedCurrentTaskRunner scoped_current(this);
+//     task();
+//   }
+//
+class ScopedCurrentTaskRunner {
+ public:
+  explicit ScopedCurrentTaskRunner(NotNull<TaskRunner*> task_runner);
+  ~ScopedCurrentTaskRunner();
+
+ private:
+  const Nullable<TaskRunner*> previous_;
+
+  RST_DISALLOW_COPY_AND_ASSIGN(ScopedCurrentTaskRunner);
 };
 
+template <class Task, class Reply>
+void TaskRunner::PostTaskAndReplyWithResult(Task&& task, Reply&& reply) {
+  using Result = std::invoke_result_t<std::decay_t<Task>&>;
+  static_assert(!std::is_void_v<Result>, "Use PostTaskAndReply()");
+
+  // Both closures share the relay, so neither |task|, |reply| nor the result
+  // have to be copyable and the result is moved into |reply|.
+  struct Relay {
+    std::decay_t<Task> task;
+    std::decay_t<Reply> reply;
+    NotNull<std::shared_ptr<internal::TaskRunnerHandle>> origin;
+    std::optional<Result> result;
+  };
+
+  auto relay = std::make_shared<Relay>(Relay{std::forward<Task>(task),
+                                             std::forward<Reply>(reply),
+                                             GetCurrentHandle(), std::nullopt});
+  PostTask([relay]() {
+    relay->result.emplace(std::invoke(relay->task));
+    relay->origin->PostTask([relay]() {
+      std::invoke(relay->reply, std::move(*relay->result));
+    });
+  });
+}
+
 }  // namespace rst
 
 #endif  // RST_TASK_RUNNER_TASK_RUNNER_H_
@@ -0,0 +1,190 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/task_runner/task_runner.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "rst/task_runner/polling_task_runner.h"
+#include "rst/task_runner/thread_pool_task_runner.h"
+
+namespace chrono = std::chrono;
+
+namespace rst {
+namespace {
+
+chrono::milliseconds GetZeroTime() { return chrono::milliseconds(0); }
+
+}  // namespace
+
+TEST(TaskRunner, GetCurrent) {
+  EXPECT_EQ(TaskRunner::GetCurrent(), nullptr);
+
+  PollingTaskRunner polling(GetZeroTime);
+  ThreadPoolTaskRunner thread_pool(1, GetZeroTime);
+
+  Nullable<TaskRunner*> polling_current;
+  polling.PostTask(
+      [&polling_current]() { polling_current = TaskRunner::GetCurrent(); });
+  polling.RunPendingTasks();
+  EXPECT_EQ(polling_current, &polling);
+  EXPECT_EQ(TaskRunner::GetCurrent(), nullptr);
+
+  std::atomic<TaskRunner*> thread_pool_current = nullptr;
+  thread_pool.PostTask([&thread_pool_current]() {
+    thread_pool_current = TaskRunner::GetCurrent().get();
+  });
+  while (thread_pool_current == nullptr) {
+  }
+  EXPECT_EQ(thread_pool_current, &thread_pool);
+}
+
+TEST(TaskRunner, ScopedCurrentTaskRunnerNested) {
+  PollingTaskRunner first(GetZeroTime);
+  PollingTaskRunner second(GetZeroTime);
+
+  {
+    ScopedCurrentTaskRunner first_scope(&first);
+    EXPECT_EQ(TaskRunner::GetCurrent(), &first);
+    {
+      ScopedCurrentTaskRunner second_scope(&second);
+      EXPECT_EQ(TaskRunner::GetCurrent(), &second);
+    }
+    EXPECT_EQ(TaskRunner::GetCurrent(), &first);
+  }
+  EXPECT_EQ(TaskRunner::GetCurrent(), nullptr);
+}
+
+TEST(TaskRunner, PostTaskWithLocation) {
+  PollingTaskRunner polling(GetZeroTime);
+
+  auto line = 0;
+  const auto expected_line = __LINE__ + 1;
+  polling.PostTask(RST_FROM_HERE, [&line]() {
+    const auto location = ScopedTaskLocation::Get();
+    if (location != nullptr)
+      line = location->line();
+  });
+  polling.RunPendingTasks();
+  EXPECT_EQ(line, expected_line);
+  EXPECT_EQ(ScopedTaskLocation::Get(), nullptr);
+}
+
+TEST(TaskRunner, PostTaskAndReply) {
+  PollingTaskRunner polling(GetZeroTime);
+  ThreadPoolTaskRunner thread_pool(1, GetZeroTime);
+
+  std::atomic<bool> task_done = false;
+  auto reply_done = false;
+  polling.PostTask([&]() {
+    thread_pool.PostTaskAndReply(
+        [&]() {
+          EXPECT_EQ(TaskRunner::GetCurrent(), &thread_pool);
+          task_done = true;
+        },
+        [&]() {
+          EXPECT_EQ(TaskRunner::GetCurrent(), &polling);
+          EXPECT_TRUE(task_done);
+          reply_done = true;
+        });
+  });
+
+  while (!reply_done)
+    polling.RunPendingTasks();
+}
+
+TEST(TaskRunner, PostTaskAndReplyWithResult) {
+  PollingTaskRunner polling(GetZeroTime);
+  ThreadPoolTaskRunner thread_pool(1, GetZeroTime);
+
+  Nullable<std::unique_ptr<int>> result;
+  polling.PostTask([&]() {
+    thread_pool.PostTaskAndReplyWithResult(
+        [input = std::make_unique<int>(41)]() {
+          return std::make_unique<int>(*input + 1);
+        },
+        [&](std::unique_ptr<int> value) {
+          EXPECT_EQ(TaskRunner::GetCurrent(), &polling);
+          result = std::move(value);
+        });
+  });
+
+  while (result == nullptr)
+    polling.RunPendingTasks();
+  EXPECT_EQ(*result, 42);
+}
+
+TEST(TaskRunner, ReplyIsDroppedAfterOriginDestruction) {
+  ThreadPoolTaskRunner thread_pool(1, GetZeroTime);
+
+  std::mutex mtx;
+  std::condition_variable cv;
+  auto task_started = false;
+  auto origin_destroyed = false;
+  std::atomic<bool> task_done = false;
+  auto reply_done = false;
+
+  {
+    PollingTaskRunner polling(GetZeroTime);
+    polling.PostTask([&]() {
+      thread_pool.PostTaskAndReply(
+          [&]() {
+            std::unique_lock lock(mtx);
+            task_started = true;
+            cv.notify_one();
+            while (!origin_destroyed)
+              cv.wait(lock);
+            task_done = true;
+          },
+          [&reply_done]() { reply_done = true; });
+    });
+    polling.RunPendingTasks();
+
+    std::unique_lock lock(mtx);
+    while (!task_started)
+      cv.wait(lock);
+  }
+
+  {
+    std::lock_guard lock(mtx);
+    origin_destroyed = true;
+    cv.notify_one();
+  }
+
+  while (!task_done) {
+  }
+  EXPECT_FALSE(reply_done);
+}
+
+}  // namespace rst
@@ -27,77 +27,431 @@
 
 #include "rst/task_runner/thread_pool_task_runner.h"
 
+#include <algorithm>
+#include <atomic>
 #include <utility>
 
 #include "rst/check/check.h"
 #include "rst/defer/defer.h"
+#include "rst/macros/optimization.h"
 #include "rst/stl/algorithm.h"
 
 namespace chrono = std::chrono;
 
 namespace rst {
+namespace {
+
+std::atomic<size_t> g_delayed_shard_seed = 0;
+
+// Spreads posting threads over the delayed task shards.
+thread_local const size_t t_delayed_shard_seed = g_delayed_shard_seed++;
+
+}  // namespace
+
+namespace internal {
+
+chrono::nanoseconds GetSpinTime(const chrono::nanoseconds average_idle_time,
+                                const chrono::nanoseconds max_spin_time) {
+  if (average_idle_time > max_spin_time)
+    return chrono::nanoseconds::zero();
+  // Covers most of the intervals around the average one.
+  return std::min(average_idle_time * 2, max_spin_time);
+}
+
+chrono::nanoseconds UpdateAverageIdleTime(
+    const chrono::nanoseconds average_idle_time,
+    const chrono::nanoseconds idle_time,
+    const chrono::nanoseconds max_spin_time) {
+  const auto clamped_idle_time = std::min(idle_time, max_spin_time * 2);
+  return average_idle_time + (clamped_idle_time - average_idle_time) / 4;
+}
+
+}  // namespace internal
 
 ThreadPoolTaskRunner::InternalTaskRunner::InternalTaskRunner(
-    std::function<chrono::milliseconds()>&& time_function)
-    : time_function_(std::move(time_function)) {}
+    std::function<chrono::milliseconds()>&& time_function,
+    const chrono::milliseconds timer_slack, const size_t threads_num,
+    const size_t delayed_shards_num)
+    : time_function_(std::move(time_function)),
+      timer_slack_(timer_slack),
+      delayed_shards_num_(delayed_shards_num),
+      delayed_shards_(std::make_unique<DelayedShard[]>(delayed_shards_num)),
+      next_delayed_time_(chrono::milliseconds::max().count()),
+      wake_up_times_(threads_num, chrono::milliseconds::min()) {
+  RST_DCHECK(timer_slack_.count() >= 0);
+  RST_DCHECK(delayed_shards_num_ > 0);
+}
 
 ThreadPoolTaskRunner::InternalTaskRunner::~InternalTaskRunner() = default;
 
-void ThreadPoolTaskRunner::InternalTaskRunner::WaitAndRunTasks() {
+void ThreadPoolTaskRunner::InternalTaskRunner::WaitAndRunTasks(
+    const NotNull<TaskRunner*> task_runner, const size_t thread_index) {
+  ScopedCurrentTaskRunner scoped_current(task_runner);
   std::function<void()> task;
+  std::function<void(chrono::milliseconds)> idle_task;
+  auto idle_budget = chrono::milliseconds::zero();
   RST_DEFER([this]() { thread_cv_.notify_one(); });
 
+  // Spinning state. The idle time is the interval between getting idle and
+  // getting a task.
+  auto is_idle = false;
+  auto is_spinning = false;
+  auto has_spun = false;
+  chrono::steady_clock::time_point idle_start;
+  auto average_idle_time = chrono::nanoseconds::zero();
+
   while (true) {
     {
       std::unique_lock lock(thread_mutex_);
+      // Decremented under the lock, so a poster that hasn't woken up a thread
+      // because of spinning pushed the task before the check below.
+      const auto was_spinning = is_spinning;
+      if (is_spinning) {
+        spinning_threads_num_--;
+        is_spinning = false;
+      }
 
-      if (should_exit_)
+      // Tasks already moved to the task sources are run before exiting.
+      if (should_exit_ && due_tasks_num_ == 0)
         return;
 
-      if (!queue_.empty()) {
-        const auto& item = queue_.front();
-        const auto now = time_function_();
-        if (now < item.time_point) {
-          const auto wait_duration = item.time_point - now;
-          thread_cv_.wait_for(lock, wait_duration);
+      const auto now = time_function_();
+      if (chrono::milliseconds(next_delayed_time_) <= now)
+        MoveDelayedTasks(now);
+      if (fair_scheduling_)
+        MoveDueTasksToSources(now);
+      auto budget = chrono::milliseconds::zero();
+      if (due_tasks_num_ == 0) {
+        budget = internal::GetIdleBudget(queue_, now);
+        const chrono::milliseconds next_delayed_time(next_delayed_time_);
+        if (next_delayed_time != chrono::milliseconds::max())
+          budget = std::min(budget, next_delayed_time - now);
+      }
+      if (budget.count() == 0) {
+        task = PopNextTask();
+        if (blocked_posters_num_ != 0)
+          poster_cv_.notify_one();
+        if (was_spinning)
+          queue_stats_.spin_hits++;
+        if (is_idle) {
+          is_idle = false;
+          average_idle_time = internal::UpdateAverageIdleTime(
+              average_idle_time, chrono::steady_clock::now() - idle_start,
+              max_spin_time_);
+          has_spun = false;
         }
+        // The posters may have relied on this thread to take their tasks.
+        WakeUpPeerIfNeeded(now);
+      } else if (!idle_queue_.empty()) {
+        idle_task = std::move(idle_queue_.front());
+        idle_queue_.pop_front();
+        idle_budget = budget;
+        WakeUpPeerIfNeeded(now);
       } else {
-        thread_cv_.wait(lock);
+        if (max_spin_time_.count() != 0 && !is_idle) {
+          is_idle = true;
+          idle_start = chrono::steady_clock::now();
+          if (average_idle_time.count() == 0)
+            average_idle_time = max_spin_time_ / 2;
+        }
+        if (is_idle && !has_spun) {
+          has_spun = true;
+          const auto spin_time =
+              internal::GetSpinTime(average_idle_time, max_spin_time_);
+          if (spin_time.count() != 0) {
+            spinning_threads_num_++;
+            is_spinning = true;
+            const uint64_t task_id = task_id_;
+            const chrono::milliseconds::rep next_delayed_time =
+                next_delayed_time_;
+            lock.unlock();
+            SpinForTask(task_id, next_delayed_time, spin_time);
+            continue;
+          }
+        }
+
+        const auto next_time = GetNextTime();
+        auto& wake_up_time = wake_up_times_[thread_index];
+        if (next_time != chrono::milliseconds::max()) {
+          wake_up_time = GetWakeUpTime(next_time);
+          thread_cv_.wait_for(lock, wake_up_time - now);
+        } else {
+          wake_up_time = chrono::milliseconds::max();
+          thread_cv_.wait(lock);
+        }
+        wake_up_time = chrono::milliseconds::min();
+        continue;
       }
+    }
+
+    if (task != nullptr) {
+      task();
+      task = nullptr;
+    } else {
+      idle_task(idle_budget);
+      idle_task = nullptr;
+    }
+  }
+}
+
+chrono::milliseconds ThreadPoolTaskRunner::InternalTaskRunner::GetWakeUpTime(
+    const chrono::milliseconds time_point) const {
+  if (timer_slack_.count() == 0)
+    return time_point;
 
-      if (should_exit_)
+  auto remainder = time_point % timer_slack_;
+  if (remainder.count() < 0)
+    remainder += timer_slack_;
+  if (remainder.count() == 0)
+    return time_point;
+  return time_point - remainder + timer_slack_;
+}
+
+void ThreadPoolTaskRunner::InternalTaskRunner::WakeUpThread() {
+  if (spinning_threads_num_ == 0)
+    thread_cv_.notify_one();
+}
+
+void ThreadPoolTaskRunner::InternalTaskRunner::WakeUpPeerIfNeeded(
+    const chrono::milliseconds now) {
+  const auto next_time = due_tasks_num_ != 0 ? now : GetNextTime();
+  if (next_time == chrono::milliseconds::max())
+    return;
+
+  const auto next_wake_up_time =
+      next_time <= now ? now : GetWakeUpTime(next_time);
+  auto has_sleeping_threads = false;
+  for (const auto wake_up_time : wake_up_times_) {
+    if (wake_up_time == chrono::milliseconds::min())
+      continue;
+    // The thread runs the next task or goes to sleep until it.
+    if (wake_up_time <= next_wake_up_time)
+      return;
+    has_sleeping_threads = true;
+  }
+
+  if (has_sleeping_threads)
+    WakeUpThread();
+}
+
+void ThreadPoolTaskRunner::InternalTaskRunner::SpinForTask(
+    const uint64_t task_id, const chrono::milliseconds::rep next_delayed_time,
+    const chrono::nanoseconds spin_time) {
+  // Reading the clock is much slower than a pause.
+  static constexpr auto kSpinsPerClockRead = 64;
+
+  const auto spin_end = chrono::steady_clock::now() + spin_time;
+  while (true) {
+    for (auto i = 0; i < kSpinsPerClockRead; i++) {
+      if (task_id_.load(std::memory_order_relaxed) != task_id ||
+          next_delayed_time_.load(std::memory_order_relaxed) !=
+              next_delayed_time) {
         return;
+      }
+      RST_CPU_RELAX();
+    }
+    if (chrono::steady_clock::now() >= spin_end)
+      return;
+  }
+}
 
-      if (queue_.empty())
-        continue;
+bool ThreadPoolTaskRunner::InternalTaskRunner::PostToDelayedShard(
+    internal::Item&& item) {
+  const auto time_point = item.time_point;
+  auto& shard = delayed_shards_[t_delayed_shard_seed % delayed_shards_num_];
+  {
+    std::lock_guard lock(shard.mutex);
+    shard.queue.emplace_back(std::move(item));
+    c_push_heap(shard.queue, std::greater<>());
+  }
 
-      auto& item = queue_.front();
-      const auto now = time_function_();
-      if (now < item.time_point)
-        continue;
+  const auto previous_time = LowerNextDelayedTime(time_point);
+  if (time_point >= previous_time)
+    return false;
+  if (previous_time != chrono::milliseconds::max() &&
+      GetWakeUpTime(time_point) >= GetWakeUpTime(previous_time)) {
+    return false;
+  }
+
+  // A thread may have read the previous time and not be waiting yet.
+  std::lock_guard lock(thread_mutex_);
+  return true;
+}
+
+void ThreadPoolTaskRunner::InternalTaskRunner::MoveDelayedTasks(
+    const chrono::milliseconds now) {
+  // Posters lower the time after pushing to a shard, so the time pushed after
+  // a shard is visited below is not lost.
+  next_delayed_time_ = chrono::milliseconds::max().count();
+  for (size_t i = 0; i < delayed_shards_num_; i++) {
+    auto& shard = delayed_shards_[i];
+    std::lock_guard lock(shard.mutex);
+    auto& shard_queue = shard.queue;
+    while (!shard_queue.empty()) {
+      auto& item = shard_queue.front();
+      if (now < item.time_point) {
+        LowerNextDelayedTime(item.time_point);
+        break;
+      }
 
-      task = std::move(item.task);
-      c_pop_heap(queue_, std::greater<>());
-      queue_.pop_back();
+      queue_.emplace_back(std::move(item));
+      c_push_heap(queue_, std::greater<>());
+      c_pop_heap(shard_queue, std::greater<>());
+      shard_queue.pop_back();
     }
+  }
+}
+
+chrono::milliseconds
+ThreadPoolTaskRunner::InternalTaskRunner::LowerNextDelayedTime(
+    const chrono::milliseconds time_point) {
+  auto previous = next_delayed_time_.load();
+  while (time_point.count() < previous &&
+         !next_delayed_time_.compare_exchange_weak(previous,
+                                                   time_point.count())) {
+  }
+  return chrono::milliseconds(previous);
+}
+
+chrono::milliseconds ThreadPoolTaskRunner::InternalTaskRunner::GetNextTime()
+    const {
+  const chrono::milliseconds next_delayed_time(next_delayed_time_);
+  if (queue_.empty())
+    return next_delayed_time;
+  return std::min(queue_.front().time_point, next_delayed_time);
+}
 
-    task();
-    task = nullptr;
+void ThreadPoolTaskRunner::InternalTaskRunner::MoveDueTasksToSources(
+    const chrono::milliseconds now) {
+  while (!queue_.empty()) {
+    auto& item = queue_.front();
+    if (now < item.time_point)
+      break;
+
+    const auto it = sources_.find(item.source_id);
+    RST_DCHECK(it != sources_.end());
+    auto& source = it->second;
+    if (source.tasks.empty())
+      active_sources_.emplace_back(item.source_id);
+    source.tasks.emplace_back(std::move(item.task));
+    due_tasks_num_++;
+
+    c_pop_heap(queue_, std::greater<>());
+    queue_.pop_back();
   }
 }
 
+std::function<void()> ThreadPoolTaskRunner::InternalTaskRunner::PopNextTask() {
+  if (due_tasks_num_ == 0) {
+    RST_DCHECK(!queue_.empty());
+    auto task = std::move(queue_.front().task);
+    const auto source_id = queue_.front().source_id;
+    c_pop_heap(queue_, std::greater<>());
+    queue_.pop_back();
+    OnSourceTaskTaken(source_id);
+    return task;
+  }
+
+  RST_DCHECK(!active_sources_.empty());
+  const auto source_id = active_sources_.front();
+  const auto it = sources_.find(source_id);
+  RST_DCHECK(it != sources_.end());
+  auto& source = it->second;
+  RST_DCHECK(!source.tasks.empty());
+
+  if (source.deficit == 0)
+    source.deficit = source.weight;
+  source.deficit--;
+
+  auto task = std::move(source.tasks.front());
+  source.tasks.pop_front();
+  due_tasks_num_--;
+
+  if (source.tasks.empty()) {
+    source.deficit = 0;
+    active_sources_.pop_front();
+  } else if (source.deficit == 0) {
+    active_sources_.pop_front();
+    active_sources_.emplace_back(source_id);
+  }
+
+  OnSourceTaskTaken(source_id);
+  return task;
+}
+
+void ThreadPoolTaskRunner::InternalTaskRunner::OnSourceTaskTaken(
+    const uint64_t source_id) {
+  if (source_id == 0)
+    return;
+
+  const auto it = sources_.find(source_id);
+  RST_DCHECK(it != sources_.end());
+  auto& source = it->second;
+  RST_DCHECK(source.pending_tasks_num != 0);
+  // The delayed tasks of a destroyed source keep its weight.
+  if (--source.pending_tasks_num == 0 && !source.is_alive)
+    sources_.erase(it);
+}
+
+class ThreadPoolTaskRunner::TaskSource : public TaskRunner {
+ public:
+  // |source| stays in place until the TaskSource is destroyed.
+  TaskSource(const NotNull<ThreadPoolTaskRunner*> task_runner,
+             const NotNull<InternalTaskRunner::Source*> source)
+      : task_runner_(task_runner), source_(source) {}
+
+  ~TaskSource() override {
+    InvalidateReplies();
+
+    auto& internal = *task_runner_->task_runner_;
+    std::lock_guard lock(internal.thread_mutex_);
+    // Otherwise the source is erased when its last task is taken.
+    if (source_->pending_tasks_num != 0)
+      source_->is_alive = false;
+    else
+      internal.sources_.erase(source_->id);
+  }
+
+  // TaskRunner:
+  void PostDelayedTask(std::function<void()>&& task,
+                       const chrono::milliseconds delay) override {
+    task_runner_->TryPostDelayedTaskFromSource(source_, std::move(task), delay,
+                                               false)
+        .Ignore();
+  }
+  void PostDelayedTaskOverCapacity(std::function<void()>&& task,
+                                   const chrono::milliseconds delay) override {
+    task_runner_->TryPostDelayedTaskFromSource(source_, std::move(task), delay,
+                                               true)
+        .Ignore();
+  }
+
+ private:
+  const NotNull<ThreadPoolTaskRunner*> task_runner_;
+  const NotNull<InternalTaskRunner::Source*> source_;
+
+  RST_DISALLOW_COPY_AND_ASSIGN(TaskSource);
+};
+
 ThreadPoolTaskRunner::ThreadPoolTaskRunner(
     const size_t threads_num,
-    std::function<chrono::milliseconds()>&& time_function)
-    : task_runner_(
-          std::make_shared<InternalTaskRunner>(std::move(time_function))) {
+    std::function<chrono::milliseconds()>&& time_function,
+    const chrono::milliseconds timer_slack)
+    : task_runner_(std::make_shared<InternalTaskRunner>(
+          std::move(time_function), timer_slack, threads_num,
+          std::max<size_t>(threads_num,
+                           std::thread::hardware_concurrency()))) {
   RST_DCHECK(threads_num > 0);
   threads_.reserve(threads_num);
   for (size_t i = 0; i < threads_num; i++)
-    threads_.emplace_back(&InternalTaskRunner::WaitAndRunTasks, task_runner_);
+    threads_.emplace_back(&InternalTaskRunner::WaitAndRunTasks, task_runner_,
+                          this, i);
 }
 
 ThreadPoolTaskRunner::~ThreadPoolTaskRunner() {
+  // The ending task below must not be rejected or dropped.
+  SetCapacity(0, OverflowPolicy::kBlock);
+
   {
     std::mutex ending_task_mutex;
     std::condition_variable ending_task_cv;
@@ -114,6 +468,8 @@ ThreadPoolTaskRunner::~ThreadPoolTaskRunner() {
       ending_task_cv.wait(lock);
   }
 
+  InvalidateReplies();
+
   {
     std::lock_guard lock(task_runner_->thread_mutex_);
     task_runner_->should_exit_ = true;
@@ -126,17 +482,173 @@ ThreadPoolTaskRunner::~ThreadPoolTaskRunner() {
 
 void ThreadPoolTaskRunner::PostDelayedTask(std::function<void()>&& task,
                                            const chrono::milliseconds delay) {
+  TryPostDelayedTask(std::move(task), delay).Ignore();
+}
+
+void ThreadPoolTaskRunner::PostDelayedTaskOverCapacity(
+    std::function<void()>&& task, const chrono::milliseconds delay) {
+  TryPostDelayedTaskFromSource(nullptr, std::move(task), delay, true).Ignore();
+}
+
+Status ThreadPoolTaskRunner::TryPostDelayedTask(
+    std::function<void()>&& task, const chrono::milliseconds delay) {
+  return TryPostDelayedTaskFromSource(nullptr, std::move(task), delay, false);
+}
+
+Status ThreadPoolTaskRunner::TryPostDelayedTaskFromSource(
+    const Nullable<InternalTaskRunner::Source*> source,
+    std::function<void()>&& task, const chrono::milliseconds delay,
+    const bool over_capacity) {
   RST_DCHECK(delay.count() >= 0);
 
-  const auto now = task_runner_->time_function_();
-  const auto future_time_point = now + delay;
+  uint64_t source_id = 0;
+  if (source != nullptr)
+    source_id = source->id;
+
+  if (delay.count() != 0 && task_runner_->capacity_ == 0) {
+    // Counted before the task can be taken.
+    if (source != nullptr)
+      source->pending_tasks_num++;
+    const auto future_time_point = task_runner_->time_function_() + delay;
+    if (task_runner_->PostToDelayedShard(
+            internal::Item(std::move(task), future_time_point,
+                           task_runner_->task_id_++, source_id))) {
+      task_runner_->WakeUpThread();
+    }
+    return Status::OK();
+  }
+
+  // Destroyed out of the lock.
+  std::function<void()> dropped_task;
+  auto should_notify = delay.count() == 0;
+  {
+    std::unique_lock lock(task_runner_->thread_mutex_);
+    auto& queue = task_runner_->queue_;
+    const size_t capacity = task_runner_->capacity_;
+    if (capacity != 0 && !over_capacity &&
+        task_runner_->GetQueuedTasksNum() >= capacity) {
+      auto& stats = task_runner_->queue_stats_;
+      switch (task_runner_->overflow_policy_) {
+        case OverflowPolicy::kBlock: {
+          if (GetCurrent() == this)
+            break;
+
+          stats.blocked++;
+          task_runner_->blocked_posters_num_++;
+          while (task_runner_->capacity_ != 0 &&
+                 task_runner_->GetQueuedTasksNum() >= task_runner_->capacity_) {
+            task_runner_->poster_cv_.wait(lock);
+          }
+          task_runner_->blocked_posters_num_--;
+          break;
+        }
+        case OverflowPolicy::kReject: {
+          stats.rejected++;
+          return MakeStatus<QueueFullError>();
+        }
+        case OverflowPolicy::kDropOldest: {
+          stats.dropped++;
+          dropped_task = task_runner_->PopNextTask();
+          break;
+        }
+        case OverflowPolicy::kRunOnCaller: {
+          stats.run_on_caller++;
+          lock.unlock();
+          task();
+          return Status::OK();
+        }
+      }
+    }
+
+    const auto now = task_runner_->time_function_();
+    const auto future_time_point = now + delay;
+    // Idle threads already sleep until the wakeup of the first task. Waking
+    // them up for a later one would only make them go to sleep again.
+    if (!should_notify) {
+      const auto next_time = task_runner_->GetNextTime();
+      should_notify = next_time == chrono::milliseconds::max() ||
+                      task_runner_->GetWakeUpTime(future_time_point) <
+                          task_runner_->GetWakeUpTime(next_time);
+    }
+
+    if (source != nullptr)
+      source->pending_tasks_num++;
+    queue.emplace_back(std::move(task), future_time_point,
+                       task_runner_->task_id_++, source_id);
+    c_push_heap(queue, std::greater<>());
+  }
+
+  if (should_notify)
+    task_runner_->WakeUpThread();
+  return Status::OK();
+}
+
+void ThreadPoolTaskRunner::SetCapacity(const size_t capacity,
+                                       const OverflowPolicy policy) {
+  {
+    std::lock_guard lock(task_runner_->thread_mutex_);
+    task_runner_->capacity_ = capacity;
+    task_runner_->overflow_policy_ = policy;
+    // Counts the sharded tasks against the limit.
+    if (capacity != 0)
+      task_runner_->MoveDelayedTasks(chrono::milliseconds::max());
+  }
+  task_runner_->poster_cv_.notify_all();
+}
+
+NotNull<std::unique_ptr<TaskRunner>> ThreadPoolTaskRunner::CreateTaskSource(
+    const uint32_t weight) {
+  RST_DCHECK(weight > 0);
+
+  InternalTaskRunner::Source* source = nullptr;
   {
     std::lock_guard lock(task_runner_->thread_mutex_);
-    task_runner_->queue_.emplace_back(std::move(task), future_time_point,
-                                      task_runner_->task_id_++);
-    c_push_heap(task_runner_->queue_, std::greater<>());
+    auto& sources = task_runner_->sources_;
+    // The source zero of the tasks posted directly is never destroyed.
+    if (!task_runner_->fair_scheduling_) {
+      task_runner_->fair_scheduling_ = true;
+      sources.try_emplace(0);
+    }
+
+    const auto source_id = task_runner_->source_id_++;
+    source = &sources.try_emplace(source_id).first->second;
+    source->id = source_id;
+    source->weight = weight;
+  }
+
+  return std::make_unique<TaskSource>(this, source);
+}
+
+ThreadPoolTaskRunner::QueueStats ThreadPoolTaskRunner::GetQueueStats() const {
+  std::lock_guard lock(task_runner_->thread_mutex_);
+  return task_runner_->queue_stats_;
+}
+
+void ThreadPoolTaskRunner::PostIdleTask(
+    std::function<void(chrono::milliseconds)>&& task) {
+  {
+    std::lock_guard lock(task_runner_->thread_mutex_);
+    task_runner_->idle_queue_.emplace_back(std::move(task));
   }
   task_runner_->thread_cv_.notify_one();
 }
 
+void ThreadPoolTaskRunner::SetMaxSpinTime(
+    const chrono::microseconds max_spin_time) {
+  RST_DCHECK(max_spin_time.count() >= 0);
+  std::lock_guard lock(task_runner_->thread_mutex_);
+  // Spinning would only take the CPU from the thread posting the task.
+  if (std::thread::hardware_concurrency() <= 1)
+    return;
+  task_runner_->max_spin_time_ = max_spin_time;
+}
+
+char QueueFullError::id_ = '\0';
+
+QueueFullError::QueueFullError() : message_("Task queue is full") {}
+
+QueueFullError::~QueueFullError() = default;
+
+const std::string& QueueFullError::AsString() const { return message_; }
+
 }  // namespace rst
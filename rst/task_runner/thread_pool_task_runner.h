@@ -28,22 +28,44 @@
 #ifndef RST_TASK_RUNNER_THREAD_POOL_TASK_RUNNER_H_
 #define RST_TASK_RUNNER_THREAD_POOL_TASK_RUNNER_H_
 
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include "rst/macros/macros.h"
+#include "rst/macros/optimization.h"
 #include "rst/not_null/not_null.h"
+#include "rst/status/status.h"
 #include "rst/task_runner/item.h"
 #include "rst/task_runner/task_runner.h"
 
 namespace rst {
+namespace internal {
+
+// Returns the time for an idle thread of ThreadPoolTaskRunner to spin with
+// |average_idle_time| as the average interval between getting idle and
+// getting a task, zero if it's longer than |max_spin_time|.
+std::chrono::nanoseconds GetSpinTime(std::chrono::nanoseconds average_idle_time,
+                                     std::chrono::nanoseconds max_spin_time);
+
+// Returns |average_idle_time| updated with the latest |idle_time|. Long
+// intervals are clamped, so a few short ones enable spinning again.
+std::chrono::nanoseconds UpdateAverageIdleTime(
+    std::chrono::nanoseconds average_idle_time,
+    std::chrono::nanoseconds idle_time,
+    std::chrono::nanoseconds max_spin_time);
+
+}  // namespace internal
 
 // Task runner that is supposed to run tasks on dedicated threads.
 //
@@ -57,54 +79,310 @@ namespace rst {
 //   task_runner.PostTask(std::move(task));
 //   ...
 //
+// With a non-zero |timer_slack| delayed tasks may run up to |timer_slack| late:
+// the threads sleep until the deadline rounded up to a multiple of
+// |timer_slack|, so timers with close deadlines are run after one wakeup.
+// Tasks without a delay are not affected.
+//
+//   ThreadPoolTaskRunner task_runner(threads_num, std::move(time_function),
+//                                    std::chrono::milliseconds(10));
+//
+// Idle tasks run only when no regular tasks are due. They get the time left
+// until the next delayed task as a budget:
+//
+//   task_runner.PostIdleTask([](std::chrono::milliseconds budget) {
+//     ...
+//   });
+//
+// The queue is unbounded by default. A capacity makes the task runner degrade
+// gracefully under overload according to the policy instead of growing the
+// queue without limit:
+//
+//   task_runner.SetCapacity(1000,
+//                           ThreadPoolTaskRunner::OverflowPolicy::kReject);
+//   Status status = task_runner.TryPostTask(std::move(task));
+//   if (status.err()) {
+//     // status.GetError()->IsA<QueueFullError>() is true.
+//     ...
+//   }
+//
+// Task sources let tenants share the threads fairly. Due tasks of different
+// sources are run in weighted round robin, so a burst of one tenant doesn't
+// delay the tasks of the others until the burst is over:
+//
+//   NotNull<std::unique_ptr<TaskRunner>> heavy_tenant =
+//       task_runner.CreateTaskSource(1);
+//   NotNull<std::unique_ptr<TaskRunner>> light_tenant =
+//       task_runner.CreateTaskSource(1);
+//   heavy_tenant->PostTask(...);
+//
+// Idle threads can spin for a while before going to sleep, so a task posted
+// right after the queue gets empty doesn't pay for a thread wakeup:
+//
+//   task_runner.SetMaxSpinTime(std::chrono::microseconds(50));
+//
 class ThreadPoolTaskRunner : public TaskRunner {
  public:
+  // What to do with a task posted to the queue at capacity.
+  enum class OverflowPolicy {
+    // Blocks the poster until there is room in the queue. Tasks posted from
+    // the threads of the task runner are queued over capacity to not to
+    // deadlock.
+    kBlock,
+    // Drops the task. TryPostDelayedTask() returns QueueFullError.
+    kReject,
+    // Drops the queued task that would run next to make room.
+    kDropOldest,
+    // Runs the task on the posting thread right away, even a delayed one.
+    kRunOnCaller,
+  };
+
+  // Counters of the overflow policy actions and of spinning.
+  struct QueueStats {
+    // Posts that waited for room with OverflowPolicy::kBlock.
+    uint64_t blocked = 0;
+    // Tasks dropped by OverflowPolicy::kReject.
+    uint64_t rejected = 0;
+    // Tasks dropped by OverflowPolicy::kDropOldest.
+    uint64_t dropped = 0;
+    // Tasks run on the posting thread by OverflowPolicy::kRunOnCaller.
+    uint64_t run_on_caller = 0;
+    // Tasks taken by threads right after spinning, without a wakeup.
+    uint64_t spin_hits = 0;
+  };
+
   // Takes |time_function| that returns current time and creates |threads_num|
   // threads.
   ThreadPoolTaskRunner(
       size_t threads_num,
-      std::function<std::chrono::milliseconds()>&& time_function);
+      std::function<std::chrono::milliseconds()>&& time_function,
+      std::chrono::milliseconds timer_slack = std::chrono::milliseconds(0));
   ~ThreadPoolTaskRunner() override;
 
   // TaskRunner:
   void PostDelayedTask(std::function<void()>&& task,
                        std::chrono::milliseconds delay) override;
+  void PostDelayedTaskOverCapacity(std::function<void()>&& task,
+                                   std::chrono::milliseconds delay) override;
+
+  // Like PostDelayedTask(), but returns QueueFullError if the queue is at
+  // capacity and the task is rejected by OverflowPolicy::kReject.
+  Status TryPostDelayedTask(std::function<void()>&& task,
+                            std::chrono::milliseconds delay);
+
+  // Like PostTask(), but returns QueueFullError if the task is rejected.
+  Status TryPostTask(std::function<void()>&& task) {
+    return TryPostDelayedTask(std::move(task),
+                              std::chrono::milliseconds::zero());
+  }
+
+  // Limits the number of queued tasks to |capacity| applying |policy| to the
+  // tasks posted to the full queue. Idle tasks aren't counted, tasks posted
+  // with PostDelayedTaskOverCapacity() are counted but always queued. Zero
+  // |capacity| means no limit, which is the default.
+  void SetCapacity(size_t capacity, OverflowPolicy policy);
+
+  QueueStats GetQueueStats() const;
+
+  // Creates a task source with |weight| > 0. While several sources have due
+  // tasks, the threads take up to |weight| tasks of a source per round
+  // (deficit round robin with unit cost). Tasks posted to this task runner
+  // directly belong to a source with weight 1. Tasks of a source are started
+  // in order. The source must not outlive this task runner, its pending tasks
+  // are run after its destruction.
+  NotNull<std::unique_ptr<TaskRunner>> CreateTaskSource(uint32_t weight);
+
+  // Posts |task| to be run when no regular tasks are due. The |task| gets the
+  // time left until the next delayed task or std::chrono::milliseconds::max()
+  // if there are no such tasks. Idle tasks are started in order. Pending idle
+  // tasks are dropped on destruction.
+  void PostIdleTask(std::function<void(std::chrono::milliseconds)>&& task);
+
+  // Makes idle threads spin for up to |max_spin_time| waiting for a new task
+  // before going to sleep. A thread spins only while the recent intervals
+  // between it getting idle and getting a task are shorter than
+  // |max_spin_time|, so rare tasks don't burn CPU. Spinning is disabled on
+  // single core machines. Zero |max_spin_time| means no spinning, which is the
+  // default.
+  void SetMaxSpinTime(std::chrono::microseconds max_spin_time);
 
   size_t threads_num() const { return threads_.size(); }
 
  private:
+  class TaskSource;
+
   class InternalTaskRunner {
    public:
-    explicit InternalTaskRunner(
-        std::function<std::chrono::milliseconds()>&& time_function);
+    InternalTaskRunner(
+        std::function<std::chrono::milliseconds()>&& time_function,
+        std::chrono::milliseconds timer_slack, size_t threads_num,
+        size_t delayed_shards_num);
     ~InternalTaskRunner();
 
-    // Worker method.
-    void WaitAndRunTasks();
+    // Worker method of the thread with |thread_index|. Runs tasks with
+    // |task_runner| as the current task runner.
+    void WaitAndRunTasks(NotNull<TaskRunner*> task_runner,
+                         size_t thread_index);
+
+    // Returns |time_point| rounded up to a multiple of |timer_slack_|.
+    std::chrono::milliseconds GetWakeUpTime(
+        std::chrono::milliseconds time_point) const;
+
+    // Pushes |item| to the delayed task shard of the calling thread. Returns
+    // true if the threads have to be woken up.
+    bool PostToDelayedShard(internal::Item&& item);
+
+    // Moves the sharded delayed tasks due at |now| to |queue_|.
+    void MoveDelayedTasks(std::chrono::milliseconds now);
+
+    // Lowers |next_delayed_time_| to |time_point|. Returns the previous value.
+    std::chrono::milliseconds LowerNextDelayedTime(
+        std::chrono::milliseconds time_point);
+
+    // Returns the earliest time point of the queued tasks or
+    // std::chrono::milliseconds::max() if there are no such tasks.
+    std::chrono::milliseconds GetNextTime() const;
+
+    // Moves the tasks due at |now| to their task sources.
+    void MoveDueTasksToSources(std::chrono::milliseconds now);
+
+    // Removes and returns the task to run next.
+    std::function<void()> PopNextTask();
+
+    // Counts a task of the source with |source_id| as taken. Erases the source
+    // if it has been destroyed and has no tasks left.
+    void OnSourceTaskTaken(uint64_t source_id);
+
+    // Wakes up a sleeping thread unless a thread spins and takes the task.
+    void WakeUpThread();
+
+    // Called by a thread that leaves the wait to run a task. Wakes up a
+    // sleeping thread if none of them would wake up in time for the next
+    // queued task, so a long task doesn't hold back the later ones.
+    void WakeUpPeerIfNeeded(std::chrono::milliseconds now);
+
+    // Spins for up to |spin_time| while |task_id_| and |next_delayed_time_|
+    // don't change.
+    void SpinForTask(uint64_t task_id,
+                     std::chrono::milliseconds::rep next_delayed_time,
+                     std::chrono::nanoseconds spin_time);
+
+    // Returns the number of tasks counted against |capacity_|.
+    size_t GetQueuedTasksNum() const {
+      return queue_.size() + due_tasks_num_;
+    }
 
     std::condition_variable thread_cv_;
     std::mutex thread_mutex_;
 
+    // Wakes up the posters blocked by OverflowPolicy::kBlock.
+    std::condition_variable poster_cv_;
+    size_t blocked_posters_num_ = 0;
+
     // Returns current time.
     const std::function<std::chrono::milliseconds()> time_function_;
 
+    const std::chrono::milliseconds timer_slack_;
+
     // Priority queue of tasks.
     std::vector<internal::Item> queue_;
 
-    // Increasing task counter.
-    uint64_t task_id_ = 0;
+    // Queue of idle tasks.
+    std::deque<std::function<void(std::chrono::milliseconds)>> idle_queue_;
+
+    // Increasing task counter. Spinning threads watch it for new tasks.
+    std::atomic<uint64_t> task_id_ = 0;
+
+    // Delayed tasks are pushed to the shard of the posting thread, so posters
+    // don't contend on |thread_mutex_|. The threads move them to |queue_| when
+    // they are due.
+    struct RST_CACHELINE_ALIGNED DelayedShard {
+      std::mutex mutex;
+      // Priority queue of tasks.
+      std::vector<internal::Item> queue;
+    };
+    const size_t delayed_shards_num_;
+    const std::unique_ptr<DelayedShard[]> delayed_shards_;
+    // A lower bound of the time points in |delayed_shards_|, as
+    // std::chrono::milliseconds::rep.
+    RST_CACHELINE_ALIGNED std::atomic<std::chrono::milliseconds::rep>
+        next_delayed_time_;
+
+    // Zero means no limit. Delayed tasks aren't sharded with a limit.
+    std::atomic<size_t> capacity_ = 0;
+    OverflowPolicy overflow_policy_ = OverflowPolicy::kBlock;
+    QueueStats queue_stats_;
+
+    // Due tasks of a task source.
+    struct Source {
+      uint64_t id = 0;
+      std::deque<std::function<void()>> tasks;
+      uint32_t weight = 1;
+      // Tasks the source can still run in the current round.
+      uint32_t deficit = 0;
+      // Posted tasks not taken yet, including |tasks|. Incremented by the
+      // posters without |thread_mutex_|. Not counted for the source zero.
+      std::atomic<size_t> pending_tasks_num = 0;
+      // False when the TaskSource has been destroyed.
+      bool is_alive = true;
+    };
+
+    // Set by the first CreateTaskSource() call, which also adds the source
+    // zero. Until then due tasks are run right from |queue_|.
+    bool fair_scheduling_ = false;
+    std::unordered_map<uint64_t, Source> sources_;
+    // Round robin of the sources with due tasks.
+    std::deque<uint64_t> active_sources_;
+    size_t due_tasks_num_ = 0;
+    // Zero is the source of tasks posted to ThreadPoolTaskRunner directly.
+    uint64_t source_id_ = 1;
+
+    // Zero means no spinning.
+    std::chrono::nanoseconds max_spin_time_ = std::chrono::nanoseconds::zero();
+    // Posters don't wake up sleeping threads while some threads spin.
+    std::atomic<size_t> spinning_threads_num_ = 0;
+
+    // The time each thread sleeps until by thread index,
+    // std::chrono::milliseconds::max() for a sleep without a timeout and
+    // std::chrono::milliseconds::min() for a thread that doesn't sleep.
+    std::vector<std::chrono::milliseconds> wake_up_times_;
 
     bool should_exit_ = false;
 
     RST_DISALLOW_COPY_AND_ASSIGN(InternalTaskRunner);
   };
 
+  // Posts |task| of |source|, or of the tasks posted directly if |source| is
+  // null. Applies the overflow policy unless |over_capacity|.
+  Status TryPostDelayedTaskFromSource(
+      Nullable<InternalTaskRunner::Source*> source,
+      std::function<void()>&& task, std::chrono::milliseconds delay,
+      bool over_capacity);
+
   std::vector<std::thread> threads_;
   const NotNull<std::shared_ptr<InternalTaskRunner>> task_runner_;
 
   RST_DISALLOW_COPY_AND_ASSIGN(ThreadPoolTaskRunner);
 };
 
+// The error returned by ThreadPoolTaskRunner::TryPostDelayedTask() when the
+// task is rejected.
+class QueueFullError : public ErrorInfo<QueueFullError> {
+ public:
+  QueueFullError();
+  ~QueueFullError() override;
+
+  // ErrorInfo:
+  const std::string& AsString() const override;
+
+  static char id_;
+
+ private:
+  const std::string message_;
+
+  RST_DISALLOW_COPY_AND_ASSIGN(QueueFullError);
+};
+
 }  // namespace rst
 
 #endif  // RST_TASK_RUNNER_THREAD_POOL_TASK_RUNNER_H_
@@ -44,6 +44,41 @@
 namespace chrono = std::chrono;
 
 namespace rst {
+namespace {
+
+chrono::milliseconds GetZeroTime() { return chrono::milliseconds(0); }
+
+// Keeps the only thread of a task runner busy until Release() is called.
+class ThreadBlocker {
+ public:
+  explicit ThreadBlocker(const NotNull<ThreadPoolTaskRunner*> task_runner) {
+    task_runner->PostTask([this]() {
+      std::unique_lock lock(mutex_);
+      started_ = true;
+      cv_.notify_all();
+      while (!released_)
+        cv_.wait(lock);
+    });
+
+    std::unique_lock lock(mutex_);
+    while (!started_)
+      cv_.wait(lock);
+  }
+
+  void Release() {
+    std::lock_guard lock(mutex_);
+    released_ = true;
+    cv_.notify_all();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool started_ = false;
+  bool released_ = false;
+};
+
+}  // namespace
 
 TEST(ThreadPoolTaskRunner, IsTaskRunner) {
   const ThreadPoolTaskRunner task_runner(
@@ -149,6 +184,194 @@ TEST(ThreadPoolTaskRunner, PostDelayedTaskInOrder) {
   }
 }
 
+TEST(ThreadPoolTaskRunner, TimerSlack) {
+  std::mutex mtx;
+  std::atomic<int> ms = 0;
+  ThreadPoolTaskRunner task_runner(
+      1, [&ms]() -> chrono::milliseconds { return chrono::milliseconds(ms); },
+      chrono::milliseconds(10000));
+
+  std::string str, expected;
+  for (auto i = 50; i > 0; i--) {
+    task_runner.PostDelayedTask(
+        [i, &mtx, &str]() {
+          std::lock_guard lock(mtx);
+          str += std::to_string(i);
+        },
+        chrono::milliseconds(i));
+  }
+  for (auto i = 1; i <= 50; i++)
+    expected += std::to_string(i);
+
+  // Lets the thread go to sleep.
+  std::this_thread::sleep_for(chrono::milliseconds(20));
+
+  // The deadlines have passed but the thread sleeps until the end of the slack
+  // window.
+  ms = 50;
+  std::this_thread::sleep_for(chrono::milliseconds(20));
+  {
+    std::lock_guard lock(mtx);
+    EXPECT_EQ(str, std::string());
+  }
+
+  // Tasks without a delay wake the thread up immediately and the expired
+  // delayed tasks are run in order on the same wakeup.
+  task_runner.PostTask([&mtx, &str]() {
+    std::lock_guard lock(mtx);
+    str += "|";
+  });
+  expected += "|";
+
+  while (true) {
+    std::lock_guard lock(mtx);
+    if (str == expected)
+      break;
+  }
+}
+
+TEST(ThreadPoolTaskRunner, LongDelayedTaskDoesNotHoldBackLaterOnes) {
+  std::mutex mtx;
+  std::condition_variable cv;
+  auto is_long_task_started = false;
+  auto is_long_task_released = false;
+  auto is_short_task_run = false;
+  std::atomic<int> ms = 0;
+  ThreadPoolTaskRunner task_runner(
+      2, [&ms]() -> chrono::milliseconds { return chrono::milliseconds(ms); });
+
+  task_runner.PostDelayedTask(
+      [&mtx, &cv, &is_long_task_started, &is_long_task_released]() {
+        std::unique_lock lock(mtx);
+        is_long_task_started = true;
+        cv.notify_all();
+        while (!is_long_task_released)
+          cv.wait(lock);
+      },
+      chrono::milliseconds(100));
+  task_runner.PostDelayedTask(
+      [&mtx, &cv, &is_short_task_run]() {
+        std::lock_guard lock(mtx);
+        is_short_task_run = true;
+        cv.notify_all();
+      },
+      chrono::milliseconds(110));
+
+  ms = 100;
+  std::unique_lock lock(mtx);
+  while (!is_long_task_started)
+    cv.wait(lock);
+
+  // The other thread runs the later task while the first one is busy.
+  ms = 110;
+  EXPECT_TRUE(cv.wait_for(lock, chrono::seconds(10), [&is_short_task_run]() {
+    return is_short_task_run;
+  }));
+  is_long_task_released = true;
+  cv.notify_all();
+}
+
+TEST(ThreadPoolTaskRunner, PostIdleTask) {
+  std::mutex mtx;
+  std::atomic<int> ms = 0;
+  ThreadPoolTaskRunner task_runner(
+      1, [&ms]() -> chrono::milliseconds { return chrono::milliseconds(ms); });
+
+  std::string str, expected, idle_expected;
+  std::vector<chrono::milliseconds> budgets;
+  {
+    // Keeps the thread busy while the other tasks are posted.
+    std::lock_guard lock(mtx);
+    task_runner.PostTask([&mtx, &str]() {
+      std::lock_guard lock(mtx);
+      str += "t";
+    });
+    expected += "t";
+
+    for (auto i = 0; i < 10; i++) {
+      task_runner.PostIdleTask(
+          [i, &mtx, &str, &budgets](chrono::milliseconds budget) {
+            std::lock_guard lock(mtx);
+            str += "i" + std::to_string(i);
+            budgets.emplace_back(budget);
+          });
+      idle_expected += "i" + std::to_string(i);
+    }
+
+    for (auto i = 0; i < 10; i++) {
+      task_runner.PostTask([i, &mtx, &str]() {
+        std::lock_guard lock(mtx);
+        str += "t" + std::to_string(i);
+      });
+      expected += "t" + std::to_string(i);
+    }
+    expected += idle_expected;
+
+    task_runner.PostDelayedTask(DoNothing(), chrono::milliseconds(100));
+  }
+
+  while (true) {
+    std::lock_guard lock(mtx);
+    if (str == expected)
+      break;
+  }
+
+  EXPECT_EQ(budgets, std::vector<chrono::milliseconds>(
+                         10, chrono::milliseconds(100)));
+}
+
+TEST(ThreadPoolTaskRunner, PostDelayedTaskConcurrently) {
+  std::mutex mtx;
+  std::atomic<int> ms = 0;
+  ThreadPoolTaskRunner task_runner(
+      2, [&ms]() -> chrono::milliseconds { return chrono::milliseconds(ms); });
+
+  static constexpr int kThreadsNum = 8;
+  static constexpr int kTasksNum = 100;
+  std::vector<int> delays;
+  std::vector<std::thread> threads;
+  threads.reserve(kThreadsNum);
+  for (auto i = 0; i < kThreadsNum; i++) {
+    threads.emplace_back([i, &task_runner, &mtx, &delays]() {
+      for (auto j = 0; j < kTasksNum; j++) {
+        const auto delay = 1 + (i * 37 + j * 11) % kTasksNum;
+        task_runner.PostDelayedTask(
+            [delay, &mtx, &delays]() {
+              std::lock_guard lock(mtx);
+              delays.emplace_back(delay);
+            },
+            chrono::milliseconds(delay));
+      }
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+
+  {
+    std::lock_guard lock(mtx);
+    EXPECT_TRUE(delays.empty());
+  }
+
+  ms = kTasksNum / 2;
+  while (true) {
+    std::lock_guard lock(mtx);
+    if (delays.size() == kThreadsNum * kTasksNum / 2)
+      break;
+  }
+
+  ms = kTasksNum;
+  while (true) {
+    std::lock_guard lock(mtx);
+    if (delays.size() == kThreadsNum * kTasksNum)
+      break;
+  }
+
+  std::lock_guard lock(mtx);
+  for (size_t i = 0; i < delays.size(); i++) {
+    EXPECT_EQ(delays[i] <= kTasksNum / 2, i < delays.size() / 2);
+  }
+}
+
 TEST(ThreadPoolTaskRunner, PostTaskConcurrently) {
   std::mutex mtx;
   ThreadPoolTaskRunner task_runner(
@@ -224,4 +447,356 @@ TEST(ThreadPoolTaskRunner, MultipleThreads) {
   }
 }
 
+TEST(ThreadPoolTaskRunner, SpinTime) {
+  static constexpr chrono::nanoseconds kMaxSpinTime =
+      chrono::microseconds(100);
+  EXPECT_EQ(internal::GetSpinTime(chrono::microseconds(10), kMaxSpinTime),
+            chrono::microseconds(20));
+  EXPECT_EQ(internal::GetSpinTime(chrono::microseconds(80), kMaxSpinTime),
+            kMaxSpinTime);
+  EXPECT_EQ(internal::GetSpinTime(kMaxSpinTime, kMaxSpinTime), kMaxSpinTime);
+  EXPECT_EQ(internal::GetSpinTime(kMaxSpinTime + chrono::nanoseconds(1),
+                                  kMaxSpinTime),
+            chrono::nanoseconds::zero());
+
+  // Long intervals are clamped to twice the maximum: 50 -> 87.5 -> 115.625.
+  auto average_idle_time =
+      chrono::duration_cast<chrono::nanoseconds>(kMaxSpinTime / 2);
+  average_idle_time = internal::UpdateAverageIdleTime(
+      average_idle_time, chrono::seconds(1), kMaxSpinTime);
+  EXPECT_EQ(average_idle_time, chrono::nanoseconds(87500));
+  EXPECT_NE(internal::GetSpinTime(average_idle_time, kMaxSpinTime).count(), 0);
+  average_idle_time = internal::UpdateAverageIdleTime(
+      average_idle_time, chrono::seconds(1), kMaxSpinTime);
+  EXPECT_EQ(average_idle_time, chrono::nanoseconds(115625));
+  EXPECT_EQ(internal::GetSpinTime(average_idle_time, kMaxSpinTime).count(), 0);
+
+  // A short interval turns spinning on again.
+  average_idle_time = internal::UpdateAverageIdleTime(
+      average_idle_time, chrono::nanoseconds::zero(), kMaxSpinTime);
+  EXPECT_EQ(internal::GetSpinTime(average_idle_time, kMaxSpinTime),
+            kMaxSpinTime);
+}
+
+TEST(ThreadPoolTaskRunner, Spinning) {
+  static constexpr int kTasksNum = 200;
+  static constexpr int kThreadsNum = 4;
+  std::mutex mtx;
+  std::condition_variable cv;
+  auto counter = 0;
+  {
+    ThreadPoolTaskRunner task_runner(2, GetZeroTime);
+    task_runner.SetMaxSpinTime(chrono::milliseconds(10));
+
+    // Request-response: every task is posted after the previous one is run.
+    for (auto i = 0; i < kTasksNum; i++) {
+      task_runner.PostTask([&mtx, &cv, &counter]() {
+        std::lock_guard lock(mtx);
+        counter++;
+        cv.notify_one();
+      });
+
+      std::unique_lock lock(mtx);
+      while (counter != i + 1)
+        cv.wait(lock);
+    }
+
+    // Spinning is disabled on single core machines. Otherwise posters don't
+    // wake up the spinning threads, which take the tasks.
+    const auto spin_hits = task_runner.GetQueueStats().spin_hits;
+    if (std::thread::hardware_concurrency() > 1)
+      EXPECT_GT(spin_hits, 0U);
+    else
+      EXPECT_EQ(spin_hits, 0U);
+
+    // Bursts from several threads.
+    std::vector<std::thread> threads;
+    threads.reserve(kThreadsNum);
+    for (auto i = 0; i < kThreadsNum; i++) {
+      threads.emplace_back([&task_runner, &mtx, &counter]() {
+        for (auto j = 0; j < kTasksNum; j++) {
+          task_runner.PostTask([&mtx, &counter]() {
+            std::lock_guard lock(mtx);
+            counter++;
+          });
+        }
+      });
+    }
+    for (auto& thread : threads)
+      thread.join();
+
+    task_runner.SetMaxSpinTime(chrono::microseconds(0));
+    task_runner.PostTask([&mtx, &counter]() {
+      std::lock_guard lock(mtx);
+      counter++;
+    });
+  }
+
+  EXPECT_EQ(counter, kTasksNum * (kThreadsNum + 1) + 1);
+}
+
+TEST(ThreadPoolTaskRunner, CapacityReject) {
+  std::mutex mtx;
+  std::string str;
+  {
+    ThreadPoolTaskRunner task_runner(1, GetZeroTime);
+    task_runner.SetCapacity(2, ThreadPoolTaskRunner::OverflowPolicy::kReject);
+    ThreadBlocker blocker(&task_runner);
+
+    for (const auto* s : {"a", "b", "c"}) {
+      auto status = task_runner.TryPostTask([s, &mtx, &str]() {
+        std::lock_guard lock(mtx);
+        str += s;
+      });
+      if (*s == 'c') {
+        ASSERT_TRUE(status.err());
+        EXPECT_TRUE(status.GetError()->IsA<QueueFullError>());
+      } else {
+        EXPECT_FALSE(status.err());
+      }
+    }
+    task_runner.PostTask([&mtx, &str]() {
+      std::lock_guard lock(mtx);
+      str += "d";
+    });
+
+    const auto stats = task_runner.GetQueueStats();
+    EXPECT_EQ(stats.rejected, 2U);
+    EXPECT_EQ(stats.blocked, 0U);
+    EXPECT_EQ(stats.dropped, 0U);
+    EXPECT_EQ(stats.run_on_caller, 0U);
+
+    blocker.Release();
+  }
+
+  EXPECT_EQ(str, "ab");
+}
+
+TEST(ThreadPoolTaskRunner, CapacityDropOldest) {
+  std::mutex mtx;
+  std::string str;
+  {
+    ThreadPoolTaskRunner task_runner(1, GetZeroTime);
+    task_runner.SetCapacity(2,
+                            ThreadPoolTaskRunner::OverflowPolicy::kDropOldest);
+    ThreadBlocker blocker(&task_runner);
+
+    for (const auto* s : {"a", "b", "c", "d"}) {
+      EXPECT_FALSE(task_runner
+                       .TryPostTask([s, &mtx, &str]() {
+                         std::lock_guard lock(mtx);
+                         str += s;
+                       })
+                       .err());
+    }
+
+    EXPECT_EQ(task_runner.GetQueueStats().dropped, 2U);
+    blocker.Release();
+  }
+
+  EXPECT_EQ(str, "cd");
+}
+
+TEST(ThreadPoolTaskRunner, CapacityRunOnCaller) {
+  std::mutex mtx;
+  std::string str;
+  {
+    ThreadPoolTaskRunner task_runner(1, GetZeroTime);
+    task_runner.SetCapacity(
+        1, ThreadPoolTaskRunner::OverflowPolicy::kRunOnCaller);
+    ThreadBlocker blocker(&task_runner);
+
+    const auto caller_id = std::this_thread::get_id();
+    for (const auto* s : {"a", "b"}) {
+      task_runner.PostTask([s, caller_id, &mtx, &str]() {
+        std::lock_guard lock(mtx);
+        EXPECT_EQ(std::this_thread::get_id() == caller_id, *s == 'b');
+        str += s;
+      });
+    }
+
+    {
+      std::lock_guard lock(mtx);
+      EXPECT_EQ(str, "b");
+    }
+    EXPECT_EQ(task_runner.GetQueueStats().run_on_caller, 1U);
+    blocker.Release();
+  }
+
+  EXPECT_EQ(str, "ba");
+}
+
+TEST(ThreadPoolTaskRunner, CapacityBlock) {
+  std::mutex mtx;
+  std::string str;
+  {
+    ThreadPoolTaskRunner task_runner(1, GetZeroTime);
+    task_runner.SetCapacity(1, ThreadPoolTaskRunner::OverflowPolicy::kBlock);
+    ThreadBlocker blocker(&task_runner);
+
+    task_runner.PostTask([&mtx, &str]() {
+      std::lock_guard lock(mtx);
+      str += "a";
+    });
+    std::thread poster([&task_runner, &mtx, &str]() {
+      task_runner.PostTask([&mtx, &str]() {
+        std::lock_guard lock(mtx);
+        str += "b";
+      });
+    });
+
+    while (task_runner.GetQueueStats().blocked == 0) {
+    }
+    {
+      std::lock_guard lock(mtx);
+      EXPECT_EQ(str, std::string());
+    }
+
+    blocker.Release();
+    poster.join();
+  }
+
+  EXPECT_EQ(str, "ab");
+}
+
+TEST(ThreadPoolTaskRunner, CapacityBlockFromOwnThread) {
+  std::mutex mtx;
+  std::string str;
+  ThreadPoolTaskRunner task_runner(1, GetZeroTime);
+  task_runner.SetCapacity(1, ThreadPoolTaskRunner::OverflowPolicy::kBlock);
+
+  task_runner.PostTask([&task_runner, &mtx, &str]() {
+    for (const auto* s : {"a", "b", "c"}) {
+      task_runner.PostTask([s, &mtx, &str]() {
+        std::lock_guard lock(mtx);
+        str += s;
+      });
+    }
+  });
+
+  while (true) {
+    std::lock_guard lock(mtx);
+    if (str == "abc")
+      break;
+  }
+
+  EXPECT_EQ(task_runner.GetQueueStats().blocked, 0U);
+}
+
+TEST(ThreadPoolTaskRunner, DestructorIgnoresCapacity) {
+  using OverflowPolicy = ThreadPoolTaskRunner::OverflowPolicy;
+  for (const auto policy :
+       {OverflowPolicy::kBlock, OverflowPolicy::kReject,
+        OverflowPolicy::kDropOldest, OverflowPolicy::kRunOnCaller}) {
+    std::string str;
+    {
+      ThreadPoolTaskRunner task_runner(1, GetZeroTime);
+      task_runner.SetCapacity(1, policy);
+      ThreadBlocker blocker(&task_runner);
+      task_runner.PostTask([&str]() { str += "a"; });
+      blocker.Release();
+    }
+
+    EXPECT_EQ(str, "a");
+  }
+}
+
+TEST(ThreadPoolTaskRunner, FairScheduling) {
+  std::string str;
+  {
+    ThreadPoolTaskRunner task_runner(1, GetZeroTime);
+    auto heavy = task_runner.CreateTaskSource(1);
+    auto light = task_runner.CreateTaskSource(1);
+    ThreadBlocker blocker(&task_runner);
+
+    for (auto i = 0; i < 5; i++)
+      heavy->PostTask([i, &str]() { str += "h" + std::to_string(i); });
+    for (auto i = 0; i < 2; i++)
+      light->PostTask([i, &str]() { str += "l" + std::to_string(i); });
+    task_runner.PostTask([&str]() { str += "d"; });
+
+    blocker.Release();
+  }
+
+  EXPECT_EQ(str, "h0l0dh1l1h2h3h4");
+}
+
+TEST(ThreadPoolTaskRunner, FairSchedulingWeights) {
+  std::string str;
+  {
+    ThreadPoolTaskRunner task_runner(1, GetZeroTime);
+    auto heavy = task_runner.CreateTaskSource(3);
+    auto light = task_runner.CreateTaskSource(1);
+    ThreadBlocker blocker(&task_runner);
+
+    for (auto i = 0; i < 7; i++)
+      heavy->PostTask([i, &str]() { str += "h" + std::to_string(i); });
+    for (auto i = 0; i < 3; i++)
+      light->PostTask([i, &str]() { str += "l" + std::to_string(i); });
+
+    blocker.Release();
+  }
+
+  EXPECT_EQ(str, "h0h1h2l0h3h4h5l1h6l2");
+}
+
+TEST(ThreadPoolTaskRunner, TaskSourceDestroyedWithPendingTasks) {
+  std::string str;
+  {
+    ThreadPoolTaskRunner task_runner(1, GetZeroTime);
+    ThreadBlocker blocker(&task_runner);
+    {
+      auto source = task_runner.CreateTaskSource(2);
+      for (auto i = 0; i < 3; i++)
+        source->PostTask([i, &str]() { str += std::to_string(i); });
+    }
+    blocker.Release();
+  }
+
+  EXPECT_EQ(str, "012");
+}
+
+TEST(ThreadPoolTaskRunner, TaskSourceDestroyedWithDelayedTasks) {
+  std::mutex mtx;
+  std::string str;
+  std::atomic<int> ms = 0;
+  const auto append = [&mtx, &str](const std::string& suffix) {
+    return [&mtx, &str, suffix]() {
+      std::lock_guard lock(mtx);
+      str += suffix;
+    };
+  };
+
+  {
+    ThreadPoolTaskRunner task_runner(
+        1,
+        [&ms]() -> chrono::milliseconds { return chrono::milliseconds(ms); });
+    auto light = task_runner.CreateTaskSource(1);
+    ThreadBlocker blocker(&task_runner);
+    {
+      auto heavy = task_runner.CreateTaskSource(3);
+      heavy->PostTask(append("h0"));
+      for (auto i = 1; i < 4; i++) {
+        heavy->PostDelayedTask(append("h" + std::to_string(i)),
+                               chrono::milliseconds(100));
+      }
+    }
+    for (auto i = 0; i < 2; i++) {
+      light->PostDelayedTask(append("l" + std::to_string(i)),
+                             chrono::milliseconds(100));
+    }
+    blocker.Release();
+
+    // The source keeps its weight after its due tasks are run.
+    while (true) {
+      std::lock_guard lock(mtx);
+      if (str == "h0")
+        break;
+    }
+    ms = 100;
+  }
+
+  EXPECT_EQ(str, "h0h1h2h3l0l1");
+}
+
 }  // namespace rst
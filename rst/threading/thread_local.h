@@ -0,0 +1,92 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef RST_THREADING_THREAD_LOCAL_H_
+#define RST_THREADING_THREAD_LOCAL_H_
+
+#include <memory>
+
+#include "rst/macros/macros.h"
+#include "rst/macros/optimization.h"
+#include "rst/not_null/not_null.h"
+#include "rst/threading/thread_local_ptr.h"
+
+namespace rst {
+
+// Per-thread storage of T. Each thread gets its own default-constructed
+// object on the first Get(), the object is destroyed when the thread exits.
+//
+// Unlike a thread_local variable ThreadLocal<T> can be a class member and it
+// doesn't register a TLS guard and an exit-time destructor in every function
+// touching it.
+//
+// Example:
+//
+//   std::mt19937& GetThreadGenerator() {
+//     static NoDestructor<ThreadLocal<std::mt19937>> generator;
+//     return (*generator).Get();
+//   }
+//
+// The destructor destroys the objects of all threads, so it must not race
+// with other threads accessing the ThreadLocal<T>.
+template <class T>
+class ThreadLocal {
+ public:
+  ThreadLocal() = default;
+  ~ThreadLocal() = default;
+
+  T& Get() {
+    auto value = slot_.Get();
+    if (RST_UNLIKELY(value == nullptr))
+      value = Create();
+
+    return *static_cast<T*>(value);
+  }
+
+  T& operator*() { return Get(); }
+  NotNull<T*> operator->() { return &Get(); }
+
+  // Returns the object of the calling thread if it has been created.
+  T* GetIfCreated() const { return static_cast<T*>(slot_.Get()); }
+
+ private:
+  static void Delete(void* value) { delete static_cast<T*>(value); }
+
+  RST_ATTRIBUTE_NOINLINE void* Create() {
+    auto value = std::make_unique<T>();
+    slot_.Set(value.get());
+    return value.release();
+  }
+
+  internal::ThreadLocalSlot slot_{&ThreadLocal::Delete};
+
+  RST_DISALLOW_COPY_AND_ASSIGN(ThreadLocal);
+};
+
+}  // namespace rst
+
+#endif  // RST_THREADING_THREAD_LOCAL_H_
@@ -0,0 +1,207 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/threading/thread_local_ptr.h"
+
+#include <mutex>
+#include <set>
+
+#include "rst/check/check.h"
+#include "rst/macros/os.h"
+#include "rst/no_destructor/no_destructor.h"
+
+#if RST_BUILDFLAG(OS_WIN)
+#include <Windows.h>
+#else
+#include <pthread.h>
+#endif
+
+namespace rst {
+namespace internal {
+
+#if RST_BUILDFLAG(OS_WIN)
+ThreadLocalKey::ThreadLocalKey(const Destructor destructor) {
+  // Fiber local storage callbacks are also called on thread exit.
+  const auto key = ::FlsAlloc(reinterpret_cast<PFLS_CALLBACK_FUNCTION>(
+      reinterpret_cast<void*>(destructor)));
+  RST_CHECK(key != FLS_OUT_OF_INDEXES);
+  key_ = key;
+}
+
+ThreadLocalKey::~ThreadLocalKey() { ::FlsFree(static_cast<DWORD>(key_)); }
+
+void* ThreadLocalKey::Get() const {
+  return ::FlsGetValue(static_cast<DWORD>(key_));
+}
+
+void ThreadLocalKey::Set(void* value) {
+  RST_CHECK(::FlsSetValue(static_cast<DWORD>(key_), value));
+}
+#else   // RST_BUILDFLAG(OS_WIN)
+ThreadLocalKey::ThreadLocalKey(const Destructor destructor) {
+  pthread_key_t key;
+  RST_CHECK(pthread_key_create(&key, destructor) == 0);
+  key_ = static_cast<uintptr_t>(key);
+}
+
+ThreadLocalKey::~ThreadLocalKey() {
+  (void)pthread_key_delete(static_cast<pthread_key_t>(key_));
+}
+
+void* ThreadLocalKey::Get() const {
+  return pthread_getspecific(static_cast<pthread_key_t>(key_));
+}
+
+void ThreadLocalKey::Set(void* value) {
+  RST_CHECK(pthread_setspecific(static_cast<pthread_key_t>(key_), value) == 0);
+}
+#endif  // RST_BUILDFLAG(OS_WIN)
+
+namespace {
+
+struct SlotRegistry {
+  std::mutex mutex;
+  std::vector<ThreadLocalSlot::Deleter> deleters;
+  std::vector<size_t> free_ids;
+  std::set<ThreadLocalValues*> threads;
+};
+
+SlotRegistry& GetSlotRegistry() {
+  static NoDestructor<SlotRegistry> registry;
+  return *registry;
+}
+
+size_t AllocateId(const ThreadLocalSlot::Deleter deleter) {
+  auto& registry = GetSlotRegistry();
+  std::lock_guard lock(registry.mutex);
+  if (!registry.free_ids.empty()) {
+    const auto id = registry.free_ids.back();
+    registry.free_ids.pop_back();
+    registry.deleters[id] = deleter;
+    return id;
+  }
+
+  registry.deleters.push_back(deleter);
+  return registry.deleters.size() - 1;
+}
+
+}  // namespace
+
+ThreadLocalSlot::ThreadLocalSlot(const Deleter deleter)
+    : id_(AllocateId(deleter)), deleter_(deleter) {
+  RST_DCHECK(deleter_ != nullptr);
+}
+
+ThreadLocalSlot::~ThreadLocalSlot() {
+  std::vector<void*> values;
+  {
+    auto& registry = GetSlotRegistry();
+    std::lock_guard lock(registry.mutex);
+    for (const auto thread : registry.threads) {
+      if (id_ >= thread->values.size() || thread->values[id_] == nullptr)
+        continue;
+
+      values.push_back(thread->values[id_]);
+      thread->values[id_] = nullptr;
+    }
+
+    registry.deleters[id_] = nullptr;
+    registry.free_ids.push_back(id_);
+  }
+
+  for (const auto value : values)
+    deleter_(value);
+}
+
+void ThreadLocalSlot::Set(void* value) {
+  const auto values = GetOrCreateValues();
+  void* old_value = nullptr;
+  {
+    auto& registry = GetSlotRegistry();
+    std::lock_guard lock(registry.mutex);
+    if (id_ >= values->values.size())
+      values->values.resize(id_ + 1, nullptr);
+
+    old_value = values->values[id_];
+    values->values[id_] = value;
+  }
+
+  if (old_value != nullptr && old_value != value)
+    deleter_(old_value);
+}
+
+void ThreadLocalSlot::ForEach(
+    const std::function<void(NotNull<void*>)>& callback) const {
+  auto& registry = GetSlotRegistry();
+  std::lock_guard lock(registry.mutex);
+  for (const auto thread : registry.threads) {
+    if (id_ < thread->values.size() && thread->values[id_] != nullptr)
+      callback(thread->values[id_]);
+  }
+}
+
+// static
+void ThreadLocalSlot::OnThreadExit(void* values_ptr) {
+  const auto values = static_cast<ThreadLocalValues*>(values_ptr);
+  std::vector<std::pair<Deleter, void*>> to_delete;
+  {
+    auto& registry = GetSlotRegistry();
+    std::lock_guard lock(registry.mutex);
+    registry.threads.erase(values);
+    for (size_t id = 0; id < values->values.size(); id++) {
+      if (values->values[id] != nullptr)
+        to_delete.emplace_back(registry.deleters[id], values->values[id]);
+    }
+  }
+
+  // Deleters may use other slots, they get a fresh set of values then.
+  thread_values_ = nullptr;
+  delete values;
+  for (const auto& [deleter, value] : to_delete)
+    deleter(value);
+}
+
+// static
+NotNull<ThreadLocalValues*> ThreadLocalSlot::GetOrCreateValues() {
+  if (thread_values_ != nullptr)
+    return thread_values_;
+
+  static NoDestructor<ThreadLocalKey> exit_key(&ThreadLocalSlot::OnThreadExit);
+
+  const auto values = new ThreadLocalValues;
+  {
+    auto& registry = GetSlotRegistry();
+    std::lock_guard lock(registry.mutex);
+    registry.threads.insert(values);
+  }
+  exit_key->Set(values);
+  thread_values_ = values;
+  return values;
+}
+
+}  // namespace internal
+}  // namespace rst
@@ -0,0 +1,182 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef RST_THREADING_THREAD_LOCAL_PTR_H_
+#define RST_THREADING_THREAD_LOCAL_PTR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "rst/macros/macros.h"
+#include "rst/macros/optimization.h"
+#include "rst/not_null/not_null.h"
+
+namespace rst {
+namespace internal {
+
+// Wrapper for a platform TLS key with a per-thread destructor: pthread keys
+// on POSIX and fiber local storage on Windows.
+class ThreadLocalKey {
+ public:
+  using Destructor = void (*)(void*);
+
+  explicit ThreadLocalKey(Destructor destructor);
+  ~ThreadLocalKey();
+
+  void* Get() const;
+  void Set(void* value);
+
+ private:
+  uintptr_t key_ = 0;
+
+  RST_DISALLOW_COPY_AND_ASSIGN(ThreadLocalKey);
+};
+
+// Values of all slots of a thread indexed by slot ids.
+struct ThreadLocalValues {
+  std::vector<void*> values;
+};
+
+// Untyped slot of ThreadLocalPtr<T>. All slots share one trivially
+// initialized initial-exec thread_local pointer, so Get() has no TLS guard and
+// no __tls_get_addr() call.
+class ThreadLocalSlot {
+ public:
+  using Deleter = void (*)(void*);
+
+  explicit ThreadLocalSlot(Deleter deleter);
+
+  // Deletes the values of all threads.
+  ~ThreadLocalSlot();
+
+  void* Get() const {
+    const auto values = thread_values_;
+    if (RST_LIKELY(values != nullptr && id_ < values->values.size()))
+      return values->values[id_];
+
+    return nullptr;
+  }
+
+  // Replaces the value of the calling thread and deletes the previous one.
+  void Set(void* value);
+
+  // Calls |callback| on the non-null values of all threads under the lock.
+  void ForEach(const std::function<void(NotNull<void*>)>& callback) const;
+
+ private:
+  static inline thread_local ThreadLocalValues* thread_values_
+      RST_ATTRIBUTE_TLS_INITIAL_EXEC = nullptr;
+
+  static void OnThreadExit(void* values);
+  static NotNull<ThreadLocalValues*> GetOrCreateValues();
+
+  const size_t id_;
+  const Deleter deleter_;
+
+  RST_DISALLOW_COPY_AND_ASSIGN(ThreadLocalSlot);
+};
+
+}  // namespace internal
+
+// RocksDB-like thread-local pointer. Every thread has its own owned T* that
+// is deleted when the thread exits or when the ThreadLocalPtr<T> is
+// destroyed. Values of all threads can be enumerated for aggregation.
+//
+// Get() is an inlined initial-exec TLS load, a bounds check and an indexed
+// load, both in static and in shared builds.
+//
+// Example:
+//
+//   struct Counter {
+//     std::atomic<int64_t> value{0};
+//   };
+//
+//   ThreadLocalPtr<Counter> counters;
+//
+//   Counter& GetCounter() {
+//     Nullable<Counter*> counter = counters.Get();
+//     if (counter != nullptr)
+//       return *counter;
+//
+//     auto new_counter = std::make_unique<Counter>();
+//     auto& result = *new_counter;
+//     counters.Reset(std::move(new_counter));
+//     return result;
+//   }
+//
+//   void Increment() {
+//     GetCounter().value.fetch_add(1, std::memory_order_relaxed);
+//   }
+//
+//   int64_t Sum() {
+//     int64_t sum = 0;
+//     counters.ForEach([&sum](NotNull<Counter*> counter) {
+//       sum += counter->value.load(std::memory_order_relaxed);
+//     });
+//     return sum;
+//   }
+//
+// ForEach() runs concurrently with the owner threads, so the enumerated data
+// must be safe to read from another thread. The destructor must not race
+// with other threads accessing the ThreadLocalPtr<T>.
+template <class T>
+class ThreadLocalPtr {
+ public:
+  ThreadLocalPtr() = default;
+  ~ThreadLocalPtr() = default;
+
+  // Returns the value of the calling thread.
+  Nullable<T*> Get() const { return static_cast<T*>(slot_.Get()); }
+
+  // Replaces the value of the calling thread and deletes the previous one.
+  void Reset(std::unique_ptr<T>&& value = nullptr) {
+    slot_.Set(value.release());
+  }
+
+  // Calls |callback| with the non-null values of all threads.
+  template <class F>
+  void ForEach(F&& callback) const {
+    slot_.ForEach([&callback](const NotNull<void*> value) {
+      callback(NotNull<T*>(static_cast<T*>(value.get())));
+    });
+  }
+
+ private:
+  static void Delete(void* value) { delete static_cast<T*>(value); }
+
+  internal::ThreadLocalSlot slot_{&ThreadLocalPtr::Delete};
+
+  RST_DISALLOW_COPY_AND_ASSIGN(ThreadLocalPtr);
+};
+
+}  // namespace rst
+
+#endif  // RST_THREADING_THREAD_LOCAL_PTR_H_
@@ -0,0 +1,156 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/threading/thread_local_ptr.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "rst/threading/barrier.h"
+
+namespace rst {
+namespace {
+
+// Destroyed on the exiting threads concurrently.
+struct Counter {
+  explicit Counter(NotNull<std::atomic<int>*> destroyed)
+      : destroyed_(destroyed) {}
+  ~Counter() { (*destroyed_)++; }
+
+  std::atomic<int64_t> value{0};
+
+ private:
+  const NotNull<std::atomic<int>*> destroyed_;
+};
+
+}  // namespace
+
+TEST(ThreadLocalPtr, GetAndReset) {
+  std::atomic<int> destroyed = 0;
+  {
+    ThreadLocalPtr<Counter> ptr;
+    EXPECT_EQ(ptr.Get(), nullptr);
+
+    auto counter = std::make_unique<Counter>(&destroyed);
+    const auto raw_counter = counter.get();
+    ptr.Reset(std::move(counter));
+    EXPECT_EQ(ptr.Get(), raw_counter);
+    EXPECT_EQ(destroyed, 0);
+
+    ptr.Reset(std::make_unique<Counter>(&destroyed));
+    EXPECT_EQ(destroyed, 1);
+
+    ptr.Reset();
+    EXPECT_EQ(ptr.Get(), nullptr);
+    EXPECT_EQ(destroyed, 2);
+
+    ptr.Reset(std::make_unique<Counter>(&destroyed));
+  }
+  EXPECT_EQ(destroyed, 3);
+}
+
+TEST(ThreadLocalPtr, PerThreadAndDestroyedOnExit) {
+  std::atomic<int> destroyed = 0;
+  ThreadLocalPtr<Counter> ptr;
+  ptr.Reset(std::make_unique<Counter>(&destroyed));
+  const Counter* main_counter = ptr.Get().get();
+
+  std::thread thread([&ptr, &destroyed, main_counter]() {
+    EXPECT_EQ(ptr.Get(), nullptr);
+    ptr.Reset(std::make_unique<Counter>(&destroyed));
+    EXPECT_NE(ptr.Get(), main_counter);
+  });
+  thread.join();
+
+  EXPECT_EQ(destroyed, 1);
+  EXPECT_EQ(ptr.Get(), main_counter);
+}
+
+TEST(ThreadLocalPtr, IndependentSlots) {
+  std::atomic<int> destroyed = 0;
+  auto ptr1 = std::make_unique<ThreadLocalPtr<Counter>>();
+  ThreadLocalPtr<Counter> ptr2;
+  ptr1->Reset(std::make_unique<Counter>(&destroyed));
+  ptr2.Reset(std::make_unique<Counter>(&destroyed));
+  EXPECT_NE(ptr1->Get(), ptr2.Get());
+
+  ptr1.reset();
+  EXPECT_EQ(destroyed, 1);
+  ASSERT_NE(ptr2.Get(), nullptr);
+
+  // The freed slot id is reused by a new pointer that starts empty.
+  ThreadLocalPtr<Counter> ptr3;
+  EXPECT_EQ(ptr3.Get(), nullptr);
+}
+
+TEST(ThreadLocalPtr, ForEach) {
+  constexpr auto kThreads = 4;
+  constexpr auto kIncrements = 1000;
+
+  std::atomic<int> destroyed = 0;
+  ThreadLocalPtr<Counter> counters;
+  Barrier done(kThreads + 1);
+  Barrier exit(kThreads + 1);
+  std::vector<std::thread> threads;
+  for (auto i = 0; i < kThreads; i++) {
+    threads.emplace_back([&counters, &destroyed, &done, &exit]() {
+      counters.Reset(std::make_unique<Counter>(&destroyed));
+      for (auto j = 0; j < kIncrements; j++) {
+        Nullable<Counter*> counter = counters.Get();
+        ASSERT_NE(counter, nullptr);
+        counter->value.fetch_add(1, std::memory_order_relaxed);
+      }
+      done.CountDownAndWait();
+      exit.CountDownAndWait();
+    });
+  }
+
+  done.CountDownAndWait();
+  int64_t sum = 0;
+  auto count = 0;
+  counters.ForEach([&sum, &count](const NotNull<Counter*> counter) {
+    sum += counter->value.load(std::memory_order_relaxed);
+    count++;
+  });
+  EXPECT_EQ(sum, kThreads * kIncrements);
+  EXPECT_EQ(count, kThreads);
+
+  exit.CountDownAndWait();
+  for (auto& thread : threads)
+    thread.join();
+
+  count = 0;
+  counters.ForEach([&count](NotNull<Counter*>) { count++; });
+  EXPECT_EQ(count, 0);
+}
+
+}  // namespace rst
@@ -0,0 +1,110 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/threading/thread_local.h"
+
+#include <memory>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "rst/threading/barrier.h"
+
+namespace rst {
+namespace {
+
+auto g_destroyed = 0;
+
+struct Counted {
+  ~Counted() { g_destroyed++; }
+  int value = 0;
+};
+
+}  // namespace
+
+TEST(ThreadLocal, PerThread) {
+  ThreadLocal<int> tls;
+  EXPECT_EQ(tls.GetIfCreated(), nullptr);
+  tls.Get() = 1;
+  EXPECT_EQ(*tls, 1);
+  EXPECT_EQ(tls.GetIfCreated(), &tls.Get());
+
+  std::thread thread([&tls]() {
+    EXPECT_EQ(tls.GetIfCreated(), nullptr);
+    EXPECT_EQ(tls.Get(), 0);
+    tls.Get() = 2;
+    EXPECT_EQ(*tls, 2);
+  });
+  thread.join();
+
+  EXPECT_EQ(*tls, 1);
+}
+
+TEST(ThreadLocal, DestroysOnThreadExit) {
+  g_destroyed = 0;
+  {
+    ThreadLocal<Counted> tls;
+    std::thread thread([&tls]() { tls->value = 1; });
+    thread.join();
+    EXPECT_EQ(g_destroyed, 1);
+
+    tls->value = 2;
+    EXPECT_EQ(g_destroyed, 1);
+  }
+  EXPECT_EQ(g_destroyed, 2);
+}
+
+TEST(ThreadLocal, DestroysAllThreadsObjects) {
+  g_destroyed = 0;
+  auto tls = std::make_unique<ThreadLocal<Counted>>();
+  Barrier created(2);
+  Barrier destroyed(2);
+  std::thread thread([&tls, &created, &destroyed]() {
+    (*tls)->value = 1;
+    created.CountDownAndWait();
+    destroyed.CountDownAndWait();
+  });
+
+  created.CountDownAndWait();
+  tls.reset();
+  EXPECT_EQ(g_destroyed, 1);
+
+  destroyed.CountDownAndWait();
+  thread.join();
+  EXPECT_EQ(g_destroyed, 1);
+}
+
+TEST(ThreadLocal, Independent) {
+  ThreadLocal<int> tls1;
+  ThreadLocal<int> tls2;
+  *tls1 = 1;
+  *tls2 = 2;
+  EXPECT_EQ(*tls1, 1);
+  EXPECT_EQ(*tls2, 2);
+}
+
+}  // namespace rst
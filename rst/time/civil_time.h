@@ -0,0 +1,97 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef RST_TIME_CIVIL_TIME_H_
+#define RST_TIME_CIVIL_TIME_H_
+
+#include <cstdint>
+
+namespace rst {
+
+inline constexpr int64_t kSecondsPerDay = 86400;
+inline constexpr int64_t kMicrosecondsPerSecond = 1000000;
+
+// A date in the proleptic Gregorian calendar.
+struct CivilDay {
+  int64_t year = 1970;
+  int month = 1;  // [1, 12].
+  int day = 1;    // [1, 31].
+};
+
+// Returns the number of days since 1970-01-01 of the civil date. Uses Howard
+// Hinnant's days_from_civil() algorithm: a few multiplications and divisions,
+// no loops, no tables and no time zone database lookups.
+//
+// Example:
+//
+//   static_assert(DaysFromCivil(2000, 3, 1) == 11017);
+//
+constexpr int64_t DaysFromCivil(int64_t year, const int month, const int day) {
+  year -= month <= 2 ? 1 : 0;
+  const auto era = (year >= 0 ? year : year - 399) / 400;
+  const auto year_of_era = year - era * 400;  // [0, 399].
+  const auto month_index = month > 2 ? month - 3 : month + 9;  // March is 0.
+  const auto day_of_year = (153 * month_index + 2) / 5 + day - 1;  // [0, 365].
+  const auto day_of_era = year_of_era * 365 + year_of_era / 4 -
+                          year_of_era / 100 + day_of_year;  // [0, 146096].
+  return era * 146097 + day_of_era - 719468;
+}
+
+// Returns the civil date of the number of days since 1970-01-01, the inverse
+// of DaysFromCivil(). The conditionals compile to conditional moves.
+constexpr CivilDay CivilFromDays(int64_t days) {
+  days += 719468;
+  const auto era = (days >= 0 ? days : days - 146096) / 146097;
+  const auto day_of_era = days - era * 146097;  // [0, 146096].
+  const auto year_of_era = (day_of_era - day_of_era / 1460 +
+                            day_of_era / 36524 - day_of_era / 146096) /
+                           365;  // [0, 399].
+  const auto day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 -
+                                         year_of_era / 100);  // [0, 365].
+  const auto month_index = (5 * day_of_year + 2) / 153;  // March is 0.
+  const auto day = static_cast<int>(day_of_year - (153 * month_index + 2) / 5 +
+                                    1);  // [1, 31].
+  const auto month = static_cast<int>(month_index < 10 ? month_index + 3
+                                                       : month_index - 9);
+  const auto year = year_of_era + era * 400 + (month <= 2 ? 1 : 0);
+  return CivilDay{year, month, day};
+}
+
+// Returns true if |year| is a leap year.
+constexpr bool IsLeapYear(const int64_t year) {
+  return year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+}
+
+// Returns the number of days in the |month| of the |year|.
+constexpr int DaysInMonth(const int64_t year, const int month) {
+  constexpr int kDays[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  return month == 2 && IsLeapYear(year) ? 29 : kDays[month - 1];
+}
+
+}  // namespace rst
+
+#endif  // RST_TIME_CIVIL_TIME_H_
@@ -0,0 +1,114 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/time/civil_time.h"
+
+#include <cstdint>
+#include <ctime>
+
+#include <gtest/gtest.h>
+
+#include "rst/macros/macros.h"
+#include "rst/macros/os.h"
+
+namespace rst {
+
+TEST(CivilTime, DaysFromCivil) {
+  static_assert(DaysFromCivil(1970, 1, 1) == 0);
+  static_assert(DaysFromCivil(1969, 12, 31) == -1);
+  static_assert(DaysFromCivil(2000, 3, 1) == 11017);
+  static_assert(DaysFromCivil(0, 1, 1) == -719528);
+
+  EXPECT_EQ(DaysFromCivil(2020, 2, 29), 18321);
+  EXPECT_EQ(DaysFromCivil(9999, 12, 31), 2932896);
+}
+
+TEST(CivilTime, CivilFromDays) {
+  constexpr auto epoch = CivilFromDays(0);
+  static_assert(epoch.year == 1970 && epoch.month == 1 && epoch.day == 1);
+
+  const auto leap_day = CivilFromDays(18321);
+  EXPECT_EQ(leap_day.year, 2020);
+  EXPECT_EQ(leap_day.month, 2);
+  EXPECT_EQ(leap_day.day, 29);
+
+  const auto before_epoch = CivilFromDays(-1);
+  EXPECT_EQ(before_epoch.year, 1969);
+  EXPECT_EQ(before_epoch.month, 12);
+  EXPECT_EQ(before_epoch.day, 31);
+}
+
+namespace {
+
+void ExpectRoundTrip(const int64_t begin, const int64_t end,
+                     const int64_t step) {
+  for (auto days = begin; days <= end; days += step) {
+    const auto civil_day = CivilFromDays(days);
+    ASSERT_GE(civil_day.month, 1);
+    ASSERT_LE(civil_day.month, 12);
+    ASSERT_GE(civil_day.day, 1);
+    ASSERT_LE(civil_day.day, DaysInMonth(civil_day.year, civil_day.month));
+    ASSERT_EQ(DaysFromCivil(civil_day.year, civil_day.month, civil_day.day),
+              days);
+  }
+}
+
+}  // namespace
+
+TEST(CivilTime, RoundTrip) {
+  ExpectRoundTrip(DaysFromCivil(1900, 1, 1), DaysFromCivil(2100, 12, 31), 1);
+  ExpectRoundTrip(DaysFromCivil(0, 1, 1), DaysFromCivil(9999, 12, 31), 11);
+}
+
+#if !RST_BUILDFLAG(OS_WIN)
+TEST(CivilTime, MatchesGmtime) {
+  for (int64_t days = -1000; days < 30000; days += 7) {
+    const auto time = static_cast<std::time_t>(days * 86400);
+    std::tm tm = {};
+    ASSERT_NE(gmtime_r(&time, &tm), nullptr);
+
+    const auto civil_day = CivilFromDays(days);
+    EXPECT_EQ(civil_day.year, tm.tm_year + 1900);
+    EXPECT_EQ(civil_day.month, tm.tm_mon + 1);
+    EXPECT_EQ(civil_day.day, tm.tm_mday);
+  }
+}
+#endif  // !RST_BUILDFLAG(OS_WIN)
+
+TEST(CivilTime, DaysInMonth) {
+  static_assert(IsLeapYear(2000));
+  static_assert(!IsLeapYear(1900));
+  static_assert(IsLeapYear(2020));
+  static_assert(!IsLeapYear(2021));
+
+  EXPECT_EQ(DaysInMonth(2020, 2), 29);
+  EXPECT_EQ(DaysInMonth(2021, 2), 28);
+  EXPECT_EQ(DaysInMonth(2021, 4), 30);
+  EXPECT_EQ(DaysInMonth(2021, 12), 31);
+}
+
+}  // namespace rst
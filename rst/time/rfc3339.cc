@@ -0,0 +1,204 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/time/rfc3339.h"
+
+#include <cstdint>
+#include <utility>
+
+#include "rst/check/check.h"
+#include "rst/strings/str_cat.h"
+#include "rst/time/civil_time.h"
+
+namespace rst {
+namespace {
+
+constexpr int64_t kMicrosecondsPerDay = kSecondsPerDay * kMicrosecondsPerSecond;
+
+// Writes |value| as |N| decimal digits. 32-bit unsigned division by a constant
+// is a multiplication and a shift.
+template <int N>
+void WriteDigits(char* out, const int64_t value) {
+  auto digits = static_cast<uint32_t>(value);
+  for (auto i = N - 1; i >= 0; i--) {
+    out[i] = static_cast<char>('0' + digits % 10);
+    digits /= 10;
+  }
+}
+
+// Parses |count| decimal digits of |str| starting at |pos|.
+bool ParseDigits(const std::string_view str, const size_t pos,
+                 const size_t count, const NotNull<int*> value) {
+  if (pos + count > str.size())
+    return false;
+
+  auto result = 0;
+  for (auto i = pos; i < pos + count; i++) {
+    const auto c = str[i];
+    if (c < '0' || c > '9')
+      return false;
+    result = result * 10 + (c - '0');
+  }
+
+  *value = result;
+  return true;
+}
+
+Status MakeError(const std::string_view str) {
+  return MakeStatus<TimeParseError>(
+      StrCat({"Invalid RFC 3339 timestamp: ", str}));
+}
+
+}  // namespace
+
+std::string_view FormatRfc3339(const std::chrono::microseconds time,
+                               const std::chrono::seconds utc_offset,
+                               char (&buffer)[kRfc3339BufferSize]) {
+  const auto offset = utc_offset.count();
+  RST_DCHECK(offset % 60 == 0);
+  RST_DCHECK(offset > -kSecondsPerDay && offset < kSecondsPerDay);
+
+  const auto local = time.count() + offset * kMicrosecondsPerSecond;
+  auto days = local / kMicrosecondsPerDay;
+  auto micros_of_day = local % kMicrosecondsPerDay;
+  if (micros_of_day < 0) {
+    days--;
+    micros_of_day += kMicrosecondsPerDay;
+  }
+
+  const auto civil_day = CivilFromDays(days);
+  RST_DCHECK(civil_day.year >= 0 && civil_day.year <= 9999);
+  const auto seconds_of_day =
+      static_cast<uint32_t>(micros_of_day / kMicrosecondsPerSecond);
+
+  char* p = buffer;
+  WriteDigits<4>(p, civil_day.year);
+  p[4] = '-';
+  WriteDigits<2>(p + 5, civil_day.month);
+  p[7] = '-';
+  WriteDigits<2>(p + 8, civil_day.day);
+  p[10] = 'T';
+  WriteDigits<2>(p + 11, seconds_of_day / 3600);
+  p[13] = ':';
+  WriteDigits<2>(p + 14, seconds_of_day / 60 % 60);
+  p[16] = ':';
+  WriteDigits<2>(p + 17, seconds_of_day % 60);
+  p[19] = '.';
+  WriteDigits<6>(p + 20, micros_of_day % kMicrosecondsPerSecond);
+
+  if (offset == 0) {
+    p[26] = 'Z';
+    return std::string_view(buffer, 27);
+  }
+
+  const auto offset_minutes = (offset < 0 ? -offset : offset) / 60;
+  p[26] = offset < 0 ? '-' : '+';
+  WriteDigits<2>(p + 27, offset_minutes / 60);
+  p[29] = ':';
+  WriteDigits<2>(p + 30, offset_minutes % 60);
+  return std::string_view(buffer, kRfc3339BufferSize);
+}
+
+StatusOr<std::chrono::microseconds> ParseRfc3339(const std::string_view str) {
+  // YYYY-MM-DDTHH:MM:SS
+  auto year = 0;
+  auto month = 0;
+  auto day = 0;
+  auto hour = 0;
+  auto minute = 0;
+  auto second = 0;
+  if (str.size() < 20 || !ParseDigits(str, 0, 4, &year) || str[4] != '-' ||
+      !ParseDigits(str, 5, 2, &month) || str[7] != '-' ||
+      !ParseDigits(str, 8, 2, &day) ||
+      (str[10] != 'T' && str[10] != 't' && str[10] != ' ') ||
+      !ParseDigits(str, 11, 2, &hour) || str[13] != ':' ||
+      !ParseDigits(str, 14, 2, &minute) || str[16] != ':' ||
+      !ParseDigits(str, 17, 2, &second)) {
+    return MakeError(str);
+  }
+
+  // Second 60 is a leap second, it's folded into the next minute.
+  if (month < 1 || month > 12 || day < 1 || day > DaysInMonth(year, month) ||
+      hour > 23 || minute > 59 || second > 60) {
+    return MakeError(str);
+  }
+
+  size_t pos = 19;
+  int64_t micros = 0;
+  if (str[pos] == '.') {
+    pos++;
+    const auto fraction_begin = pos;
+    int64_t scale = kMicrosecondsPerSecond;
+    for (; pos < str.size() && str[pos] >= '0' && str[pos] <= '9'; pos++) {
+      scale /= 10;
+      micros += (str[pos] - '0') * scale;
+    }
+    if (pos == fraction_begin)
+      return MakeError(str);
+  }
+
+  if (pos >= str.size())
+    return MakeError(str);
+
+  int64_t offset = 0;
+  if (str[pos] == 'Z' || str[pos] == 'z') {
+    pos++;
+  } else if (str[pos] == '+' || str[pos] == '-') {
+    auto offset_hours = 0;
+    auto offset_minutes = 0;
+    if (!ParseDigits(str, pos + 1, 2, &offset_hours) ||
+        pos + 3 >= str.size() || str[pos + 3] != ':' ||
+        !ParseDigits(str, pos + 4, 2, &offset_minutes) || offset_hours > 23 ||
+        offset_minutes > 59) {
+      return MakeError(str);
+    }
+    offset = (offset_hours * 60 + offset_minutes) * 60;
+    if (str[pos] == '-')
+      offset = -offset;
+    pos += 6;
+  } else {
+    return MakeError(str);
+  }
+
+  if (pos != str.size())
+    return MakeError(str);
+
+  const auto seconds = DaysFromCivil(year, month, day) * kSecondsPerDay +
+                       hour * 3600 + minute * 60 + second - offset;
+  return std::chrono::microseconds(seconds * kMicrosecondsPerSecond + micros);
+}
+
+char TimeParseError::id_ = '\0';
+
+TimeParseError::TimeParseError(std::string&& message)
+    : message_(std::move(message)) {}
+
+TimeParseError::~TimeParseError() = default;
+
+const std::string& TimeParseError::AsString() const { return message_; }
+
+}  // namespace rst
@@ -0,0 +1,84 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef RST_TIME_RFC3339_H_
+#define RST_TIME_RFC3339_H_
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include "rst/macros/macros.h"
+#include "rst/status/status.h"
+#include "rst/status/status_or.h"
+
+namespace rst {
+
+// Size of "YYYY-MM-DDTHH:MM:SS.ffffff+hh:mm".
+inline constexpr size_t kRfc3339BufferSize = 32;
+
+// Formats |time|, the time since the Unix epoch, as an RFC 3339 timestamp with
+// microsecond precision in the time zone with |utc_offset| into |buffer|
+// without allocations. A zero offset is written as "Z". |utc_offset| must be a
+// whole number of minutes less than a day, the year must be in [0, 9999].
+//
+// Example:
+//
+//   char buffer[kRfc3339BufferSize];
+//   FormatRfc3339(std::chrono::microseconds(1), std::chrono::hours(3),
+//                 buffer);  // "1970-01-01T03:00:00.000001+03:00"
+//
+std::string_view FormatRfc3339(std::chrono::microseconds time,
+                               std::chrono::seconds utc_offset,
+                               char (&buffer)[kRfc3339BufferSize]);
+
+// Parses an RFC 3339 timestamp like "2020-01-02T03:04:05.678Z" or
+// "2020-01-02 03:04:05+03:00" and returns the time since the Unix epoch. The
+// fraction may have any number of digits, digits beyond microseconds are
+// truncated. Returns TimeParseError on malformed input.
+StatusOr<std::chrono::microseconds> ParseRfc3339(std::string_view str);
+
+class TimeParseError : public ErrorInfo<TimeParseError> {
+ public:
+  explicit TimeParseError(std::string&& message);
+  ~TimeParseError() override;
+
+  // ErrorInfo:
+  const std::string& AsString() const override;
+
+  static char id_;
+
+ private:
+  const std::string message_;
+
+  RST_DISALLOW_COPY_AND_ASSIGN(TimeParseError);
+};
+
+}  // namespace rst
+
+#endif  // RST_TIME_RFC3339_H_
@@ -0,0 +1,108 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/time/rfc3339.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace rst {
+namespace {
+
+std::string Format(const int64_t micros, const int64_t offset_minutes) {
+  char buffer[kRfc3339BufferSize];
+  return std::string(FormatRfc3339(std::chrono::microseconds(micros),
+                                   std::chrono::minutes(offset_minutes),
+                                   buffer));
+}
+
+int64_t Parse(const std::string_view str) {
+  auto time = ParseRfc3339(str);
+  EXPECT_FALSE(time.err());
+  return time->count();
+}
+
+void ExpectParseError(const std::string_view str) {
+  auto time = ParseRfc3339(str);
+  ASSERT_TRUE(time.err());
+  EXPECT_TRUE(time.status().GetError()->IsA<TimeParseError>());
+}
+
+}  // namespace
+
+TEST(Rfc3339, Format) {
+  EXPECT_EQ(Format(0, 0), "1970-01-01T00:00:00.000000Z");
+  EXPECT_EQ(Format(1, 180), "1970-01-01T03:00:00.000001+03:00");
+  EXPECT_EQ(Format(-1, 0), "1969-12-31T23:59:59.999999Z");
+  EXPECT_EQ(Format(1577934245678901, -330), "2020-01-01T21:34:05.678901-05:30");
+  EXPECT_EQ(Format(1582934400000000, 0), "2020-02-29T00:00:00.000000Z");
+  EXPECT_EQ(Format(253402300799999999, 0), "9999-12-31T23:59:59.999999Z");
+}
+
+TEST(Rfc3339, Parse) {
+  EXPECT_EQ(Parse("1970-01-01T00:00:00Z"), 0);
+  EXPECT_EQ(Parse("1970-01-01t00:00:00.000001z"), 1);
+  EXPECT_EQ(Parse("1970-01-01 03:00:00.000001+03:00"), 1);
+  EXPECT_EQ(Parse("1969-12-31T23:59:59.999999Z"), -1);
+  EXPECT_EQ(Parse("2020-01-01T21:34:05.678901-05:30"), 1577934245678901);
+  EXPECT_EQ(Parse("2020-01-02T03:04:05.6Z"), 1577934245600000);
+  EXPECT_EQ(Parse("2020-01-02T03:04:05.678901999Z"), 1577934245678901);
+  EXPECT_EQ(Parse("2016-12-31T23:59:60Z"), Parse("2017-01-01T00:00:00Z"));
+}
+
+TEST(Rfc3339, RoundTrip) {
+  for (int64_t micros = -100000000000000; micros < 4000000000000000;
+       micros += 98765432109877) {
+    EXPECT_EQ(Parse(Format(micros, 0)), micros);
+    EXPECT_EQ(Parse(Format(micros, 345)), micros);
+    EXPECT_EQ(Parse(Format(micros, -720)), micros);
+  }
+}
+
+TEST(Rfc3339, ParseErrors) {
+  ExpectParseError("");
+  ExpectParseError("2020-01-02");
+  ExpectParseError("2020-01-02T03:04:05");
+  ExpectParseError("2020-01-02T03:04:05.Z");
+  ExpectParseError("2020-01-02T03:04:05Zjunk");
+  ExpectParseError("2020-01-02X03:04:05Z");
+  ExpectParseError("2020/01/02T03:04:05Z");
+  ExpectParseError("2020-13-02T03:04:05Z");
+  ExpectParseError("2021-02-29T03:04:05Z");
+  ExpectParseError("2020-01-02T24:04:05Z");
+  ExpectParseError("2020-01-02T03:60:05Z");
+  ExpectParseError("2020-01-02T03:04:61Z");
+  ExpectParseError("2020-01-02T03:04:05+3:00");
+  ExpectParseError("2020-01-02T03:04:05+03");
+  ExpectParseError("2020-01-02T03:04:05+03:60");
+  ExpectParseError("2020-0a-02T03:04:05Z");
+}
+
+}  // namespace rst
@@ -0,0 +1,89 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/time/time_zone.h"
+
+#include <cstdint>
+#include <ctime>
+#include <limits>
+
+#include "rst/check/check.h"
+#include "rst/macros/macros.h"
+#include "rst/macros/optimization.h"
+#include "rst/macros/os.h"
+#include "rst/time/civil_time.h"
+
+namespace rst {
+namespace {
+
+constexpr int64_t kCacheIntervalSeconds = 15 * 60;
+
+struct OffsetCache {
+  int64_t interval = std::numeric_limits<int64_t>::min();
+  int64_t offset = 0;
+};
+
+thread_local OffsetCache t_offset_cache;
+
+int64_t ResolveLocalUtcOffset(const int64_t time) {
+  const auto time_t_value = static_cast<std::time_t>(time);
+  std::tm tm = {};
+#if RST_BUILDFLAG(OS_WIN)
+  RST_CHECK(localtime_s(&tm, &time_t_value) == 0);
+#else
+  RST_CHECK(localtime_r(&time_t_value, &tm) != nullptr);
+#endif
+
+  // tm_gmtoff isn't portable, so the local civil time is converted back as if
+  // it were UTC.
+  const auto days =
+      DaysFromCivil(tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+  const auto local = days * kSecondsPerDay + tm.tm_hour * 3600 +
+                     tm.tm_min * 60 + tm.tm_sec;
+  return local - time;
+}
+
+}  // namespace
+
+std::chrono::seconds GetLocalUtcOffset(const std::chrono::seconds time) {
+  const auto seconds = time.count();
+  auto interval = seconds / kCacheIntervalSeconds;
+  if (seconds % kCacheIntervalSeconds < 0)
+    interval--;
+
+  auto& cache = t_offset_cache;
+  if (RST_UNLIKELY(cache.interval != interval)) {
+    // Every time in the interval has the same offset, resolve it at the start
+    // so that the cache doesn't depend on the first queried time.
+    cache.offset = ResolveLocalUtcOffset(interval * kCacheIntervalSeconds);
+    cache.interval = interval;
+  }
+
+  return std::chrono::seconds(cache.offset);
+}
+
+}  // namespace rst
@@ -0,0 +1,52 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef RST_TIME_TIME_ZONE_H_
+#define RST_TIME_TIME_ZONE_H_
+
+#include <chrono>
+
+namespace rst {
+
+// Returns the offset of the local time zone from UTC at |time|, the time since
+// the Unix epoch. The offset is resolved with localtime_r() and cached per
+// thread for the 15 minute interval containing |time|, since time zone
+// transitions happen on quarter-hour boundaries. Cached offsets aren't
+// invalidated by changes of the TZ environment variable.
+//
+// Example:
+//
+//   const auto now = std::chrono::duration_cast<std::chrono::seconds>(
+//       std::chrono::system_clock::now().time_since_epoch());
+//   char buffer[kRfc3339BufferSize];
+//   FormatRfc3339(now, GetLocalUtcOffset(now), buffer);
+//
+std::chrono::seconds GetLocalUtcOffset(std::chrono::seconds time);
+
+}  // namespace rst
+
+#endif  // RST_TIME_TIME_ZONE_H_
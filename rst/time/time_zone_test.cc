@@ -0,0 +1,60 @@
+// Copyright (c) 2020, Sergey Abbakumov
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rst/time/time_zone.h"
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+
+#include <gtest/gtest.h>
+
+#include "rst/macros/macros.h"
+#include "rst/macros/os.h"
+
+namespace rst {
+
+TEST(TimeZone, GetLocalUtcOffset) {
+  const auto now = std::chrono::duration_cast<std::chrono::seconds>(
+      std::chrono::system_clock::now().time_since_epoch());
+  for (auto time = now - std::chrono::hours(24 * 400); time < now;
+       time += std::chrono::minutes(7)) {
+    const auto offset = GetLocalUtcOffset(time);
+    ASSERT_EQ(offset.count() % 60, 0);
+    ASSERT_LT(offset, std::chrono::hours(24));
+    ASSERT_GT(offset, -std::chrono::hours(24));
+
+#if !RST_BUILDFLAG(OS_WIN)
+    const auto time_t_value = static_cast<std::time_t>(time.count());
+    std::tm tm = {};
+    ASSERT_NE(localtime_r(&time_t_value, &tm), nullptr);
+    ASSERT_EQ(offset.count(), tm.tm_gmtoff);
+#endif  // !RST_BUILDFLAG(OS_WIN)
+  }
+}
+
+}  // namespace rst
@@ -29,9 +29,18 @@
 #define RST_TYPE_TYPE_H_
 
 #include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <type_traits>
 #include <utility>
 
+// MSVC applies the empty base optimization only to the first base by default.
+#if defined(_MSC_VER)
+#define RST_TYPE_EMPTY_BASES __declspec(empty_bases)
+#else
+#define RST_TYPE_EMPTY_BASES
+#endif
+
 namespace rst {
 
 // A Chromium-like StrongAlias type.
@@ -67,44 +76,258 @@ namespace rst {
 // TagType is an empty tag class (also called "phantom type") that only serves
 // the type system to differentiate between different instantiations of the
 // template.
-template <class TagType, class UnderlyingType>
-class Type {
+//
+// Operations other than comparisons are opt-in with skills listed after the
+// underlying type:
+//
+// using Meters = Type<class MetersTag, int, Addable, Subtractable>;
+// Meters x = Meters(1) + Meters(2);  // Compiles.
+// Meters y = Meters(1) * Meters(2);  // Does not compile.
+//
+// Type is as large as the underlying type, is trivially copyable if the
+// underlying type is, and is usable in constant expressions. A default
+// constructed Type holds a value-initialized underlying value.
+
+template <class TagType, class UnderlyingType,
+          template <class> class... Skills>
+class RST_TYPE_EMPTY_BASES Type
+    : public Skills<Type<TagType, UnderlyingType, Skills...>>... {
  public:
-  Type() = default;
+  using Underlying = UnderlyingType;
 
-  explicit Type(const UnderlyingType& value) : value_(value) {}
-  explicit Type(UnderlyingType&& value) : value_(std::move(value)) {}
+  constexpr Type() = default;
 
-  Type(const Type&) = default;
-  Type(Type&&) noexcept = default;
+  constexpr explicit Type(const UnderlyingType& value) : value_(value) {}
+  constexpr explicit Type(UnderlyingType&& value) : value_(std::move(value)) {}
 
-  ~Type() = default;
+  constexpr const UnderlyingType& value() const { return value_; }
+  constexpr explicit operator UnderlyingType() const { return value_; }
 
-  Type& operator=(const Type&) = default;
-  Type& operator=(Type&&) noexcept = default;
+  constexpr bool operator==(const Type& other) const {
+    return value_ == other.value_;
+  }
+  constexpr bool operator!=(const Type& other) const {
+    return value_ != other.value_;
+  }
+  constexpr bool operator<(const Type& other) const {
+    return value_ < other.value_;
+  }
+  constexpr bool operator<=(const Type& other) const {
+    return value_ <= other.value_;
+  }
+  constexpr bool operator>(const Type& other) const {
+    return value_ > other.value_;
+  }
+  constexpr bool operator>=(const Type& other) const {
+    return value_ >= other.value_;
+  }
 
-  const UnderlyingType& value() const { return value_; }
-  explicit operator UnderlyingType() const { return value_; }
+ protected:
+  UnderlyingType value_{};
+};
 
-  bool operator==(const Type& other) const { return value_ == other.value_; }
-  bool operator!=(const Type& other) const { return value_ != other.value_; }
-  bool operator<(const Type& other) const { return value_ < other.value_; }
-  bool operator<=(const Type& other) const { return value_ <= other.value_; }
-  bool operator>(const Type& other) const { return value_ > other.value_; }
-  bool operator>=(const Type& other) const { return value_ >= other.value_; }
+namespace internal {
 
- protected:
-  UnderlyingType value_;
+// Converts the result of an operation on underlying values, which can be
+// promoted to int, back to the Type.
+template <class T, class U>
+constexpr T Wrap(const U& value) {
+  return T(static_cast<typename T::Underlying>(value));
+}
+
+// The MurmurHash3 64-bit finalizer: every input bit affects every output bit.
+constexpr uint64_t HashMix(uint64_t x) {
+  x ^= x >> 33;
+  x *= uint64_t{0xff51afd7ed558ccd};
+  x ^= x >> 33;
+  x *= uint64_t{0xc4ceb9fe1a85ec53};
+  x ^= x >> 33;
+  return x;
+}
+
+}  // namespace internal
+
+// Skills. T is the Type they are mixed into.
+
+// a + b, a += b.
+template <class T>
+class Addable {
+ public:
+  friend constexpr T operator+(const T& lhs, const T& rhs) {
+    return internal::Wrap<T>(lhs.value() + rhs.value());
+  }
+  friend constexpr T& operator+=(T& lhs, const T& rhs) {
+    return lhs = lhs + rhs;
+  }
+};
+
+// a - b, a -= b.
+template <class T>
+class Subtractable {
+ public:
+  friend constexpr T operator-(const T& lhs, const T& rhs) {
+    return internal::Wrap<T>(lhs.value() - rhs.value());
+  }
+  friend constexpr T& operator-=(T& lhs, const T& rhs) {
+    return lhs = lhs - rhs;
+  }
+};
+
+// a * b, a *= b.
+template <class T>
+class Multipliable {
+ public:
+  friend constexpr T operator*(const T& lhs, const T& rhs) {
+    return internal::Wrap<T>(lhs.value() * rhs.value());
+  }
+  friend constexpr T& operator*=(T& lhs, const T& rhs) {
+    return lhs = lhs * rhs;
+  }
 };
 
+// a / b, a /= b.
+template <class T>
+class Divisible {
+ public:
+  friend constexpr T operator/(const T& lhs, const T& rhs) {
+    return internal::Wrap<T>(lhs.value() / rhs.value());
+  }
+  friend constexpr T& operator/=(T& lhs, const T& rhs) {
+    return lhs = lhs / rhs;
+  }
+};
+
+// a % b, a %= b.
+template <class T>
+class Modulable {
+ public:
+  friend constexpr T operator%(const T& lhs, const T& rhs) {
+    return internal::Wrap<T>(lhs.value() % rhs.value());
+  }
+  friend constexpr T& operator%=(T& lhs, const T& rhs) {
+    return lhs = lhs % rhs;
+  }
+};
+
+// -a, +a.
+template <class T>
+class Negatable {
+ public:
+  friend constexpr T operator-(const T& x) {
+    return internal::Wrap<T>(-x.value());
+  }
+  friend constexpr T operator+(const T& x) { return x; }
+};
+
+// ++a, a++.
+template <class T>
+class Incrementable {
+ public:
+  friend constexpr T& operator++(T& x) {
+    return x = internal::Wrap<T>(x.value() + 1);
+  }
+  friend constexpr T operator++(T& x, int) {
+    const auto old = x;
+    ++x;
+    return old;
+  }
+};
+
+// --a, a--.
+template <class T>
+class Decrementable {
+ public:
+  friend constexpr T& operator--(T& x) {
+    return x = internal::Wrap<T>(x.value() - 1);
+  }
+  friend constexpr T operator--(T& x, int) {
+    const auto old = x;
+    --x;
+    return old;
+  }
+};
+
+// All of the above.
+template <class T>
+class RST_TYPE_EMPTY_BASES Arithmetic : public Addable<T>,
+                                        public Subtractable<T>,
+                                        public Multipliable<T>,
+                                        public Divisible<T>,
+                                        public Modulable<T>,
+                                        public Negatable<T>,
+                                        public Incrementable<T>,
+                                        public Decrementable<T> {};
+
+// a & b, a | b, a ^ b, ~a and the compound assignments.
+template <class T>
+class Bitwise {
+ public:
+  friend constexpr T operator&(const T& lhs, const T& rhs) {
+    return internal::Wrap<T>(lhs.value() & rhs.value());
+  }
+  friend constexpr T operator|(const T& lhs, const T& rhs) {
+    return internal::Wrap<T>(lhs.value() | rhs.value());
+  }
+  friend constexpr T operator^(const T& lhs, const T& rhs) {
+    return internal::Wrap<T>(lhs.value() ^ rhs.value());
+  }
+  friend constexpr T operator~(const T& x) {
+    return internal::Wrap<T>(~x.value());
+  }
+  friend constexpr T& operator&=(T& lhs, const T& rhs) {
+    return lhs = lhs & rhs;
+  }
+  friend constexpr T& operator|=(T& lhs, const T& rhs) {
+    return lhs = lhs | rhs;
+  }
+  friend constexpr T& operator^=(T& lhs, const T& rhs) {
+    return lhs = lhs ^ rhs;
+  }
+};
+
+// a << n, a >> n and the compound assignments.
+template <class T>
+class Shiftable {
+ public:
+  friend constexpr T operator<<(const T& x, const int n) {
+    return internal::Wrap<T>(x.value() << n);
+  }
+  friend constexpr T operator>>(const T& x, const int n) {
+    return internal::Wrap<T>(x.value() >> n);
+  }
+  friend constexpr T& operator<<=(T& x, const int n) { return x = x << n; }
+  friend constexpr T& operator>>=(T& x, const int n) { return x = x >> n; }
+};
+
+// Makes std::hash mix the bits of the underlying hash. std::hash of integers
+// is usually the identity, which is the fastest choice for std::unordered_map
+// with prime bucket counts, but clusters sequential or strided IDs in hash
+// tables with power of two sizes.
+template <class T>
+class StrongHash {};
+
 }  // namespace rst
 
 namespace std {
 
-template <class TagType, class UnderlyingType>
-struct hash<rst::Type<TagType, UnderlyingType>> {
-  size_t operator()(const rst::Type<TagType, UnderlyingType>& type) const {
-    return std::hash<UnderlyingType>()(type.value());
+template <class TagType, class UnderlyingType,
+          template <class> class... Skills>
+struct hash<rst::Type<TagType, UnderlyingType, Skills...>> {
+  using Type = rst::Type<TagType, UnderlyingType, Skills...>;
+
+  size_t operator()(const Type& type) const {
+    if constexpr (std::is_base_of<rst::StrongHash<Type>, Type>::value) {
+      uint64_t x = 0;
+      if constexpr (std::is_integral<UnderlyingType>::value ||
+                    std::is_enum<UnderlyingType>::value) {
+        x = static_cast<uint64_t>(type.value());
+      } else {
+        x = std::hash<UnderlyingType>()(type.value());
+      }
+      return static_cast<size_t>(rst::internal::HashMix(x));
+    } else {
+      return std::hash<UnderlyingType>()(type.value());
+    }
   }
 };
 
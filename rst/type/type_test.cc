@@ -31,6 +31,7 @@
 #include <cstdint>
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <type_traits>
 #include <unordered_map>
@@ -156,6 +157,127 @@ TEST(TypeTest, TrivialTypeIsStandardLayout) {
                 "int-based type should be trivially copyable. ");
 }
 
+TEST(TypeTest, TrivialTypeWithSkillsIsTriviallyCopyable) {
+  using FooType = Type<class FooTag, int, Arithmetic, Bitwise, Shiftable>;
+  static_assert(sizeof(FooType) == sizeof(int));
+  static_assert(std::is_standard_layout<FooType>::value);
+  static_assert(std::is_trivially_copyable<FooType>::value);
+  static_assert(std::is_trivially_destructible<FooType>::value);
+}
+
+TYPED_TEST(TypeTest, DefaultConstructedIsValueInitialized) {
+  using FooType = Type<class FooTag, TypeParam>;
+  EXPECT_EQ(FooType().value(), TypeParam());
+}
+
+TEST(TypeTest, IsConstexpr) {
+  using FooType = Type<class FooTag, int, Addable>;
+  constexpr FooType a(1);
+  constexpr FooType b(2);
+  static_assert(a.value() == 1);
+  static_assert(static_cast<int>(b) == 2);
+  static_assert(a < b);
+  static_assert(a + b == FooType(3));
+  static_assert(FooType().value() == 0);
+}
+
+TEST(TypeTest, Arithmetic) {
+  using FooType = Type<class FooTag, int, Arithmetic>;
+
+  FooType a(7);
+  const FooType b(2);
+  EXPECT_EQ(a + b, FooType(9));
+  EXPECT_EQ(a - b, FooType(5));
+  EXPECT_EQ(a * b, FooType(14));
+  EXPECT_EQ(a / b, FooType(3));
+  EXPECT_EQ(a % b, FooType(1));
+  EXPECT_EQ(-a, FooType(-7));
+  EXPECT_EQ(+a, FooType(7));
+
+  a += b;
+  EXPECT_EQ(a, FooType(9));
+  a -= b;
+  EXPECT_EQ(a, FooType(7));
+  a *= b;
+  EXPECT_EQ(a, FooType(14));
+  a /= b;
+  EXPECT_EQ(a, FooType(7));
+  a %= b;
+  EXPECT_EQ(a, FooType(1));
+
+  EXPECT_EQ(++a, FooType(2));
+  EXPECT_EQ(a++, FooType(2));
+  EXPECT_EQ(a, FooType(3));
+  EXPECT_EQ(--a, FooType(2));
+  EXPECT_EQ(a--, FooType(2));
+  EXPECT_EQ(a, FooType(1));
+}
+
+TEST(TypeTest, SkillsArePerType) {
+  using FooType = Type<class FooTag, std::string, Addable>;
+  EXPECT_EQ(FooType("a") + FooType("b"), FooType("ab"));
+
+  using BarType = Type<class BarTag, uint8_t, Incrementable>;
+  BarType x(254);
+  ++x;
+  EXPECT_EQ(x, BarType(255));
+  ++x;
+  EXPECT_EQ(x, BarType(0));
+}
+
+TEST(TypeTest, Bitwise) {
+  using FooType = Type<class FooTag, uint8_t, Bitwise, Shiftable>;
+
+  FooType a(0b1100);
+  const FooType b(0b1010);
+  EXPECT_EQ(a & b, FooType(0b1000));
+  EXPECT_EQ(a | b, FooType(0b1110));
+  EXPECT_EQ(a ^ b, FooType(0b0110));
+  EXPECT_EQ(~a, FooType(0b11110011));
+  EXPECT_EQ(a << 1, FooType(0b11000));
+  EXPECT_EQ(a >> 2, FooType(0b11));
+
+  a &= b;
+  EXPECT_EQ(a, FooType(0b1000));
+  a |= FooType(0b1);
+  EXPECT_EQ(a, FooType(0b1001));
+  a ^= FooType(0b1);
+  EXPECT_EQ(a, FooType(0b1000));
+  a <<= 1;
+  EXPECT_EQ(a, FooType(0b10000));
+  a >>= 4;
+  EXPECT_EQ(a, FooType(0b1));
+}
+
+TEST(TypeTest, StrongHashMixesBits) {
+  using FooType = Type<class FooTag, uint64_t, StrongHash>;
+  const std::hash<FooType> hash;
+
+  // Sequential IDs shouldn't map to sequential buckets.
+  std::set<size_t> low_bits;
+  for (uint64_t i = 1; i <= 64; i++) {
+    EXPECT_NE(hash(FooType(i)), i);
+    low_bits.insert(hash(FooType(i)) & 0xff);
+  }
+  EXPECT_GT(low_bits.size(), 32u);
+
+  EXPECT_EQ(hash(FooType(42)), hash(FooType(42)));
+
+  enum class Enum { kA, kB };
+  using EnumType = Type<class EnumTag, Enum, StrongHash>;
+  EXPECT_NE(std::hash<EnumType>()(EnumType(Enum::kA)),
+            std::hash<EnumType>()(EnumType(Enum::kB)));
+
+  using StringType = Type<class StringTag, std::string, StrongHash>;
+  EXPECT_NE(std::hash<StringType>()(StringType("a")),
+            std::hash<std::string>()("a"));
+}
+
+TEST(TypeTest, HashForwardsToUnderlyingType) {
+  using FooType = Type<class FooTag, uint64_t>;
+  EXPECT_EQ(std::hash<FooType>()(FooType(42)), std::hash<uint64_t>()(42));
+}
+
 TYPED_TEST(TypeTest, CannotBeCreatedFromDifferentType) {
   using FooType = Type<class FooTag, TypeParam>;
   using BarType = Type<class BarTag, TypeParam>;